@@ -0,0 +1,590 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "BMBase64.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+# define BMBASE64_X86 1
+# include <cpuid.h>
+# include <immintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+# define BMBASE64_NEON 1
+# include <arm_neon.h>
+#endif
+
+
+#pragma mark -
+#pragma mark Tables
+
+
+static const uint8_t BMBase64DecodingTable[256] =
+{
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 64, 64, 65, 64, 64, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	64, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 62, 65, 65, 65, 63,
+	52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 65, 65, 65, 65, 65, 65,
+	65,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+	15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 65, 65, 65, 65, 65,
+	65, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+	41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65
+};
+
+static const char BMBase64EncodingTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+
+#pragma mark -
+#pragma mark Scalar Kernels
+
+
+// The kernels only process complete 3 byte groups (encoding) or complete
+// quartets of non-whitespace alphabet characters (decoding). Everything else
+// (padding, whitespace, invalid characters and the final partial group) is
+// left to the generic code below, so all kernels produce identical output.
+
+static size_t BMBase64EncodeScalar(const uint8_t **bytes, size_t length, char **buffer)
+{
+    const uint8_t *in = *bytes;
+    char *out = *buffer;
+    size_t n = length / 3;
+    for (size_t i = 0; i < n; ++i, in += 3, out += 4) {
+        out[0] = BMBase64EncodingTable[in[0] >> 2];
+        out[1] = BMBase64EncodingTable[((in[0] & 0x03) << 4) | (in[1] >> 4)];
+        out[2] = BMBase64EncodingTable[((in[1] & 0x0f) << 2) | (in[2] >> 6)];
+        out[3] = BMBase64EncodingTable[in[2] & 0x3f];
+    }
+    *bytes = in;
+    *buffer = out;
+    return n * 3;
+}
+
+
+static size_t BMBase64DecodeScalar(const uint8_t **string, size_t length, uint8_t **buffer, size_t capacity)
+{
+    const uint8_t *in = *string;
+    uint8_t *out = *buffer;
+    size_t n = 0;
+    (void)capacity;
+    for (; length - n >= 4; n += 4, in += 4, out += 3) {
+        unsigned a = BMBase64DecodingTable[in[0]];
+        unsigned b = BMBase64DecodingTable[in[1]];
+        unsigned c = BMBase64DecodingTable[in[2]];
+        unsigned d = BMBase64DecodingTable[in[3]];
+        if ((a | b | c | d) & 0x40) {
+            break;
+        }
+        out[0] = (uint8_t)((a << 2) | (b >> 4));
+        out[1] = (uint8_t)((b << 4) | (c >> 2));
+        out[2] = (uint8_t)((c << 6) | d);
+    }
+    *string = in;
+    *buffer = out;
+    return n;
+}
+
+
+#pragma mark -
+#pragma mark x86 Kernels
+
+
+#ifdef BMBASE64_X86
+
+__attribute__((target("ssse3")))
+static inline __m128i BMBase64EncodeTranslateSSSE3(__m128i in)
+{
+    // Split the 12 input bytes into 16 6-bit indices
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+    __m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+    __m128i indices = _mm_or_si128(t0, t1);
+    
+    // Map the indices to ASCII, see BMBase64EncodingTable
+    __m128i offsets = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    offsets = _mm_or_si128(offsets, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+    const __m128i shifts = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                         '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(_mm_shuffle_epi8(shifts, offsets), indices);
+}
+
+
+__attribute__((target("ssse3")))
+static size_t BMBase64EncodeSSSE3(const uint8_t **bytes, size_t length, char **buffer)
+{
+    const uint8_t *in = *bytes;
+    char *out = *buffer;
+    size_t n = 0;
+    for (; length - n >= 16; n += 12, in += 12, out += 16) {
+        _mm_storeu_si128((__m128i *)out, BMBase64EncodeTranslateSSSE3(_mm_loadu_si128((const __m128i *)in)));
+    }
+    *bytes = in;
+    *buffer = out;
+    return n + BMBase64EncodeScalar(bytes, length - n, buffer);
+}
+
+
+__attribute__((target("avx2")))
+static size_t BMBase64EncodeAVX2(const uint8_t **bytes, size_t length, char **buffer)
+{
+    const uint8_t *in = *bytes;
+    char *out = *buffer;
+    size_t n = 0;
+    const __m256i shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                            10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m256i shifts = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                                            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    for (; length - n >= 32; n += 24, in += 24, out += 32) {
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)in)),
+                                            _mm_loadu_si128((const __m128i *)(in + 12)), 1);
+        v = _mm256_shuffle_epi8(v, shuffle);
+        __m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+        __m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+        __m256i indices = _mm256_or_si256(t0, t1);
+        __m256i offsets = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        offsets = _mm256_or_si256(offsets, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+        _mm256_storeu_si256((__m256i *)out, _mm256_add_epi8(_mm256_shuffle_epi8(shifts, offsets), indices));
+    }
+    *bytes = in;
+    *buffer = out;
+    return n + BMBase64EncodeSSSE3(bytes, length - n, buffer);
+}
+
+
+__attribute__((target("ssse3")))
+static size_t BMBase64DecodeSSSE3(const uint8_t **string, size_t length, uint8_t **buffer, size_t capacity)
+{
+    const uint8_t *in = *string;
+    uint8_t *out = *buffer;
+    size_t n = 0;
+    const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                         0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                         0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_2f = _mm_set1_epi8(0x2f);
+    // Every iteration stores 16 bytes but only advances by 12
+    for (; length - n >= 16 && capacity >= 16; n += 16, in += 16, out += 12, capacity -= 12) {
+        __m128i v = _mm_loadu_si128((const __m128i *)in);
+        __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(v, 4), mask_2f);
+        __m128i lo_nibbles = _mm_and_si128(v, mask_2f);
+        __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+        __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()))) {
+            // Whitespace, padding or invalid characters, leave them to the generic code
+            break;
+        }
+        __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(v, mask_2f), hi_nibbles));
+        v = _mm_add_epi8(v, roll);
+        v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+        v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+        v = _mm_shuffle_epi8(v, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storeu_si128((__m128i *)out, v);
+    }
+    *string = in;
+    *buffer = out;
+    return n + BMBase64DecodeScalar(string, length - n, buffer, capacity);
+}
+
+
+__attribute__((target("avx2")))
+static size_t BMBase64DecodeAVX2(const uint8_t **string, size_t length, uint8_t **buffer, size_t capacity)
+{
+    const uint8_t *in = *string;
+    uint8_t *out = *buffer;
+    size_t n = 0;
+    const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                            0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+                                            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                            0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                              0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+    // Every iteration stores 32 bytes but only advances by 24
+    for (; length - n >= 32 && capacity >= 32; n += 32, in += 32, out += 24, capacity -= 24) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)in);
+        __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(v, 4), mask_2f);
+        __m256i lo_nibbles = _mm256_and_si256(v, mask_2f);
+        __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+        if (_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256()))) {
+            break;
+        }
+        __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(v, mask_2f), hi_nibbles));
+        v = _mm256_add_epi8(v, roll);
+        v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+        v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+        _mm256_storeu_si256((__m256i *)out, v);
+    }
+    *string = in;
+    *buffer = out;
+    return n + BMBase64DecodeSSSE3(string, length - n, buffer, capacity);
+}
+
+
+static bool BMBase64CPUSupportsAVX2(void)
+{
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return false;
+    }
+    // Make sure the OS saves the YMM registers on context switches
+    uint32_t xcr0lo, xcr0hi;
+    __asm__ __volatile__ ("xgetbv" : "=a" (xcr0lo), "=d" (xcr0hi) : "c" (0));
+    if ((xcr0lo & 0x6) != 0x6) {
+        return false;
+    }
+    return __get_cpuid_max(0, NULL) >= 7 && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_AVX2);
+}
+
+
+static bool BMBase64CPUSupportsSSSE3(void)
+{
+    unsigned eax, ebx, ecx, edx;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSSE3);
+}
+
+#endif /* BMBASE64_X86 */
+
+
+#pragma mark -
+#pragma mark NEON Kernels
+
+
+#ifdef BMBASE64_NEON
+
+static inline uint8x16_t BMBase64EncodeTranslateNEON(uint8x16_t indices)
+{
+    // Map the indices to ASCII, see BMBase64EncodingTable
+    uint8x16_t result = vaddq_u8(indices, vdupq_n_u8('A'));
+    result = vbslq_u8(vcgeq_u8(indices, vdupq_n_u8(26)), vaddq_u8(indices, vdupq_n_u8('a' - 26)), result);
+    result = vbslq_u8(vcgeq_u8(indices, vdupq_n_u8(52)), vsubq_u8(indices, vdupq_n_u8(52 - '0')), result);
+    result = vbslq_u8(vceqq_u8(indices, vdupq_n_u8(62)), vdupq_n_u8('+'), result);
+    result = vbslq_u8(vceqq_u8(indices, vdupq_n_u8(63)), vdupq_n_u8('/'), result);
+    return result;
+}
+
+
+static size_t BMBase64EncodeNEON(const uint8_t **bytes, size_t length, char **buffer)
+{
+    const uint8_t *in = *bytes;
+    char *out = *buffer;
+    size_t n = 0;
+    const uint8x16_t mask = vdupq_n_u8(0x3f);
+    for (; length - n >= 48; n += 48, in += 48, out += 64) {
+        uint8x16x3_t v = vld3q_u8(in);
+        uint8x16x4_t r;
+        r.val[0] = vshrq_n_u8(v.val[0], 2);
+        r.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(v.val[0], 4), vshrq_n_u8(v.val[1], 4)), mask);
+        r.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(v.val[1], 2), vshrq_n_u8(v.val[2], 6)), mask);
+        r.val[3] = vandq_u8(v.val[2], mask);
+        r.val[0] = BMBase64EncodeTranslateNEON(r.val[0]);
+        r.val[1] = BMBase64EncodeTranslateNEON(r.val[1]);
+        r.val[2] = BMBase64EncodeTranslateNEON(r.val[2]);
+        r.val[3] = BMBase64EncodeTranslateNEON(r.val[3]);
+        vst4q_u8((uint8_t *)out, r);
+    }
+    *bytes = in;
+    *buffer = out;
+    return n + BMBase64EncodeScalar(bytes, length - n, buffer);
+}
+
+
+static inline uint8x16_t BMBase64DecodeTranslateNEON(uint8x16_t c, uint8x16_t *invalid)
+{
+    uint8x16_t upper = vcltq_u8(vsubq_u8(c, vdupq_n_u8('A')), vdupq_n_u8(26));
+    uint8x16_t lower = vcltq_u8(vsubq_u8(c, vdupq_n_u8('a')), vdupq_n_u8(26));
+    uint8x16_t digit = vcltq_u8(vsubq_u8(c, vdupq_n_u8('0')), vdupq_n_u8(10));
+    uint8x16_t plus = vceqq_u8(c, vdupq_n_u8('+'));
+    uint8x16_t slash = vceqq_u8(c, vdupq_n_u8('/'));
+    uint8x16_t result = vandq_u8(upper, vsubq_u8(c, vdupq_n_u8('A')));
+    result = vorrq_u8(result, vandq_u8(lower, vsubq_u8(c, vdupq_n_u8('a' - 26))));
+    result = vorrq_u8(result, vandq_u8(digit, vaddq_u8(c, vdupq_n_u8(52 - '0'))));
+    result = vorrq_u8(result, vandq_u8(plus, vdupq_n_u8(62)));
+    result = vorrq_u8(result, vandq_u8(slash, vdupq_n_u8(63)));
+    *invalid = vorrq_u8(*invalid, vmvnq_u8(vorrq_u8(vorrq_u8(upper, lower), vorrq_u8(digit, vorrq_u8(plus, slash)))));
+    return result;
+}
+
+
+static size_t BMBase64DecodeNEON(const uint8_t **string, size_t length, uint8_t **buffer, size_t capacity)
+{
+    const uint8_t *in = *string;
+    uint8_t *out = *buffer;
+    size_t n = 0;
+    for (; length - n >= 64 && capacity >= 48; n += 64, in += 64, out += 48, capacity -= 48) {
+        uint8x16x4_t v = vld4q_u8(in);
+        uint8x16_t invalid = vdupq_n_u8(0);
+        uint8x16_t a = BMBase64DecodeTranslateNEON(v.val[0], &invalid);
+        uint8x16_t b = BMBase64DecodeTranslateNEON(v.val[1], &invalid);
+        uint8x16_t c = BMBase64DecodeTranslateNEON(v.val[2], &invalid);
+        uint8x16_t d = BMBase64DecodeTranslateNEON(v.val[3], &invalid);
+        uint8x8_t folded = vorr_u8(vget_low_u8(invalid), vget_high_u8(invalid));
+        if (vget_lane_u32(vreinterpret_u32_u8(vpmax_u8(folded, folded)), 0)) {
+            // Whitespace, padding or invalid characters, leave them to the generic code
+            break;
+        }
+        uint8x16x3_t r;
+        r.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+        r.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(c, 2));
+        r.val[2] = vorrq_u8(vshlq_n_u8(c, 6), d);
+        vst3q_u8(out, r);
+    }
+    *string = in;
+    *buffer = out;
+    return n + BMBase64DecodeScalar(string, length - n, buffer, capacity);
+}
+
+#endif /* BMBASE64_NEON */
+
+
+#pragma mark -
+#pragma mark Kernel Selection
+
+
+typedef size_t (*BMBase64EncodeKernel)(const uint8_t **bytes, size_t length, char **buffer);
+typedef size_t (*BMBase64DecodeKernel)(const uint8_t **string, size_t length, uint8_t **buffer, size_t capacity);
+
+static BMBase64EncodeKernel BMBase64Encoder = BMBase64EncodeScalar;
+static BMBase64DecodeKernel BMBase64Decoder = BMBase64DecodeScalar;
+static pthread_once_t       BMBase64KernelsOnce = PTHREAD_ONCE_INIT;
+
+
+static void BMBase64SelectKernels(void)
+{
+#if defined(BMBASE64_X86)
+    if (BMBase64CPUSupportsAVX2()) {
+        BMBase64Encoder = BMBase64EncodeAVX2;
+        BMBase64Decoder = BMBase64DecodeAVX2;
+    }
+    else if (BMBase64CPUSupportsSSSE3()) {
+        BMBase64Encoder = BMBase64EncodeSSSE3;
+        BMBase64Decoder = BMBase64DecodeSSSE3;
+    }
+#elif defined(BMBASE64_NEON)
+    BMBase64Encoder = BMBase64EncodeNEON;
+    BMBase64Decoder = BMBase64DecodeNEON;
+#endif
+}
+
+
+#pragma mark -
+#pragma mark Generic Decoding
+
+
+static bool BMBase64DecodeWithCapacity(BMBase64DecodeState *state, const char *string, size_t length, void *buffer, size_t capacity, size_t *decodedLength)
+{
+    const uint8_t *str = (const uint8_t *)string;
+    const uint8_t *end = str + length;
+    uint8_t *data = (uint8_t *)buffer;
+    uint8_t *dataEnd = data + capacity;
+    unsigned c, i = state->phase, partial = state->partial;
+    pthread_once(&BMBase64KernelsOnce, BMBase64SelectKernels);
+    while (str < end) {
+        if (i == 0) {
+            // Decode as many complete quartets as possible in one go
+            BMBase64Decoder(&str, end - str, &data, dataEnd - data);
+            if (str == end) {
+                break;
+            }
+        }
+        c = *str++;
+        if (c == '=') {
+            // Padding is skipped, except after the first character of a
+            // quartet, where it can never be valid
+            if (i == 1) {
+                return false;
+            }
+            continue;
+        }
+        c = BMBase64DecodingTable[c];
+        if (c == 64) { // 64 identifies whitespace, just skip
+            continue;
+        }
+        if (c == 65) { // 65 identifies an invalid character
+            return false;
+        }
+        switch (i) {
+            case 0:
+                partial = c << 2;
+                break;
+                
+            case 1:
+                *data++ = (uint8_t)(partial | (c >> 4));
+                partial = (c & 0x0f) << 4;
+                break;
+                
+            case 2:
+                *data++ = (uint8_t)(partial | (c >> 2));
+                partial = (c & 0x03) << 6;
+                break;
+                
+            case 3:
+                *data++ = (uint8_t)(partial | c);
+                break;
+        }
+        i = (i + 1) % 4;
+    }
+    state->phase = i;
+    state->partial = partial;
+    *decodedLength = data - (uint8_t *)buffer;
+    return true;
+}
+
+
+#pragma mark -
+#pragma mark Encoding and Decoding
+
+
+size_t BMBase64EncodedLength(size_t length)
+{
+    return ((length + 2) / 3) * 4;
+}
+
+
+size_t BMBase64DecodedMaxLength(size_t length)
+{
+    return (length / 4) * 3 + ((length % 4) * 3) / 4;
+}
+
+
+size_t BMBase64Encode(const void *bytes, size_t length, char *buffer)
+{
+    BMBase64EncodeState state;
+    BMBase64EncodeInit(&state);
+    size_t bufferLength = BMBase64EncodeUpdate(&state, bytes, length, buffer);
+    return bufferLength + BMBase64EncodeFinal(&state, buffer + bufferLength);
+}
+
+
+bool BMBase64Decode(const char *string, size_t length, void *buffer, size_t *decodedLength)
+{
+    BMBase64DecodeState state;
+    BMBase64DecodeInit(&state);
+    return BMBase64DecodeWithCapacity(&state, string, length, buffer, BMBase64DecodedMaxLength(length), decodedLength);
+}
+
+
+#pragma mark -
+#pragma mark Incremental Encoding and Decoding
+
+
+void BMBase64EncodeInit(BMBase64EncodeState *state)
+{
+    state->length = 0;
+}
+
+
+size_t BMBase64EncodeUpdateMaxLength(size_t length)
+{
+    // Up to two bytes may be carried over from the previous update
+    return ((length + 2) / 3) * 4;
+}
+
+
+size_t BMBase64EncodeUpdate(BMBase64EncodeState *state, const void *bytes, size_t length, char *buffer)
+{
+    const uint8_t *data = (const uint8_t *)bytes;
+    char *bufptr = buffer;
+    pthread_once(&BMBase64KernelsOnce, BMBase64SelectKernels);
+    if (state->length) {
+        // Complete the group carried over from the previous update
+        while (state->length < 3 && length) {
+            state->bytes[state->length++] = *data++;
+            length--;
+        }
+        if (state->length < 3) {
+            return 0;
+        }
+        const uint8_t *group = state->bytes;
+        BMBase64EncodeScalar(&group, 3, &bufptr);
+        state->length = 0;
+    }
+    length -= BMBase64Encoder(&data, length, &bufptr);
+    memcpy(state->bytes, data, length);
+    state->length = (unsigned)length;
+    return bufptr - buffer;
+}
+
+
+size_t BMBase64EncodeFinal(BMBase64EncodeState *state, char *buffer)
+{
+    const uint8_t *data = state->bytes;
+    char *bufptr = buffer;
+    if (state->length) {
+        *bufptr++ = BMBase64EncodingTable[data[0] >> 2];
+        if (state->length > 1) {
+            *bufptr++ = BMBase64EncodingTable[((data[0] & 0x03) << 4) | (data[1] >> 4)];
+            *bufptr++ = BMBase64EncodingTable[(data[1] & 0x0f) << 2];
+        }
+        else {
+            *bufptr++ = BMBase64EncodingTable[(data[0] & 0x03) << 4];
+            *bufptr++ = '=';
+        }
+        *bufptr++ = '=';
+    }
+    state->length = 0;
+    return bufptr - buffer;
+}
+
+
+void BMBase64DecodeInit(BMBase64DecodeState *state)
+{
+    state->phase = 0;
+    state->partial = 0;
+}
+
+
+size_t BMBase64DecodeUpdateMaxLength(size_t length)
+{
+    // Up to three characters may be carried over from the previous update
+    return BMBase64DecodedMaxLength(length + 3);
+}
+
+
+bool BMBase64DecodeUpdate(BMBase64DecodeState *state, const char *string, size_t length, void *buffer, size_t *decodedLength)
+{
+    return BMBase64DecodeWithCapacity(state, string, length, buffer, BMBase64DecodeUpdateMaxLength(length), decodedLength);
+}
@@ -0,0 +1,84 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __BMBASE64__
+#define __BMBASE64__
+
+#include <sys/cdefs.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+__BEGIN_DECLS
+
+/** Returns the number of characters required to Base64-encode _length_ bytes. */
+extern size_t BMBase64EncodedLength(size_t length);
+
+/** Returns an upper bound for the number of bytes produced by decoding _length_ Base64 characters. */
+extern size_t BMBase64DecodedMaxLength(size_t length);
+
+/** Base64-encodes _length_ bytes from _bytes_ into _buffer_, which must hold at least `BMBase64EncodedLength(length)` characters, and returns the number of characters written. */
+extern size_t BMBase64Encode(const void *bytes, size_t length, char *buffer);
+
+/** Decodes _length_ Base64 characters from _string_ into _buffer_, which must hold at least `BMBase64DecodedMaxLength(length)` bytes. Whitespace is skipped. Returns `false` if _string_ contains an invalid character, otherwise stores the number of decoded bytes in _decodedLength_ and returns `true`. */
+extern bool BMBase64Decode(const char *string, size_t length, void *buffer, size_t *decodedLength);
+
+/** State of an incremental Base64 encoding. */
+typedef struct _BMBase64EncodeState {
+    unsigned char bytes[3];
+    unsigned      length;
+} BMBase64EncodeState;
+
+/** Initializes _state_ for a new incremental Base64 encoding. */
+extern void BMBase64EncodeInit(BMBase64EncodeState *state);
+
+/** Returns the number of characters a single `BMBase64EncodeUpdate` call with _length_ bytes may produce at most. */
+extern size_t BMBase64EncodeUpdateMaxLength(size_t length);
+
+/** Base64-encodes the next _length_ bytes from _bytes_ into _buffer_, which must hold at least `BMBase64EncodeUpdateMaxLength(length)` characters. Up to two trailing bytes are kept in _state_ until the next update. Returns the number of characters written. */
+extern size_t BMBase64EncodeUpdate(BMBase64EncodeState *state, const void *bytes, size_t length, char *buffer);
+
+/** Writes the final, padded quartet for the bytes kept in _state_ (if any) into _buffer_, which must hold at least 4 characters. Returns the number of characters written. */
+extern size_t BMBase64EncodeFinal(BMBase64EncodeState *state, char *buffer);
+
+/** State of an incremental Base64 decoding. */
+typedef struct _BMBase64DecodeState {
+    unsigned phase;
+    unsigned partial;
+} BMBase64DecodeState;
+
+/** Initializes _state_ for a new incremental Base64 decoding. */
+extern void BMBase64DecodeInit(BMBase64DecodeState *state);
+
+/** Returns the number of bytes a single `BMBase64DecodeUpdate` call with _length_ characters may produce at most. */
+extern size_t BMBase64DecodeUpdateMaxLength(size_t length);
+
+/** Decodes the next _length_ Base64 characters from _string_ into _buffer_, which must hold at least `BMBase64DecodeUpdateMaxLength(length)` bytes. A partial quartet is kept in _state_ until the next update. Returns `false` if _string_ contains an invalid character, otherwise stores the number of decoded bytes in _decodedLength_ and returns `true`. */
+extern bool BMBase64DecodeUpdate(BMBase64DecodeState *state, const char *string, size_t length, void *buffer, size_t *decodedLength);
+
+__END_DECLS
+
+#endif /* !__BMBASE64__ */
@@ -0,0 +1,165 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+#include "BMBase64.h"
+#include "BMFileUtilities.h"
+
+
+/** You use a Base64 decoder to decode Base64-encoded input of arbitrary size in chunks, without ever holding the complete input or output in memory.
+ 
+ The decoder keeps the partial quartet at the end of each chunk until the next chunk arrives, so the chunks may have any size. Whitespace is skipped. The decoded bytes are either written into caller-supplied buffers or to an `NSOutputStream`. For input without NUL characters, the result is identical to the `initWithBase64EncodedString:` method of the `NSData` class for the concatenated input. That method stops decoding at the first NUL character, like it does for C strings, whereas the decoder treats NUL as an invalid character and fails.
+ 
+ @see BMBase64Encoder
+ */
+@interface BMBase64Decoder : NSObject {
+@private
+    BMBase64DecodeState  _state;
+    NSOutputStream      *_outputStream;
+    uint8_t             *_buffer;
+    BOOL                 _failed;
+}
+
+/** The output stream that receives the decoded bytes, or `nil` if the receiver decodes into caller-supplied buffers. */
+@property (nonatomic, retain, readonly) NSOutputStream *outputStream;
+
+///--------------------------------------
+/// @name Initializing a Base64 Decoder
+///--------------------------------------
+
+/** Initializes the receiver to decode into caller-supplied buffers.
+ 
+ @return The initialized receiver.
+ @see initWithOutputStream:
+ */
+- (id)init;
+
+/** Initializes the receiver to write the decoded bytes to an output stream.
+ 
+ The output stream must be opened before writing to the receiver.
+ 
+ @param anOutputStream The output stream that receives the decoded bytes.
+ @return The initialized receiver, or `nil` if *anOutputStream* is `nil`.
+ @see init
+ */
+- (id)initWithOutputStream:(NSOutputStream *)anOutputStream;
+
+///------------------------------
+/// @name Decoding into Buffers
+///------------------------------
+
+/** Returns the maximum number of bytes produced by decoding a chunk of the given length.
+ 
+ @param length The length of the chunk in characters.
+ @return The maximum number of bytes `decodeBytes:length:intoBuffer:decodedLength:` writes for *length* characters.
+ */
++ (NSUInteger)maximumLengthForDecodingLength:(NSUInteger)length;
+
+/** Decodes the next chunk of Base64 characters into a buffer.
+ 
+ @param bytes The Base64 characters to decode.
+ @param length The number of characters to decode.
+ @param buffer The buffer that receives the decoded bytes. It must be large enough to hold `maximumLengthForDecodingLength:` bytes.
+ @param decodedLength On return, the number of bytes written to *buffer*.
+ @return `YES` if the chunk was decoded successfully, `NO` if it contains an invalid character.
+ */
+- (BOOL)decodeBytes:(const char *)bytes length:(NSUInteger)length intoBuffer:(void *)buffer decodedLength:(NSUInteger *)decodedLength;
+
+///-------------------------------------
+/// @name Decoding into Output Streams
+///-------------------------------------
+
+/** Decodes the next chunk of Base64 characters and writes the decoded bytes to the output stream.
+ 
+ Once an invalid character was encountered, this method returns `NO` until `finishWriting` is sent to the receiver.
+ 
+ @param bytes The Base64 characters to decode.
+ @param length The number of characters to decode.
+ @return `YES` if the chunk was decoded and written successfully, `NO` otherwise.
+ @see writeData:
+ @see writeString:
+ @see finishWriting
+ */
+- (BOOL)writeBytes:(const char *)bytes length:(NSUInteger)length;
+
+/** Decodes the Base64 characters in the data object and writes the decoded bytes to the output stream.
+ 
+ @param data The Base64 characters to decode.
+ @return `YES` if the chunk was decoded and written successfully, `NO` otherwise.
+ @see writeBytes:length:
+ @see writeString:
+ @see finishWriting
+ */
+- (BOOL)writeData:(NSData *)data;
+
+/** Decodes the Base64 characters in the string and writes the decoded bytes to the output stream.
+ 
+ The string is converted to ASCII in small windows, so no copy of the complete string is made.
+ 
+ @param aString The Base64 characters to decode.
+ @return `YES` if the chunk was decoded and written successfully, `NO` otherwise.
+ @see writeBytes:length:
+ @see writeData:
+ @see finishWriting
+ */
+- (BOOL)writeString:(NSString *)aString;
+
+/** Decodes the contents of a file and writes the decoded bytes to the output stream.
+ 
+ Regular files are mapped into memory window by window instead of being read into memory as a whole, see `BMFileEnumerateWindows`.
+ 
+ @param path The path of the file to read.
+ @return `YES` if the file was read and the decoded bytes were written successfully, `NO` otherwise.
+ @see writeContentsOfFileDescriptor:
+ @see finishWriting
+ */
+- (BOOL)writeContentsOfFile:(NSString *)path;
+
+/** Decodes the contents of a file descriptor, from its current offset to its end, and writes the decoded bytes to the output stream.
+ 
+ Regular files are mapped into memory window by window instead of being read into memory as a whole, see `BMFileEnumerateWindows`.
+ 
+ @param fd The file descriptor to read.
+ @return `YES` if the file was read and the decoded bytes were written successfully, `NO` otherwise.
+ @see writeContentsOfFile:
+ @see finishWriting
+ */
+- (BOOL)writeContentsOfFileDescriptor:(int)fd;
+
+/** Finishes the current decoding, and resets the receiver for a new decoding.
+ 
+ @return `YES` if all chunks were decoded and written successfully, `NO` otherwise.
+ @see writeBytes:length:
+ @see writeData:
+ @see writeString:
+ @see writeContentsOfFile:
+ @see writeContentsOfFileDescriptor:
+ */
+- (BOOL)finishWriting;
+
+@end
@@ -0,0 +1,211 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#import "BMBase64Decoder.h"
+
+
+// Number of input characters decoded per output stream write
+#define BMBase64DecoderChunkLength ((NSUInteger)(64 * 1024))
+
+// Number of characters converted from an NSString at once
+#define BMBase64DecoderStringChunkLength ((NSUInteger)4096)
+
+
+static BOOL BMBase64DecoderWriteToStream(NSOutputStream *outputStream, const uint8_t *buffer, NSUInteger length)
+{
+    while (length) {
+        NSInteger written = [outputStream write:buffer maxLength:length];
+        if (written <= 0) {
+            return NO;
+        }
+        buffer += written;
+        length -= written;
+    }
+    return YES;
+}
+
+
+static bool BMBase64DecoderFileWindowFunction(const void *bytes, size_t length, void *context)
+{
+    return [(BMBase64Decoder *)context writeBytes:bytes length:length];
+}
+
+
+@implementation BMBase64Decoder
+
+@synthesize outputStream = _outputStream;
+
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        BMBase64DecodeInit(&_state);
+    }
+    return self;
+}
+
+
+- (id)initWithOutputStream:(NSOutputStream *)anOutputStream
+{
+    self = [self init];
+    if (self) {
+        _buffer = (uint8_t *)malloc(BMBase64DecodeUpdateMaxLength(BMBase64DecoderChunkLength));
+        if (!anOutputStream || !_buffer) {
+            [self release];
+            return nil;
+        }
+        _outputStream = [anOutputStream retain];
+    }
+    return self;
+}
+
+
+- (void)dealloc
+{
+    [_outputStream release], _outputStream = nil;
+    free(_buffer), _buffer = NULL;
+    [super dealloc];
+}
+
+
+#pragma mark -
+#pragma mark Decoding into Buffers
+
+
++ (NSUInteger)maximumLengthForDecodingLength:(NSUInteger)length
+{
+    return BMBase64DecodeUpdateMaxLength(length);
+}
+
+
+- (BOOL)decodeBytes:(const char *)bytes length:(NSUInteger)length intoBuffer:(void *)buffer decodedLength:(NSUInteger *)decodedLength
+{
+    size_t bufferLength = 0;
+    BOOL succeeded = BMBase64DecodeUpdate(&_state, bytes, length, buffer, &bufferLength);
+    if (decodedLength) {
+        *decodedLength = bufferLength;
+    }
+    return succeeded;
+}
+
+
+#pragma mark -
+#pragma mark Decoding into Output Streams
+
+
+- (BOOL)writeBytes:(const char *)bytes length:(NSUInteger)length
+{
+    if (!_outputStream) {
+        [NSException raise:NSInternalInconsistencyException
+                    format:@"no output stream (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    while (!_failed && length) {
+        NSUInteger chunkLength = MIN(length, BMBase64DecoderChunkLength);
+        size_t bufferLength = 0;
+        if (!BMBase64DecodeUpdate(&_state, bytes, chunkLength, _buffer, &bufferLength)
+            || !BMBase64DecoderWriteToStream(_outputStream, _buffer, bufferLength)) {
+            _failed = YES;
+        }
+        bytes += chunkLength;
+        length -= chunkLength;
+    }
+    return !_failed;
+}
+
+
+- (BOOL)writeData:(NSData *)data
+{
+    return [self writeBytes:[data bytes] length:[data length]];
+}
+
+
+- (BOOL)writeString:(NSString *)aString
+{
+    char chunk[BMBase64DecoderStringChunkLength];
+    NSRange range = NSMakeRange(0, [aString length]);
+    while (!_failed && range.length) {
+        NSUInteger usedLength = 0;
+        [aString getBytes:chunk
+                maxLength:sizeof(chunk)
+               usedLength:&usedLength
+                 encoding:NSASCIIStringEncoding
+                  options:0
+                    range:range
+           remainingRange:&range];
+        if (!usedLength) {
+            // The string contains non-ASCII characters
+            _failed = YES;
+        }
+        else {
+            [self writeBytes:chunk length:usedLength];
+        }
+    }
+    return !_failed;
+}
+
+
+- (BOOL)writeContentsOfFile:(NSString *)path
+{
+    if (!_outputStream) {
+        [NSException raise:NSInternalInconsistencyException
+                    format:@"no output stream (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    if (!_failed && (![path length] || !BMFileEnumerateWindowsAtPath([path fileSystemRepresentation], BMBase64DecoderFileWindowFunction, self))) {
+        _failed = YES;
+    }
+    return !_failed;
+}
+
+
+- (BOOL)writeContentsOfFileDescriptor:(int)fd
+{
+    if (!_outputStream) {
+        [NSException raise:NSInternalInconsistencyException
+                    format:@"no output stream (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    if (!_failed && !BMFileEnumerateWindows(fd, BMBase64DecoderFileWindowFunction, self)) {
+        _failed = YES;
+    }
+    return !_failed;
+}
+
+
+- (BOOL)finishWriting
+{
+    if (!_outputStream) {
+        [NSException raise:NSInternalInconsistencyException
+                    format:@"no output stream (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    BOOL succeeded = !_failed;
+    BMBase64DecodeInit(&_state);
+    _failed = NO;
+    return succeeded;
+}
+
+
+@end
@@ -0,0 +1,156 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+#include "BMBase64.h"
+#include "BMFileUtilities.h"
+
+
+/** You use a Base64 encoder to encode data of arbitrary size in chunks, without ever holding the complete input or output in memory.
+ 
+ The encoder keeps up to two trailing bytes of each chunk until the next chunk arrives, so the chunks may have any size. The encoded characters are either written into caller-supplied buffers or to an `NSOutputStream`. The result is identical to the `base64EncodedString` method of the `NSData` class for the concatenated input.
+ 
+ @see BMBase64Decoder
+ */
+@interface BMBase64Encoder : NSObject {
+@private
+    BMBase64EncodeState  _state;
+    NSOutputStream      *_outputStream;
+    char                *_buffer;
+    BOOL                 _failed;
+}
+
+/** The output stream that receives the encoded characters, or `nil` if the receiver encodes into caller-supplied buffers. */
+@property (nonatomic, retain, readonly) NSOutputStream *outputStream;
+
+///--------------------------------------
+/// @name Initializing a Base64 Encoder
+///--------------------------------------
+
+/** Initializes the receiver to encode into caller-supplied buffers.
+ 
+ @return The initialized receiver.
+ @see initWithOutputStream:
+ */
+- (id)init;
+
+/** Initializes the receiver to write the encoded characters to an output stream.
+ 
+ The output stream must be opened before writing to the receiver.
+ 
+ @param anOutputStream The output stream that receives the encoded characters.
+ @return The initialized receiver, or `nil` if *anOutputStream* is `nil`.
+ @see init
+ */
+- (id)initWithOutputStream:(NSOutputStream *)anOutputStream;
+
+///------------------------------
+/// @name Encoding into Buffers
+///------------------------------
+
+/** Returns the maximum number of characters produced by encoding a chunk of the given length.
+ 
+ @param length The length of the chunk in bytes.
+ @return The maximum number of characters `encodeBytes:length:intoBuffer:` writes for *length* bytes.
+ */
++ (NSUInteger)maximumLengthForEncodingLength:(NSUInteger)length;
+
+/** Encodes the next chunk of bytes into a buffer.
+ 
+ @param bytes The bytes to encode.
+ @param length The number of bytes to encode.
+ @param buffer The buffer that receives the encoded characters. It must be large enough to hold `maximumLengthForEncodingLength:` characters.
+ @return The number of characters written to *buffer*.
+ @see finishEncodingIntoBuffer:
+ */
+- (NSUInteger)encodeBytes:(const void *)bytes length:(NSUInteger)length intoBuffer:(char *)buffer;
+
+/** Writes the final, padded quartet into a buffer, and resets the receiver for a new encoding.
+ 
+ @param buffer The buffer that receives the encoded characters. It must be large enough to hold 4 characters.
+ @return The number of characters written to *buffer*.
+ @see encodeBytes:length:intoBuffer:
+ */
+- (NSUInteger)finishEncodingIntoBuffer:(char *)buffer;
+
+///-------------------------------------
+/// @name Encoding into Output Streams
+///-------------------------------------
+
+/** Encodes the next chunk of bytes and writes the encoded characters to the output stream.
+ 
+ @param bytes The bytes to encode.
+ @param length The number of bytes to encode.
+ @return `YES` if the encoded characters were written successfully, `NO` otherwise.
+ @see writeData:
+ @see finishWriting
+ */
+- (BOOL)writeBytes:(const void *)bytes length:(NSUInteger)length;
+
+/** Encodes the bytes of the data object and writes the encoded characters to the output stream.
+ 
+ @param data The data to encode.
+ @return `YES` if the encoded characters were written successfully, `NO` otherwise.
+ @see writeBytes:length:
+ @see finishWriting
+ */
+- (BOOL)writeData:(NSData *)data;
+
+/** Encodes the contents of a file and writes the encoded characters to the output stream.
+ 
+ Regular files are mapped into memory window by window instead of being read into memory as a whole, see `BMFileEnumerateWindows`.
+ 
+ @param path The path of the file to read.
+ @return `YES` if the file was read and the encoded characters were written successfully, `NO` otherwise.
+ @see writeContentsOfFileDescriptor:
+ @see finishWriting
+ */
+- (BOOL)writeContentsOfFile:(NSString *)path;
+
+/** Encodes the contents of a file descriptor, from its current offset to its end, and writes the encoded characters to the output stream.
+ 
+ Regular files are mapped into memory window by window instead of being read into memory as a whole, see `BMFileEnumerateWindows`.
+ 
+ @param fd The file descriptor to read.
+ @return `YES` if the file was read and the encoded characters were written successfully, `NO` otherwise.
+ @see writeContentsOfFile:
+ @see finishWriting
+ */
+- (BOOL)writeContentsOfFileDescriptor:(int)fd;
+
+/** Writes the final, padded quartet to the output stream, and resets the receiver for a new encoding.
+ 
+ @return `YES` if all encoded characters were written successfully, `NO` otherwise.
+ @see writeBytes:length:
+ @see writeData:
+ @see writeContentsOfFile:
+ @see writeContentsOfFileDescriptor:
+ */
+- (BOOL)finishWriting;
+
+@end
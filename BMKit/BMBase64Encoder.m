@@ -0,0 +1,184 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#import "BMBase64Encoder.h"
+
+
+// Number of input bytes encoded per output stream write
+#define BMBase64EncoderChunkLength ((NSUInteger)(48 * 1024))
+
+
+static BOOL BMBase64EncoderWriteToStream(NSOutputStream *outputStream, const char *buffer, NSUInteger length)
+{
+    while (length) {
+        NSInteger written = [outputStream write:(const uint8_t *)buffer maxLength:length];
+        if (written <= 0) {
+            return NO;
+        }
+        buffer += written;
+        length -= written;
+    }
+    return YES;
+}
+
+
+static bool BMBase64EncoderFileWindowFunction(const void *bytes, size_t length, void *context)
+{
+    return [(BMBase64Encoder *)context writeBytes:bytes length:length];
+}
+
+
+@implementation BMBase64Encoder
+
+@synthesize outputStream = _outputStream;
+
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        BMBase64EncodeInit(&_state);
+    }
+    return self;
+}
+
+
+- (id)initWithOutputStream:(NSOutputStream *)anOutputStream
+{
+    self = [self init];
+    if (self) {
+        _buffer = (char *)malloc(BMBase64EncodeUpdateMaxLength(BMBase64EncoderChunkLength));
+        if (!anOutputStream || !_buffer) {
+            [self release];
+            return nil;
+        }
+        _outputStream = [anOutputStream retain];
+    }
+    return self;
+}
+
+
+- (void)dealloc
+{
+    [_outputStream release], _outputStream = nil;
+    free(_buffer), _buffer = NULL;
+    [super dealloc];
+}
+
+
+#pragma mark -
+#pragma mark Encoding into Buffers
+
+
++ (NSUInteger)maximumLengthForEncodingLength:(NSUInteger)length
+{
+    return BMBase64EncodeUpdateMaxLength(length);
+}
+
+
+- (NSUInteger)encodeBytes:(const void *)bytes length:(NSUInteger)length intoBuffer:(char *)buffer
+{
+    return BMBase64EncodeUpdate(&_state, bytes, length, buffer);
+}
+
+
+- (NSUInteger)finishEncodingIntoBuffer:(char *)buffer
+{
+    return BMBase64EncodeFinal(&_state, buffer);
+}
+
+
+#pragma mark -
+#pragma mark Encoding into Output Streams
+
+
+- (BOOL)writeBytes:(const void *)bytes length:(NSUInteger)length
+{
+    if (!_outputStream) {
+        [NSException raise:NSInternalInconsistencyException
+                    format:@"no output stream (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    const uint8_t *data = (const uint8_t *)bytes;
+    while (!_failed && length) {
+        NSUInteger chunkLength = MIN(length, BMBase64EncoderChunkLength);
+        NSUInteger bufferLength = BMBase64EncodeUpdate(&_state, data, chunkLength, _buffer);
+        if (!BMBase64EncoderWriteToStream(_outputStream, _buffer, bufferLength)) {
+            _failed = YES;
+        }
+        data += chunkLength;
+        length -= chunkLength;
+    }
+    return !_failed;
+}
+
+
+- (BOOL)writeData:(NSData *)data
+{
+    return [self writeBytes:[data bytes] length:[data length]];
+}
+
+
+- (BOOL)writeContentsOfFile:(NSString *)path
+{
+    if (!_outputStream) {
+        [NSException raise:NSInternalInconsistencyException
+                    format:@"no output stream (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    if (!_failed && (![path length] || !BMFileEnumerateWindowsAtPath([path fileSystemRepresentation], BMBase64EncoderFileWindowFunction, self))) {
+        _failed = YES;
+    }
+    return !_failed;
+}
+
+
+- (BOOL)writeContentsOfFileDescriptor:(int)fd
+{
+    if (!_outputStream) {
+        [NSException raise:NSInternalInconsistencyException
+                    format:@"no output stream (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    if (!_failed && !BMFileEnumerateWindows(fd, BMBase64EncoderFileWindowFunction, self)) {
+        _failed = YES;
+    }
+    return !_failed;
+}
+
+
+- (BOOL)finishWriting
+{
+    if (!_outputStream) {
+        [NSException raise:NSInternalInconsistencyException
+                    format:@"no output stream (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    NSUInteger bufferLength = BMBase64EncodeFinal(&_state, _buffer);
+    BOOL succeeded = !_failed && BMBase64EncoderWriteToStream(_outputStream, _buffer, bufferLength);
+    _failed = NO;
+    return succeeded;
+}
+
+
+@end
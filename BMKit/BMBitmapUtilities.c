@@ -0,0 +1,977 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__APPLE__)
+# include <dispatch/dispatch.h>
+#endif
+
+#include "BMBitmapUtilities.h"
+
+#if defined(__SSE2__)
+# define BMBITMAP_SSE2 1
+# include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+# define BMBITMAP_NEON 1
+# include <arm_neon.h>
+#endif
+
+
+// Side length in pixels of the square tiles used for transposing
+// orientations, small enough that a source and a destination tile
+// stay in the L1 cache for all supported pixel sizes
+#define BMBitmapTileLength ((size_t)64)
+
+// Number of fraction bits of the fixed point filter coefficients, which
+// leaves room for the overshooting Lanczos weights in 16 bits
+#define BMBitmapScalePrecision 14
+
+
+#pragma mark -
+#pragma mark Pixel Helpers
+
+
+static inline void BMBitmapCopyPixel(uint8_t *dst, const uint8_t *src, size_t bytesPerPixel)
+{
+    switch (bytesPerPixel) {
+        case 1: *dst = *src; break;
+        case 2: memcpy(dst, src, 2); break;
+        case 4: memcpy(dst, src, 4); break;
+    }
+}
+
+
+#pragma mark -
+#pragma mark Row Reversal
+
+
+static void BMBitmapReverseRow(uint8_t *dst, const uint8_t *src, size_t width, size_t bytesPerPixel)
+{
+    size_t x = 0;
+#if defined(BMBITMAP_SSE2) || defined(BMBITMAP_NEON)
+    // Reverse 16 bytes at once, storing them at the mirrored position
+    size_t pixelsPerVector = 16 / bytesPerPixel;
+    for (; x + pixelsPerVector <= width; x += pixelsPerVector) {
+        uint8_t *d = dst + (width - x - pixelsPerVector) * bytesPerPixel;
+# if defined(BMBITMAP_SSE2)
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + x * bytesPerPixel));
+        if (bytesPerPixel == 1) {
+            v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        }
+        if (bytesPerPixel <= 2) {
+            v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+            v = _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+        }
+        else {
+            v = _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+        }
+        _mm_storeu_si128((__m128i *)d, v);
+# else
+        uint8x16_t v = vld1q_u8(src + x * bytesPerPixel);
+        switch (bytesPerPixel) {
+            case 1: v = vrev64q_u8(v); break;
+            case 2: v = vreinterpretq_u8_u16(vrev64q_u16(vreinterpretq_u16_u8(v))); break;
+            case 4: v = vreinterpretq_u8_u32(vrev64q_u32(vreinterpretq_u32_u8(v))); break;
+        }
+        vst1q_u8(d, vextq_u8(v, v, 8));
+# endif
+    }
+#endif
+    for (; x < width; ++x) {
+        BMBitmapCopyPixel(dst + (width - 1 - x) * bytesPerPixel, src + x * bytesPerPixel, bytesPerPixel);
+    }
+}
+
+
+#pragma mark -
+#pragma mark Tiled Transposition
+
+
+// The destination address of source pixel (x, y) is dst + x * colStep + y * rowStep,
+// where dst points to the destination pixel of source pixel (0, 0)
+
+static void BMBitmapTransposeRect(const BMBitmap *source, uint8_t *dst, ptrdiff_t colStep, ptrdiff_t rowStep,
+                                  size_t x0, size_t y0, size_t width, size_t height)
+{
+    size_t bytesPerPixel = source->bytesPerPixel;
+    for (size_t y = y0; y < y0 + height; ++y) {
+        const uint8_t *s = (const uint8_t *)source->data + y * source->bytesPerRow + x0 * bytesPerPixel;
+        uint8_t *d = dst + (ptrdiff_t)x0 * colStep + (ptrdiff_t)y * rowStep;
+        for (size_t x = 0; x < width; ++x, s += bytesPerPixel, d += colStep) {
+            BMBitmapCopyPixel(d, s, bytesPerPixel);
+        }
+    }
+}
+
+
+#if defined(BMBITMAP_SSE2) || defined(BMBITMAP_NEON)
+
+// Transposes a 4x4 block of 32-bit pixels, writing each source column as one destination run
+static inline void BMBitmapTransposeBlock32(const BMBitmap *source, uint8_t *dst, ptrdiff_t colStep, ptrdiff_t rowStep, size_t x, size_t y)
+{
+    const uint8_t *s = (const uint8_t *)source->data + y * source->bytesPerRow + x * 4;
+    size_t bytesPerRow = source->bytesPerRow;
+    bool reversed = (rowStep < 0);
+    uint8_t *d = dst + (ptrdiff_t)x * colStep + (ptrdiff_t)(reversed ? y + 3 : y) * rowStep;
+# if defined(BMBITMAP_SSE2)
+    __m128i r0 = _mm_loadu_si128((const __m128i *)s);
+    __m128i r1 = _mm_loadu_si128((const __m128i *)(s + bytesPerRow));
+    __m128i r2 = _mm_loadu_si128((const __m128i *)(s + 2 * bytesPerRow));
+    __m128i r3 = _mm_loadu_si128((const __m128i *)(s + 3 * bytesPerRow));
+    __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+    __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+    __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+    __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+    __m128i c[4] = {
+        _mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1),
+        _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3)
+    };
+    for (size_t i = 0; i < 4; ++i, d += colStep) {
+        _mm_storeu_si128((__m128i *)d, reversed ? _mm_shuffle_epi32(c[i], _MM_SHUFFLE(0, 1, 2, 3)) : c[i]);
+    }
+# else
+    uint32x4x2_t a = vtrnq_u32(vld1q_u32((const uint32_t *)s), vld1q_u32((const uint32_t *)(s + bytesPerRow)));
+    uint32x4x2_t b = vtrnq_u32(vld1q_u32((const uint32_t *)(s + 2 * bytesPerRow)), vld1q_u32((const uint32_t *)(s + 3 * bytesPerRow)));
+    uint32x4_t c[4] = {
+        vcombine_u32(vget_low_u32(a.val[0]), vget_low_u32(b.val[0])),
+        vcombine_u32(vget_low_u32(a.val[1]), vget_low_u32(b.val[1])),
+        vcombine_u32(vget_high_u32(a.val[0]), vget_high_u32(b.val[0])),
+        vcombine_u32(vget_high_u32(a.val[1]), vget_high_u32(b.val[1]))
+    };
+    for (size_t i = 0; i < 4; ++i, d += colStep) {
+        uint32x4_t v = c[i];
+        if (reversed) {
+            v = vrev64q_u32(v);
+            v = vextq_u32(v, v, 2);
+        }
+        vst1q_u32((uint32_t *)d, v);
+    }
+# endif
+}
+
+#endif
+
+
+static void BMBitmapTransposeTile(const BMBitmap *source, uint8_t *dst, ptrdiff_t colStep, ptrdiff_t rowStep,
+                                  size_t x0, size_t y0, size_t width, size_t height)
+{
+#if defined(BMBITMAP_SSE2) || defined(BMBITMAP_NEON)
+    if (source->bytesPerPixel == 4) {
+        size_t width4 = width & ~(size_t)3, height4 = height & ~(size_t)3;
+        for (size_t y = y0; y < y0 + height4; y += 4) {
+            for (size_t x = x0; x < x0 + width4; x += 4) {
+                BMBitmapTransposeBlock32(source, dst, colStep, rowStep, x, y);
+            }
+        }
+        // Leftover columns on the right and rows at the bottom
+        BMBitmapTransposeRect(source, dst, colStep, rowStep, x0 + width4, y0, width - width4, height4);
+        BMBitmapTransposeRect(source, dst, colStep, rowStep, x0, y0 + height4, width, height - height4);
+        return;
+    }
+#endif
+    BMBitmapTransposeRect(source, dst, colStep, rowStep, x0, y0, width, height);
+}
+
+
+#pragma mark -
+#pragma mark Orientation
+
+
+void BMBitmapGetOrientedSize(size_t width, size_t height, BMImageOrientation orientation, size_t *orientedWidth, size_t *orientedHeight)
+{
+    switch (orientation) {
+        case BMImageOrientationLeft:
+        case BMImageOrientationLeftMirrored:
+        case BMImageOrientationRight:
+        case BMImageOrientationRightMirrored:
+            *orientedWidth = height;
+            *orientedHeight = width;
+            break;
+            
+        default:
+            *orientedWidth = width;
+            *orientedHeight = height;
+            break;
+    }
+}
+
+
+bool BMBitmapOrient(const BMBitmap *source, const BMBitmap *destination, BMImageOrientation orientation)
+{
+    size_t width = source->width, height = source->height, bytesPerPixel = source->bytesPerPixel;
+    size_t orientedWidth, orientedHeight;
+    BMBitmapGetOrientedSize(width, height, orientation, &orientedWidth, &orientedHeight);
+    if ((bytesPerPixel != 1 && bytesPerPixel != 2 && bytesPerPixel != 4)
+        || destination->bytesPerPixel != bytesPerPixel
+        || destination->width != orientedWidth
+        || destination->height != orientedHeight) {
+        return false;
+    }
+    
+    // Express the orientation as the destination address of source pixel (0, 0)
+    // plus the (signed) steps for moving one column and one row in the source
+    uint8_t *dst = (uint8_t *)destination->data;
+    ptrdiff_t dstBytesPerRow = (ptrdiff_t)destination->bytesPerRow;
+    ptrdiff_t dstBytesPerPixel = (ptrdiff_t)bytesPerPixel;
+    ptrdiff_t colStep, rowStep;
+    switch (orientation) {
+        case BMImageOrientationUpMirrored:
+            dst += (width - 1) * dstBytesPerPixel, colStep = -dstBytesPerPixel, rowStep = dstBytesPerRow;
+            break;
+        case BMImageOrientationDown:
+            dst += (height - 1) * dstBytesPerRow + (width - 1) * dstBytesPerPixel, colStep = -dstBytesPerPixel, rowStep = -dstBytesPerRow;
+            break;
+        case BMImageOrientationDownMirrored:
+            dst += (height - 1) * dstBytesPerRow, colStep = dstBytesPerPixel, rowStep = -dstBytesPerRow;
+            break;
+        case BMImageOrientationLeftMirrored:
+            colStep = dstBytesPerRow, rowStep = dstBytesPerPixel;
+            break;
+        case BMImageOrientationLeft:
+            dst += (height - 1) * dstBytesPerPixel, colStep = dstBytesPerRow, rowStep = -dstBytesPerPixel;
+            break;
+        case BMImageOrientationRightMirrored:
+            dst += (width - 1) * dstBytesPerRow + (height - 1) * dstBytesPerPixel, colStep = -dstBytesPerRow, rowStep = -dstBytesPerPixel;
+            break;
+        case BMImageOrientationRight:
+            dst += (width - 1) * dstBytesPerRow, colStep = -dstBytesPerRow, rowStep = dstBytesPerPixel;
+            break;
+        default:
+            colStep = dstBytesPerPixel, rowStep = dstBytesPerRow;
+            break;
+    }
+    if (!width || !height) {
+        return true;
+    }
+    
+    if (colStep == dstBytesPerPixel || colStep == -dstBytesPerPixel) {
+        // Rows stay rows, so copy or reverse them one by one
+        for (size_t y = 0; y < height; ++y) {
+            const uint8_t *s = (const uint8_t *)source->data + y * source->bytesPerRow;
+            uint8_t *d = dst + (ptrdiff_t)y * rowStep + ((colStep < 0) ? (1 - (ptrdiff_t)width) * dstBytesPerPixel : 0);
+            if (colStep < 0) {
+                BMBitmapReverseRow(d, s, width, bytesPerPixel);
+            }
+            else {
+                memcpy(d, s, width * bytesPerPixel);
+            }
+        }
+    }
+    else {
+        // Rows become columns, so transpose tile by tile to stay in the cache
+        for (size_t y = 0; y < height; y += BMBitmapTileLength) {
+            size_t tileHeight = (height - y < BMBitmapTileLength) ? height - y : BMBitmapTileLength;
+            for (size_t x = 0; x < width; x += BMBitmapTileLength) {
+                size_t tileWidth = (width - x < BMBitmapTileLength) ? width - x : BMBitmapTileLength;
+                BMBitmapTransposeTile(source, dst, colStep, rowStep, x, y, tileWidth, tileHeight);
+            }
+        }
+    }
+    return true;
+}
+
+
+
+#pragma mark -
+#pragma mark Filter Coefficients
+
+
+// Resampling coefficients for one axis: output pixel i is the weighted sum of
+// counts[i] input pixels starting at starts[i], with weights[i * taps + k]
+typedef struct _BMBitmapScaleTable {
+    size_t   taps;
+    size_t  *starts;
+    size_t  *counts;
+    int16_t *weights;
+} BMBitmapScaleTable;
+
+
+static double BMBitmapScaleFilterBox(double x)
+{
+    return (x >= -0.5 && x < 0.5) ? 1.0 : 0.0;
+}
+
+
+static double BMBitmapScaleFilterBilinear(double x)
+{
+    x = fabs(x);
+    return (x < 1.0) ? 1.0 - x : 0.0;
+}
+
+
+static double BMBitmapScaleFilterLanczos3(double x)
+{
+    if (x == 0.0) {
+        return 1.0;
+    }
+    if (x <= -3.0 || x >= 3.0) {
+        return 0.0;
+    }
+    double px = M_PI * x;
+    return 3.0 * sin(px) * sin(px / 3.0) / (px * px);
+}
+
+
+static void BMBitmapScaleTableDestroy(BMBitmapScaleTable *table)
+{
+    free(table->weights);
+    free(table->counts);
+    free(table->starts);
+}
+
+
+static bool BMBitmapScaleTableInit(BMBitmapScaleTable *table, size_t inputLength, size_t outputLength, BMBitmapScaleQuality quality)
+{
+    double (*filter)(double);
+    double support;
+    switch (quality) {
+        case BMBitmapScaleQualityLow:    filter = BMBitmapScaleFilterBox,      support = 0.5; break;
+        case BMBitmapScaleQualityMedium: filter = BMBitmapScaleFilterBilinear, support = 1.0; break;
+        default:                         filter = BMBitmapScaleFilterLanczos3, support = 3.0; break;
+    }
+    
+    // When scaling down, stretch the filter over all input pixels covered by an output pixel
+    double scale = (double)inputLength / (double)outputLength;
+    double filterScale = (scale > 1.0) ? scale : 1.0;
+    support *= filterScale;
+    
+    size_t taps = (size_t)ceil(support) * 2 + 1;
+    table->taps = taps;
+    table->starts = (size_t *)malloc(outputLength * sizeof(size_t));
+    table->counts = (size_t *)malloc(outputLength * sizeof(size_t));
+    table->weights = (int16_t *)calloc(outputLength * taps, sizeof(int16_t));
+    double *weights = (double *)malloc(taps * sizeof(double));
+    bool succeeded = (table->starts && table->counts && table->weights && weights);
+    for (size_t i = 0; succeeded && i < outputLength; ++i) {
+        double center = ((double)i + 0.5) * scale;
+        double first = floor(center - support + 0.5), last = floor(center + support + 0.5);
+        size_t start = (first > 0.0) ? (size_t)first : 0;
+        size_t end = (last < (double)inputLength) ? (size_t)last : inputLength;
+        if (end - start > taps) {
+            end = start + taps;
+        }
+        
+        double total = 0.0;
+        for (size_t k = start; k < end; ++k) {
+            weights[k - start] = filter(((double)k - center + 0.5) / filterScale);
+            total += weights[k - start];
+        }
+        if (total == 0.0) {
+            // The filter missed all input pixels, fall back to the nearest one
+            start = (center < (double)inputLength) ? (size_t)center : inputLength - 1;
+            end = start + 1;
+            weights[0] = total = 1.0;
+        }
+        
+        // Quantize the normalized weights, and make them sum up to exactly
+        // one so that flat areas keep their exact values
+        int16_t *w = table->weights + i * taps;
+        int sum = 0;
+        size_t largest = 0;
+        for (size_t k = 0; k < end - start; ++k) {
+            w[k] = (int16_t)lround(weights[k] / total * (double)(1 << BMBitmapScalePrecision));
+            sum += w[k];
+            if (w[k] > w[largest]) {
+                largest = k;
+            }
+        }
+        w[largest] += (int16_t)((1 << BMBitmapScalePrecision) - sum);
+        table->starts[i] = start;
+        table->counts[i] = end - start;
+    }
+    free(weights);
+    if (!succeeded) {
+        BMBitmapScaleTableDestroy(table);
+    }
+    return succeeded;
+}
+
+
+#pragma mark -
+#pragma mark Resampling Passes
+
+
+static inline uint8_t BMBitmapScaleClamp(int32_t value)
+{
+    value >>= BMBitmapScalePrecision;
+    return (uint8_t)((value < 0) ? 0 : (value > 255) ? 255 : value);
+}
+
+
+static void BMBitmapScaleRowHorizontally(uint8_t *dst, const uint8_t *src, const BMBitmapScaleTable *table, size_t width, size_t bytesPerPixel)
+{
+    for (size_t x = 0; x < width; ++x, dst += bytesPerPixel) {
+        const uint8_t *s = src + table->starts[x] * bytesPerPixel;
+        const int16_t *w = table->weights + x * table->taps;
+        size_t count = table->counts[x];
+#if defined(BMBITMAP_SSE2)
+        if (bytesPerPixel == 4) {
+            // Interleave the components of two pixels, so that each 32 bit
+            // lane multiplies and adds one component of both at once
+            const __m128i zero = _mm_setzero_si128();
+            __m128i acc = _mm_set1_epi32(1 << (BMBitmapScalePrecision - 1));
+            size_t k = 0;
+            for (; k + 2 <= count; k += 2) {
+                __m128i p = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(s + k * 4)), zero);
+                p = _mm_unpacklo_epi16(p, _mm_srli_si128(p, 8));
+                __m128i c = _mm_set1_epi32((int32_t)(((uint32_t)(uint16_t)w[k + 1] << 16) | (uint16_t)w[k]));
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(p, c));
+            }
+            if (k < count) {
+                int32_t pixel;
+                memcpy(&pixel, s + k * 4, 4);
+                __m128i p = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(pixel), zero), zero);
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(p, _mm_set1_epi32((uint16_t)w[k])));
+            }
+            acc = _mm_srai_epi32(acc, BMBitmapScalePrecision);
+            acc = _mm_packs_epi32(acc, acc);
+            int32_t pixel = _mm_cvtsi128_si32(_mm_packus_epi16(acc, acc));
+            memcpy(dst, &pixel, 4);
+            continue;
+        }
+#elif defined(BMBITMAP_NEON)
+        if (bytesPerPixel == 4) {
+            int32x4_t acc = vdupq_n_s32(0);
+            size_t k = 0;
+            for (; k + 2 <= count; k += 2) {
+                int16x8_t p = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(s + k * 4)));
+                acc = vmlal_n_s16(acc, vget_low_s16(p), w[k]);
+                acc = vmlal_n_s16(acc, vget_high_s16(p), w[k + 1]);
+            }
+            if (k < count) {
+                uint32_t pixel;
+                memcpy(&pixel, s + k * 4, 4);
+                int16x8_t p = vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(pixel))));
+                acc = vmlal_n_s16(acc, vget_low_s16(p), w[k]);
+            }
+            uint16x4_t r = vqrshrun_n_s32(acc, BMBitmapScalePrecision);
+            uint32_t pixel = vget_lane_u32(vreinterpret_u32_u8(vqmovn_u16(vcombine_u16(r, r))), 0);
+            memcpy(dst, &pixel, 4);
+            continue;
+        }
+#endif
+        for (size_t c = 0; c < bytesPerPixel; ++c) {
+            int32_t acc = 1 << (BMBitmapScalePrecision - 1);
+            for (size_t k = 0; k < count; ++k) {
+                acc += (int32_t)s[k * bytesPerPixel + c] * w[k];
+            }
+            dst[c] = BMBitmapScaleClamp(acc);
+        }
+    }
+}
+
+
+// Computes one output row as the weighted sum of count input rows, which
+// does not care about pixels at all, so every byte is handled the same way
+static void BMBitmapScaleRowVertically(uint8_t *dst, const uint8_t *const *rows, const int16_t *w, size_t count, size_t length)
+{
+    size_t i = 0;
+#if defined(BMBITMAP_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi32(1 << (BMBitmapScalePrecision - 1));
+    for (; i + 16 <= length; i += 16) {
+        __m128i acc0 = half, acc1 = half, acc2 = half, acc3 = half;
+        for (size_t k = 0; k < count; k += 2) {
+            // Interleave the bytes of two rows, the second being zero for an odd count
+            __m128i a = _mm_loadu_si128((const __m128i *)(rows[k] + i));
+            __m128i b = (k + 1 < count) ? _mm_loadu_si128((const __m128i *)(rows[k + 1] + i)) : zero;
+            __m128i c = _mm_set1_epi32((int32_t)(((uint32_t)(uint16_t)((k + 1 < count) ? w[k + 1] : 0) << 16) | (uint16_t)w[k]));
+            __m128i lo = _mm_unpacklo_epi8(a, b), hi = _mm_unpackhi_epi8(a, b);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), c));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), c));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), c));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), c));
+        }
+        __m128i r0 = _mm_packs_epi32(_mm_srai_epi32(acc0, BMBitmapScalePrecision), _mm_srai_epi32(acc1, BMBitmapScalePrecision));
+        __m128i r1 = _mm_packs_epi32(_mm_srai_epi32(acc2, BMBitmapScalePrecision), _mm_srai_epi32(acc3, BMBitmapScalePrecision));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(r0, r1));
+    }
+#elif defined(BMBITMAP_NEON)
+    for (; i + 8 <= length; i += 8) {
+        int32x4_t acc0 = vdupq_n_s32(0), acc1 = vdupq_n_s32(0);
+        for (size_t k = 0; k < count; ++k) {
+            int16x8_t p = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(rows[k] + i)));
+            acc0 = vmlal_n_s16(acc0, vget_low_s16(p), w[k]);
+            acc1 = vmlal_n_s16(acc1, vget_high_s16(p), w[k]);
+        }
+        uint16x8_t r = vcombine_u16(vqrshrun_n_s32(acc0, BMBitmapScalePrecision), vqrshrun_n_s32(acc1, BMBitmapScalePrecision));
+        vst1_u8(dst + i, vqmovn_u16(r));
+    }
+#endif
+    for (; i < length; ++i) {
+        int32_t acc = 1 << (BMBitmapScalePrecision - 1);
+        for (size_t k = 0; k < count; ++k) {
+            acc += (int32_t)rows[k][i] * w[k];
+        }
+        dst[i] = BMBitmapScaleClamp(acc);
+    }
+}
+
+
+#pragma mark -
+#pragma mark Scaling
+
+
+bool BMBitmapScale(const BMBitmap *source, const BMBitmap *destination, BMBitmapScaleQuality quality)
+{
+    size_t bytesPerPixel = source->bytesPerPixel;
+    if ((bytesPerPixel != 1 && bytesPerPixel != 2 && bytesPerPixel != 4)
+        || destination->bytesPerPixel != bytesPerPixel
+        || (!source->width || !source->height) != (!destination->width || !destination->height)) {
+        return false;
+    }
+    if (!destination->width || !destination->height) {
+        return true;
+    }
+    size_t rowLength = destination->width * bytesPerPixel;
+    if (source->width == destination->width && source->height == destination->height) {
+        for (size_t y = 0; y < source->height; ++y) {
+            memcpy((uint8_t *)destination->data + y * destination->bytesPerRow, (const uint8_t *)source->data + y * source->bytesPerRow, rowLength);
+        }
+        return true;
+    }
+    
+    bool succeeded = false;
+    BMBitmapScaleTable horizontal, vertical;
+    if (BMBitmapScaleTableInit(&horizontal, source->width, destination->width, quality)) {
+        if (BMBitmapScaleTableInit(&vertical, source->height, destination->height, quality)) {
+            // Horizontally scaled rows are kept in a ring with one slot per vertical
+            // tap; the input windows only move downwards, so every input row is
+            // scaled horizontally once and stays in the ring while it is needed
+            size_t ringLength = vertical.taps;
+            size_t slotLength = (rowLength + 15) & ~(size_t)15;
+            uint8_t *ring = (uint8_t *)malloc(ringLength * slotLength);
+            size_t *ringRows = (size_t *)malloc(ringLength * sizeof(size_t));
+            const uint8_t **rows = (const uint8_t **)malloc(ringLength * sizeof(const uint8_t *));
+            if (ring && ringRows && rows) {
+                for (size_t k = 0; k < ringLength; ++k) {
+                    ringRows[k] = SIZE_MAX;
+                }
+                for (size_t y = 0; y < destination->height; ++y) {
+                    size_t start = vertical.starts[y], count = vertical.counts[y];
+                    for (size_t k = 0; k < count; ++k) {
+                        size_t row = start + k, slot = row % ringLength;
+                        uint8_t *slotBytes = ring + slot * slotLength;
+                        if (ringRows[slot] != row) {
+                            BMBitmapScaleRowHorizontally(slotBytes, (const uint8_t *)source->data + row * source->bytesPerRow, &horizontal, destination->width, bytesPerPixel);
+                            ringRows[slot] = row;
+                        }
+                        rows[k] = slotBytes;
+                    }
+                    BMBitmapScaleRowVertically((uint8_t *)destination->data + y * destination->bytesPerRow, rows, vertical.weights + y * vertical.taps, count, rowLength);
+                }
+                succeeded = true;
+            }
+            free(rows);
+            free(ringRows);
+            free(ring);
+            BMBitmapScaleTableDestroy(&vertical);
+        }
+        BMBitmapScaleTableDestroy(&horizontal);
+    }
+    return succeeded;
+}
+
+
+#pragma mark -
+#pragma mark Tiled Bitmaps
+
+
+static bool BMTiledBitmapReadBitmap(void *context, size_t x, size_t y, const BMBitmap *bitmap)
+{
+    const BMBitmap *source = (const BMBitmap *)context;
+    size_t rowLength = bitmap->width * bitmap->bytesPerPixel;
+    const uint8_t *s = (const uint8_t *)source->data + y * source->bytesPerRow + x * source->bytesPerPixel;
+    for (size_t row = 0; row < bitmap->height; ++row) {
+        memcpy((uint8_t *)bitmap->data + row * bitmap->bytesPerRow, s + row * source->bytesPerRow, rowLength);
+    }
+    return true;
+}
+
+
+static bool BMTiledBitmapWriteBitmap(void *context, size_t x, size_t y, const BMBitmap *bitmap)
+{
+    const BMBitmap *destination = (const BMBitmap *)context;
+    size_t rowLength = bitmap->width * bitmap->bytesPerPixel;
+    uint8_t *d = (uint8_t *)destination->data + y * destination->bytesPerRow + x * destination->bytesPerPixel;
+    for (size_t row = 0; row < bitmap->height; ++row) {
+        memcpy(d + row * destination->bytesPerRow, (const uint8_t *)bitmap->data + row * bitmap->bytesPerRow, rowLength);
+    }
+    return true;
+}
+
+
+void BMTiledBitmapInitWithBitmap(BMTiledBitmap *tiledBitmap, const BMBitmap *bitmap, size_t tileWidth, size_t tileHeight)
+{
+    tiledBitmap->width = bitmap->width;
+    tiledBitmap->height = bitmap->height;
+    tiledBitmap->bytesPerPixel = bitmap->bytesPerPixel;
+    tiledBitmap->tileWidth = tileWidth;
+    tiledBitmap->tileHeight = tileHeight;
+    tiledBitmap->read = BMTiledBitmapReadBitmap;
+    tiledBitmap->write = BMTiledBitmapWriteBitmap;
+    tiledBitmap->context = (void *)bitmap;
+}
+
+
+// The destination tiles, which are processed in parallel, and a flag
+// that lets the remaining tiles bail out after a tile failed
+typedef struct _BMTiledBitmapJob {
+    const BMTiledBitmap *source;
+    const BMTiledBitmap *destination;
+    size_t               columns;
+    size_t               count;
+    volatile bool        failed;
+    BMImageOrientation   orientation;
+    BMBitmapScaleTable   horizontal;
+    BMBitmapScaleTable   vertical;
+} BMTiledBitmapJob;
+
+
+static bool BMTiledBitmapJobInit(BMTiledBitmapJob *job, const BMTiledBitmap *source, const BMTiledBitmap *destination)
+{
+    if (!source->read || !destination->write
+        || !source->tileWidth || !source->tileHeight || !destination->tileWidth || !destination->tileHeight
+        || source->bytesPerPixel != destination->bytesPerPixel
+        || (source->bytesPerPixel != 1 && source->bytesPerPixel != 2 && source->bytesPerPixel != 4)) {
+        return false;
+    }
+    memset(job, 0, sizeof(*job));
+    job->source = source;
+    job->destination = destination;
+    job->columns = (destination->width + destination->tileWidth - 1) / destination->tileWidth;
+    job->count = job->columns * ((destination->height + destination->tileHeight - 1) / destination->tileHeight);
+    return true;
+}
+
+
+// Returns the rectangle of the destination tile with the given index
+static void BMTiledBitmapJobGetTile(const BMTiledBitmapJob *job, size_t index, BMBitmap *tile)
+{
+    const BMTiledBitmap *destination = job->destination;
+    size_t x = (index % job->columns) * destination->tileWidth;
+    size_t y = (index / job->columns) * destination->tileHeight;
+    tile->width = (destination->width - x < destination->tileWidth) ? destination->width - x : destination->tileWidth;
+    tile->height = (destination->height - y < destination->tileHeight) ? destination->height - y : destination->tileHeight;
+    tile->bytesPerPixel = destination->bytesPerPixel;
+    tile->bytesPerRow = tile->width * tile->bytesPerPixel;
+}
+
+
+static void BMTiledBitmapJobRun(BMTiledBitmapJob *job, void (*applier)(void *, size_t))
+{
+#if defined(__APPLE__)
+    if (job->count > 1) {
+        dispatch_apply_f(job->count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), job, applier);
+    }
+    else if (job->count) {
+        applier(job, 0);
+    }
+#else
+    for (size_t i = 0; i < job->count; ++i) {
+        applier(job, i);
+    }
+#endif
+}
+
+
+// Reads the source rectangle at x, y with the size of rect, split on the
+// boundaries of the source tiles, so that every read lies within one tile
+static bool BMTiledBitmapReadRect(const BMTiledBitmap *source, size_t x, size_t y, const BMBitmap *rect)
+{
+    for (size_t top = y; top < y + rect->height; ) {
+        size_t bottom = (top / source->tileHeight + 1) * source->tileHeight;
+        bottom = (bottom < y + rect->height) ? bottom : y + rect->height;
+        for (size_t left = x; left < x + rect->width; ) {
+            size_t right = (left / source->tileWidth + 1) * source->tileWidth;
+            right = (right < x + rect->width) ? right : x + rect->width;
+            BMBitmap part;
+            part.data = (uint8_t *)rect->data + (top - y) * rect->bytesPerRow + (left - x) * rect->bytesPerPixel;
+            part.width = right - left;
+            part.height = bottom - top;
+            part.bytesPerRow = rect->bytesPerRow;
+            part.bytesPerPixel = rect->bytesPerPixel;
+            if (!source->read(source->context, left, top, &part)) {
+                return false;
+            }
+            left = right;
+        }
+        top = bottom;
+    }
+    return true;
+}
+
+
+// Returns the source pixel that BMBitmapOrient moves to the destination pixel
+// at x, y, the inverse of the steps chosen there
+static void BMTiledBitmapGetSourcePoint(size_t width, size_t height, BMImageOrientation orientation, size_t x, size_t y, size_t *sourceX, size_t *sourceY)
+{
+    switch (orientation) {
+        case BMImageOrientationUpMirrored:    *sourceX = width - 1 - x, *sourceY = y; break;
+        case BMImageOrientationDown:          *sourceX = width - 1 - x, *sourceY = height - 1 - y; break;
+        case BMImageOrientationDownMirrored:  *sourceX = x, *sourceY = height - 1 - y; break;
+        case BMImageOrientationLeftMirrored:  *sourceX = y, *sourceY = x; break;
+        case BMImageOrientationLeft:          *sourceX = y, *sourceY = height - 1 - x; break;
+        case BMImageOrientationRightMirrored: *sourceX = width - 1 - y, *sourceY = height - 1 - x; break;
+        case BMImageOrientationRight:         *sourceX = width - 1 - y, *sourceY = x; break;
+        default:                              *sourceX = x, *sourceY = y; break;
+    }
+}
+
+
+static void BMTiledBitmapOrientApplier(void *context, size_t index)
+{
+    BMTiledBitmapJob *job = (BMTiledBitmapJob *)context;
+    if (job->failed) {
+        return;
+    }
+    const BMTiledBitmap *source = job->source;
+    size_t x = (index % job->columns) * job->destination->tileWidth;
+    size_t y = (index / job->columns) * job->destination->tileHeight;
+    BMBitmap tile;
+    BMTiledBitmapJobGetTile(job, index, &tile);
+    
+    // The orientation maps the destination tile onto a source rectangle,
+    // given by the source pixels of two opposite corners of the tile
+    size_t x0, y0, x1, y1;
+    BMTiledBitmapGetSourcePoint(source->width, source->height, job->orientation, x, y, &x0, &y0);
+    BMTiledBitmapGetSourcePoint(source->width, source->height, job->orientation, x + tile.width - 1, y + tile.height - 1, &x1, &y1);
+    BMBitmap rect;
+    rect.width = ((x0 < x1) ? x1 - x0 : x0 - x1) + 1;
+    rect.height = ((y0 < y1) ? y1 - y0 : y0 - y1) + 1;
+    rect.bytesPerPixel = source->bytesPerPixel;
+    rect.bytesPerRow = rect.width * rect.bytesPerPixel;
+    
+    bool succeeded = false;
+    uint8_t *buffer = (uint8_t *)malloc(rect.bytesPerRow * rect.height + tile.bytesPerRow * tile.height);
+    if (buffer) {
+        rect.data = buffer;
+        tile.data = buffer + rect.bytesPerRow * rect.height;
+        succeeded = (BMTiledBitmapReadRect(source, (x0 < x1) ? x0 : x1, (y0 < y1) ? y0 : y1, &rect)
+                     && BMBitmapOrient(&rect, &tile, job->orientation)
+                     && job->destination->write(job->destination->context, x, y, &tile));
+        free(buffer);
+    }
+    if (!succeeded) {
+        job->failed = true;
+    }
+}
+
+
+bool BMTiledBitmapOrient(const BMTiledBitmap *source, const BMTiledBitmap *destination, BMImageOrientation orientation)
+{
+    size_t orientedWidth, orientedHeight;
+    BMBitmapGetOrientedSize(source->width, source->height, orientation, &orientedWidth, &orientedHeight);
+    BMTiledBitmapJob job;
+    if (destination->width != orientedWidth || destination->height != orientedHeight || !BMTiledBitmapJobInit(&job, source, destination)) {
+        return false;
+    }
+    job.orientation = orientation;
+    BMTiledBitmapJobRun(&job, BMTiledBitmapOrientApplier);
+    return !job.failed;
+}
+
+
+// Adds the weighted sum of count pixels to the sums of the components of one
+// output pixel, the part of BMBitmapScaleRowHorizontally inside one rectangle
+static inline void BMTiledBitmapAccumulatePixels(int32_t *sums, const uint8_t *s, const int16_t *w, size_t count, size_t bytesPerPixel)
+{
+#if defined(BMBITMAP_SSE2)
+    if (bytesPerPixel == 4) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i acc = _mm_loadu_si128((const __m128i *)sums);
+        size_t k = 0;
+        for (; k + 2 <= count; k += 2) {
+            __m128i p = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(s + k * 4)), zero);
+            p = _mm_unpacklo_epi16(p, _mm_srli_si128(p, 8));
+            __m128i c = _mm_set1_epi32((int32_t)(((uint32_t)(uint16_t)w[k + 1] << 16) | (uint16_t)w[k]));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(p, c));
+        }
+        if (k < count) {
+            int32_t pixel;
+            memcpy(&pixel, s + k * 4, 4);
+            __m128i p = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(pixel), zero), zero);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(p, _mm_set1_epi32((uint16_t)w[k])));
+        }
+        _mm_storeu_si128((__m128i *)sums, acc);
+        return;
+    }
+#elif defined(BMBITMAP_NEON)
+    if (bytesPerPixel == 4) {
+        int32x4_t acc = vld1q_s32(sums);
+        size_t k = 0;
+        for (; k + 2 <= count; k += 2) {
+            int16x8_t p = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(s + k * 4)));
+            acc = vmlal_n_s16(acc, vget_low_s16(p), w[k]);
+            acc = vmlal_n_s16(acc, vget_high_s16(p), w[k + 1]);
+        }
+        if (k < count) {
+            uint32_t pixel;
+            memcpy(&pixel, s + k * 4, 4);
+            int16x8_t p = vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(pixel))));
+            acc = vmlal_n_s16(acc, vget_low_s16(p), w[k]);
+        }
+        vst1q_s32(sums, acc);
+        return;
+    }
+#endif
+    for (size_t k = 0; k < count; ++k, s += bytesPerPixel) {
+        for (size_t c = 0; c < bytesPerPixel; ++c) {
+            sums[c] += (int32_t)s[c] * w[k];
+        }
+    }
+}
+
+
+// Scales the source rectangle under the filter windows of one destination tile,
+// reading it in bands and rectangles along the source tile grid; each source row is scaled horizontally by
+// accumulating the products of all rectangles it crosses, so the sums are exactly
+// those of BMBitmapScale, and then added to the output rows whose window covers it
+static bool BMTiledBitmapScaleTile(const BMTiledBitmapJob *job, size_t x, size_t y, BMBitmap *tile)
+{
+    const BMTiledBitmap *source = job->source;
+    const BMBitmapScaleTable *horizontal = &job->horizontal, *vertical = &job->vertical;
+    size_t bytesPerPixel = source->bytesPerPixel;
+    size_t rowLength = tile->bytesPerRow;
+    size_t x0 = SIZE_MAX, x1 = 0, y0 = SIZE_MAX, y1 = 0;
+    for (size_t i = x; i < x + tile->width; ++i) {
+        x0 = (horizontal->starts[i] < x0) ? horizontal->starts[i] : x0;
+        x1 = (horizontal->starts[i] + horizontal->counts[i] > x1) ? horizontal->starts[i] + horizontal->counts[i] : x1;
+    }
+    for (size_t i = y; i < y + tile->height; ++i) {
+        y0 = (vertical->starts[i] < y0) ? vertical->starts[i] : y0;
+        y1 = (vertical->starts[i] + vertical->counts[i] > y1) ? vertical->starts[i] + vertical->counts[i] : y1;
+    }
+    
+    size_t bandLength = source->tileWidth * source->tileHeight * bytesPerPixel;
+    int32_t *rowSums = (int32_t *)malloc(source->tileHeight * rowLength * sizeof(int32_t));
+    int32_t *tileSums = (int32_t *)malloc(tile->height * rowLength * sizeof(int32_t));
+    uint8_t *buffer = (uint8_t *)malloc(bandLength + rowLength + tile->height * rowLength);
+    bool succeeded = (rowSums && tileSums && buffer);
+    if (succeeded) {
+        uint8_t *row = buffer + bandLength;
+        tile->data = row + rowLength;
+        for (size_t i = 0; i < tile->height * rowLength; ++i) {
+            tileSums[i] = 1 << (BMBitmapScalePrecision - 1);
+        }
+        for (size_t bandY = y0, bandHeight; succeeded && bandY < y1; bandY += bandHeight) {
+            size_t bandEnd = (bandY / source->tileHeight + 1) * source->tileHeight;
+            bandHeight = ((bandEnd < y1) ? bandEnd : y1) - bandY;
+            for (size_t i = 0; i < bandHeight * rowLength; ++i) {
+                rowSums[i] = 1 << (BMBitmapScalePrecision - 1);
+            }
+            BMBitmap rect;
+            for (size_t rectX = x0; succeeded && rectX < x1; rectX += rect.width) {
+                size_t rectEnd = (rectX / source->tileWidth + 1) * source->tileWidth;
+                rect.data = buffer;
+                rect.width = ((rectEnd < x1) ? rectEnd : x1) - rectX;
+                rect.height = bandHeight;
+                rect.bytesPerPixel = bytesPerPixel;
+                rect.bytesPerRow = rect.width * bytesPerPixel;
+                succeeded = source->read(source->context, rectX, bandY, &rect);
+                for (size_t r = 0; succeeded && r < bandHeight; ++r) {
+                    const uint8_t *s = buffer + r * rect.bytesPerRow;
+                    int32_t *sums = rowSums + r * rowLength;
+                    for (size_t i = 0; i < tile->width; ++i, sums += bytesPerPixel) {
+                        // The part of the window of output column i inside the rectangle
+                        size_t start = horizontal->starts[x + i], end = start + horizontal->counts[x + i];
+                        size_t first = (start > rectX) ? start : rectX, last = (end < rectX + rect.width) ? end : rectX + rect.width;
+                        if (first < last) {
+                            BMTiledBitmapAccumulatePixels(sums, s + (first - rectX) * bytesPerPixel, horizontal->weights + (x + i) * horizontal->taps + (first - start), last - first, bytesPerPixel);
+                        }
+                    }
+                }
+            }
+            for (size_t r = 0; succeeded && r < bandHeight; ++r) {
+                size_t sourceY = bandY + r;
+                for (size_t i = 0; i < rowLength; ++i) {
+                    row[i] = BMBitmapScaleClamp(rowSums[r * rowLength + i]);
+                }
+                for (size_t j = 0; j < tile->height; ++j) {
+                    size_t start = vertical->starts[y + j];
+                    if (sourceY >= start && sourceY < start + vertical->counts[y + j]) {
+                        int32_t weight = vertical->weights[(y + j) * vertical->taps + sourceY - start];
+                        int32_t *sums = tileSums + j * rowLength;
+                        for (size_t i = 0; i < rowLength; ++i) {
+                            sums[i] += (int32_t)row[i] * weight;
+                        }
+                    }
+                }
+            }
+        }
+        if (succeeded) {
+            for (size_t i = 0; i < tile->height * rowLength; ++i) {
+                ((uint8_t *)tile->data)[i] = BMBitmapScaleClamp(tileSums[i]);
+            }
+            succeeded = job->destination->write(job->destination->context, x, y, tile);
+        }
+    }
+    free(buffer);
+    free(tileSums);
+    free(rowSums);
+    return succeeded;
+}
+
+
+static void BMTiledBitmapScaleApplier(void *context, size_t index)
+{
+    BMTiledBitmapJob *job = (BMTiledBitmapJob *)context;
+    if (job->failed) {
+        return;
+    }
+    BMBitmap tile;
+    BMTiledBitmapJobGetTile(job, index, &tile);
+    if (!BMTiledBitmapScaleTile(job, (index % job->columns) * job->destination->tileWidth, (index / job->columns) * job->destination->tileHeight, &tile)) {
+        job->failed = true;
+    }
+}
+
+
+bool BMTiledBitmapScale(const BMTiledBitmap *source, const BMTiledBitmap *destination, BMBitmapScaleQuality quality)
+{
+    BMTiledBitmapJob job;
+    if ((!source->width || !source->height) != (!destination->width || !destination->height) || !BMTiledBitmapJobInit(&job, source, destination)) {
+        return false;
+    }
+    if (!destination->width || !destination->height) {
+        return true;
+    }
+    if (!BMBitmapScaleTableInit(&job.horizontal, source->width, destination->width, quality)) {
+        return false;
+    }
+    if (!BMBitmapScaleTableInit(&job.vertical, source->height, destination->height, quality)) {
+        BMBitmapScaleTableDestroy(&job.horizontal);
+        return false;
+    }
+    BMTiledBitmapJobRun(&job, BMTiledBitmapScaleApplier);
+    BMBitmapScaleTableDestroy(&job.vertical);
+    BMBitmapScaleTableDestroy(&job.horizontal);
+    return !job.failed;
+}
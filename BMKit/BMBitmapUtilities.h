@@ -0,0 +1,101 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __BMBITMAPUTILITIES__
+#define __BMBITMAPUTILITIES__
+
+#include <sys/cdefs.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+__BEGIN_DECLS
+
+/** EXIF image orientations, with the values and meanings of the EXIF orientation tag, so that values read from image properties can be used directly. Note that `BMImageOrientationLeft` and `BMImageOrientationRight` correspond to `UIImageOrientationRight` and `UIImageOrientationLeft`, see `BMImageOrientationFromUIImageOrientation`. */
+typedef enum _BMImageOrientation {
+    BMImageOrientationUp            = 1, /**< The 0th row is at the top, and the 0th column is on the left. */
+    BMImageOrientationUpMirrored    = 2, /**< The 0th row is at the top, and the 0th column is on the right. */
+    BMImageOrientationDown          = 3, /**< The 0th row is at the bottom, and the 0th column is on the right. */
+    BMImageOrientationDownMirrored  = 4, /**< The 0th row is at the bottom, and the 0th column is on the left. */
+    BMImageOrientationLeftMirrored  = 5, /**< The 0th row is on the left, and the 0th column is at the top. */
+    BMImageOrientationLeft          = 6, /**< The 0th row is on the right, and the 0th column is at the top, so the image is rotated by 90 degrees clockwise for display. */
+    BMImageOrientationRightMirrored = 7, /**< The 0th row is on the right, and the 0th column is at the bottom. */
+    BMImageOrientationRight         = 8  /**< The 0th row is on the left, and the 0th column is at the bottom, so the image is rotated by 90 degrees counterclockwise for display. */
+} BMImageOrientation;
+
+/** A raw bitmap in memory, with rows stored from top to bottom. */
+typedef struct _BMBitmap {
+    void   *data;
+    size_t  width;
+    size_t  height;
+    size_t  bytesPerRow;
+    size_t  bytesPerPixel;
+} BMBitmap;
+
+/** Resampling filters for scaling bitmaps, from fastest to sharpest. */
+typedef enum _BMBitmapScaleQuality {
+    BMBitmapScaleQualityLow    = 0, /**< Box filter, which averages the covered area when scaling down and picks the nearest pixel when scaling up. */
+    BMBitmapScaleQualityMedium = 1, /**< Bilinear (triangle) filter. */
+    BMBitmapScaleQualityHigh   = 2  /**< Lanczos filter with three lobes. */
+} BMBitmapScaleQuality;
+
+/** Returns the size of a _width_ x _height_ bitmap after rotating it from _orientation_ to "Up" orientation. */
+extern void BMBitmapGetOrientedSize(size_t width, size_t height, BMImageOrientation orientation, size_t *orientedWidth, size_t *orientedHeight);
+
+/** Rotates and flips the pixels of _source_ from _orientation_ to "Up" orientation into _destination_, which must not overlap _source_, must have the same bytes per pixel and the size returned by `BMBitmapGetOrientedSize`. This is a pure pixel permutation, with the same result as `BMImageCreateWithImageInOrientation`. Bitmaps with 1, 2 and 4 bytes per pixel are supported. Returns `false` if the bitmaps do not match or the pixel size is not supported. */
+extern bool BMBitmapOrient(const BMBitmap *source, const BMBitmap *destination, BMImageOrientation orientation);
+
+/** Scales the pixels of _source_ to the size of _destination_, which must not overlap _source_ and must have the same bytes per pixel, using a separable filter of the given _quality_. Every byte of a pixel is treated as an independent 8 bit component, so any byte order of gray, gray and alpha and RGBA bitmaps with 1, 2 and 4 bytes per pixel is supported, as long as alpha is premultiplied. Returns `false` if the bitmaps do not match, the pixel size is not supported or memory is exhausted. */
+extern bool BMBitmapScale(const BMBitmap *source, const BMBitmap *destination, BMBitmapScaleQuality quality);
+
+/** A function that copies the pixels of the rectangle of a tiled bitmap at _x_, _y_ with the size of _bitmap_ into _bitmap_, or the other way around, see `BMTiledBitmap`. The rows of _bitmap_ may be longer than its width. Returns `false` if the pixels could not be read or written. */
+typedef bool (*BMTiledBitmapFunction)(void *context, size_t x, size_t y, const BMBitmap *bitmap);
+
+/** A bitmap that is too large to be held in memory at once, whose pixels are read and written rectangle by rectangle through functions, e.g. from a memory mapped file or a decoder that can decode regions. The bitmap is divided into a grid of _tileWidth_ x _tileHeight_ tiles starting at the top left corner. Every rectangle that is read lies within a single tile, but may cover only part of it, and every rectangle that is written is a whole tile, clipped at the right and bottom edges. On Apple platforms, the tiled bitmap functions call these functions concurrently from several threads, for rectangles that do not overlap when writing; elsewhere they process the tiles one after another. */
+typedef struct _BMTiledBitmap {
+    size_t                width;         /**< The width of the bitmap. */
+    size_t                height;        /**< The height of the bitmap. */
+    size_t                bytesPerPixel; /**< The bytes per pixel of the bitmap. */
+    size_t                tileWidth;     /**< The width of the tiles, which the rectangles that are read or written never cross. */
+    size_t                tileHeight;    /**< The height of the tiles, which the rectangles that are read or written never cross. */
+    BMTiledBitmapFunction read;          /**< The function that reads pixels from the bitmap, required for sources. */
+    BMTiledBitmapFunction write;         /**< The function that writes pixels to the bitmap, required for destinations. */
+    void                 *context;       /**< The context passed to _read_ and _write_. */
+} BMTiledBitmap;
+
+/** Initializes _tiledBitmap_ to read and write the pixels of _bitmap_, which must stay valid while _tiledBitmap_ is used, in tiles of _tileWidth_ x _tileHeight_ pixels. */
+extern void BMTiledBitmapInitWithBitmap(BMTiledBitmap *tiledBitmap, const BMBitmap *bitmap, size_t tileWidth, size_t tileHeight);
+
+/** Rotates and flips the pixels of _source_ from _orientation_ to "Up" orientation into _destination_ like `BMBitmapOrient`, one destination tile at a time, with the tiles processed in parallel. Each tile reads the source rectangle that maps onto it, split on the source tiles it covers, so the working memory is two tiles per thread, no matter how large the bitmaps are. Returns `false` if the bitmaps do not match, reading or writing failed, or memory is exhausted, in which case _destination_ may be partially written. */
+extern bool BMTiledBitmapOrient(const BMTiledBitmap *source, const BMTiledBitmap *destination, BMImageOrientation orientation);
+
+/** Scales the pixels of _source_ to the size of _destination_ like `BMBitmapScale`, with the same result, one destination tile at a time, with the tiles processed in parallel. Each tile reads the source pixels under its filter window source tile by source tile and accumulates them, so the working memory is a few tiles per thread, no matter how large the bitmaps are or how far they are scaled down. Returns `false` if the bitmaps do not match, reading or writing failed, or memory is exhausted, in which case _destination_ may be partially written. */
+extern bool BMTiledBitmapScale(const BMTiledBitmap *source, const BMTiledBitmap *destination, BMBitmapScaleQuality quality);
+
+__END_DECLS
+
+#endif /* !__BMBITMAPUTILITIES__ */
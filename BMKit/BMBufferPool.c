@@ -0,0 +1,262 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__APPLE__)
+# include <CoreFoundation/CoreFoundation.h>
+# include <dispatch/dispatch.h>
+#endif
+
+#include "BMBufferPool.h"
+
+
+// Number of size classes, four per power of two from BMBufferPoolMinLength up
+#define BMBufferPoolMinShift   16
+#define BMBufferPoolClassCount ((64 - BMBufferPoolMinShift) * 4 + 1)
+
+// Alignment of the buffers, enough for any vector unit and a cache line
+#define BMBufferPoolAlignment ((size_t)64)
+
+
+struct _BMBufferPool {
+    pthread_mutex_t mutex;
+    size_t          capacity;
+    size_t          retainedLength;
+    size_t          outstandingLength;
+    uint64_t        hits;
+    uint64_t        misses;
+    void           *freeLists[BMBufferPoolClassCount];  // The first word of a free buffer links to the next one
+};
+
+
+// Returns the size class for a buffer of the given length
+static size_t BMBufferPoolGetClass(size_t length)
+{
+    if (length <= BMBufferPoolMinLength) {
+        return 0;
+    }
+    // Round up to the next multiple of a quarter of the highest power of two
+    size_t n = length - 1;
+    unsigned shift = 0;
+    while ((n >> shift) > 1) {
+        shift++;
+    }
+    return (shift - BMBufferPoolMinShift) * 4 + ((n >> (shift - 2)) - 4) + 1;
+}
+
+
+// Returns the length of the buffers in the given size class
+static size_t BMBufferPoolGetClassLength(size_t i)
+{
+    if (!i) {
+        return BMBufferPoolMinLength;
+    }
+    return (size_t)(5 + (i - 1) % 4) << ((i - 1) / 4 + BMBufferPoolMinShift - 2);
+}
+
+
+// Frees retained buffers to the system, largest first, until no more than
+// capacity bytes are retained; the mutex must be held
+static void BMBufferPoolTrimToCapacity(BMBufferPool *pool, size_t capacity)
+{
+    for (size_t i = BMBufferPoolClassCount; i-- > 0 && pool->retainedLength > capacity; ) {
+        size_t classLength = BMBufferPoolGetClassLength(i);
+        while (pool->freeLists[i] && pool->retainedLength > capacity) {
+            void *buffer = pool->freeLists[i];
+            memcpy(&pool->freeLists[i], buffer, sizeof(void *));
+            pool->retainedLength -= classLength;
+            free(buffer);
+        }
+    }
+}
+
+
+BMBufferPool *BMBufferPoolCreate(size_t capacity)
+{
+    BMBufferPool *pool = (BMBufferPool *)calloc(1, sizeof(BMBufferPool));
+    if (pool) {
+        if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
+            free(pool);
+            return NULL;
+        }
+        pool->capacity = capacity;
+    }
+    return pool;
+}
+
+
+void BMBufferPoolDestroy(BMBufferPool *pool)
+{
+    if (pool) {
+        BMBufferPoolTrimToCapacity(pool, 0);
+        pthread_mutex_destroy(&pool->mutex);
+        free(pool);
+    }
+}
+
+
+#if defined(__APPLE__)
+
+static void BMBufferPoolDidReceiveMemoryWarning(CFNotificationCenterRef center, void *observer, CFStringRef name, const void *object, CFDictionaryRef userInfo)
+{
+    BMBufferPoolTrim((BMBufferPool *)observer);
+}
+
+
+static void BMBufferPoolHandleMemoryPressure(void *context)
+{
+    BMBufferPoolTrim((BMBufferPool *)context);
+}
+
+#endif
+
+
+static BMBufferPool  *BMBufferPoolDefault = NULL;
+static pthread_once_t BMBufferPoolDefaultOnce = PTHREAD_ONCE_INIT;
+
+
+static void BMBufferPoolInitializeDefault(void)
+{
+    BMBufferPoolDefault = BMBufferPoolCreate(BMBufferPoolDefaultCapacity);
+#if defined(__APPLE__)
+    if (BMBufferPoolDefault) {
+        // UIKit posts memory warnings to the local center, which is shared with NSNotificationCenter
+        CFNotificationCenterAddObserver(CFNotificationCenterGetLocalCenter(),
+                                        BMBufferPoolDefault,
+                                        BMBufferPoolDidReceiveMemoryWarning,
+                                        CFSTR("UIApplicationDidReceiveMemoryWarningNotification"),
+                                        NULL,
+                                        CFNotificationSuspensionBehaviorDeliverImmediately);
+# if defined(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE)
+        // Newer systems also signal memory pressure to processes without UIKit
+        dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE,
+                                                          0,
+                                                          DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL,
+                                                          dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0));
+        if (source) {
+            dispatch_set_context(source, BMBufferPoolDefault);
+            dispatch_source_set_event_handler_f(source, BMBufferPoolHandleMemoryPressure);
+            dispatch_resume(source);
+        }
+# endif
+    }
+#endif
+}
+
+
+BMBufferPool *BMBufferPoolGetDefault(void)
+{
+    pthread_once(&BMBufferPoolDefaultOnce, BMBufferPoolInitializeDefault);
+    return BMBufferPoolDefault;
+}
+
+
+void *BMBufferPoolAllocate(BMBufferPool *pool, size_t length)
+{
+    size_t i = BMBufferPoolGetClass(length);
+    size_t classLength = BMBufferPoolGetClassLength(i);
+    void *buffer;
+    pthread_mutex_lock(&pool->mutex);
+    buffer = pool->freeLists[i];
+    if (buffer) {
+        memcpy(&pool->freeLists[i], buffer, sizeof(void *));
+        pool->retainedLength -= classLength;
+        pool->hits++;
+    }
+    else {
+        pool->misses++;
+    }
+    pool->outstandingLength += classLength;
+    pthread_mutex_unlock(&pool->mutex);
+    
+    if (!buffer && posix_memalign(&buffer, BMBufferPoolAlignment, classLength) != 0) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->outstandingLength -= classLength;
+        pthread_mutex_unlock(&pool->mutex);
+        buffer = NULL;
+    }
+    return buffer;
+}
+
+
+void BMBufferPoolFree(BMBufferPool *pool, void *buffer, size_t length)
+{
+    if (buffer) {
+        size_t i = BMBufferPoolGetClass(length);
+        size_t classLength = BMBufferPoolGetClassLength(i);
+        pthread_mutex_lock(&pool->mutex);
+        pool->outstandingLength -= classLength;
+        if (pool->retainedLength + classLength <= pool->capacity) {
+            // Keep the buffer at the head, where it is found first while still warm
+            memcpy(buffer, &pool->freeLists[i], sizeof(void *));
+            pool->freeLists[i] = buffer;
+            pool->retainedLength += classLength;
+            buffer = NULL;
+        }
+        pthread_mutex_unlock(&pool->mutex);
+        free(buffer);
+    }
+}
+
+
+size_t BMBufferPoolGetCapacity(BMBufferPool *pool)
+{
+    pthread_mutex_lock(&pool->mutex);
+    size_t capacity = pool->capacity;
+    pthread_mutex_unlock(&pool->mutex);
+    return capacity;
+}
+
+
+void BMBufferPoolSetCapacity(BMBufferPool *pool, size_t capacity)
+{
+    pthread_mutex_lock(&pool->mutex);
+    pool->capacity = capacity;
+    BMBufferPoolTrimToCapacity(pool, capacity);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+
+void BMBufferPoolTrim(BMBufferPool *pool)
+{
+    pthread_mutex_lock(&pool->mutex);
+    BMBufferPoolTrimToCapacity(pool, 0);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+
+void BMBufferPoolGetStats(BMBufferPool *pool, BMBufferPoolStats *stats)
+{
+    pthread_mutex_lock(&pool->mutex);
+    stats->hits = pool->hits;
+    stats->misses = pool->misses;
+    stats->retainedLength = pool->retainedLength;
+    stats->outstandingLength = pool->outstandingLength;
+    pthread_mutex_unlock(&pool->mutex);
+}
@@ -0,0 +1,83 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#ifndef __BMBUFFERPOOL__
+#define __BMBUFFERPOOL__
+
+#include <sys/cdefs.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+__BEGIN_DECLS
+
+/** Size of the smallest size class of a buffer pool (64 KiB). Each power of two above is split into four size classes, so a buffer wastes at most a quarter of its length. */
+#define BMBufferPoolMinLength ((size_t)64 << 10)
+
+/** Default capacity of the default buffer pool (64 MiB). */
+#define BMBufferPoolDefaultCapacity ((size_t)64 << 20)
+
+/** A thread-safe pool of large buffers, which keeps freed buffers in size classes to hand them out again, instead of returning them to the system and page faulting fresh memory on the next allocation. */
+typedef struct _BMBufferPool BMBufferPool;
+
+/** Counters of a buffer pool. */
+typedef struct _BMBufferPoolStats {
+    uint64_t hits;              /**< Allocations served from retained buffers. */
+    uint64_t misses;            /**< Allocations that had to allocate a new buffer. */
+    size_t   retainedLength;    /**< Bytes of freed buffers retained by the pool. */
+    size_t   outstandingLength; /**< Bytes of allocated buffers that were not freed yet. */
+} BMBufferPoolStats;
+
+/** Creates a buffer pool that retains at most _capacity_ bytes of freed buffers. Returns `NULL` if memory is exhausted. */
+extern BMBufferPool *BMBufferPoolCreate(size_t capacity);
+
+/** Destroys _pool_ and frees its retained buffers. Buffers that are still allocated from _pool_ must not be freed to it afterwards. */
+extern void BMBufferPoolDestroy(BMBufferPool *pool);
+
+/** Returns the buffer pool shared by the image utilities, with a capacity of `BMBufferPoolDefaultCapacity`. It is trimmed automatically when the system signals memory pressure. */
+extern BMBufferPool *BMBufferPoolGetDefault(void);
+
+/** Returns a buffer of at least _length_ bytes, aligned to 64 bytes, from _pool_ or `NULL` if memory is exhausted. The contents of the buffer are undefined. */
+extern void *BMBufferPoolAllocate(BMBufferPool *pool, size_t length);
+
+/** Returns a _buffer_ of _length_ bytes, which were requested from `BMBufferPoolAllocate`, to _pool_. The buffer is retained for later allocations if that does not exceed the capacity, otherwise it is returned to the system. */
+extern void BMBufferPoolFree(BMBufferPool *pool, void *buffer, size_t length);
+
+/** Returns the number of bytes of freed buffers _pool_ retains at most. */
+extern size_t BMBufferPoolGetCapacity(BMBufferPool *pool);
+
+/** Sets the number of bytes of freed buffers _pool_ retains at most, returning retained buffers to the system until _capacity_ is met. */
+extern void BMBufferPoolSetCapacity(BMBufferPool *pool, size_t capacity);
+
+/** Returns all buffers retained by _pool_ to the system. */
+extern void BMBufferPoolTrim(BMBufferPool *pool);
+
+/** Stores the counters of _pool_ in _stats_. */
+extern void BMBufferPoolGetStats(BMBufferPool *pool, BMBufferPoolStats *stats);
+
+__END_DECLS
+
+#endif /* !__BMBUFFERPOOL__ */
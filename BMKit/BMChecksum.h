@@ -0,0 +1,135 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+#include "BMChecksumUtilities.h"
+
+
+/** You use a checksum object to compute a fast, non-cryptographic checksum incrementally, for example as a cache key or for change detection over the contents of a file.
+ 
+ A checksum object supports all checksum algorithms, see `BMChecksumAlgorithm`. Unlike a `BMDigest` object, the current checksum can be queried at any time without affecting the computation. Checksum objects are not thread-safe.
+ 
+ @see BMDigest
+ */
+@interface BMChecksum : NSObject <NSCopying> {
+@private
+    BMChecksumContext _context;
+}
+
+/** The checksum algorithm of the receiver. */
+@property (nonatomic, assign, readonly) BMChecksumAlgorithm algorithm;
+
+/** The seed of the receiver. */
+@property (nonatomic, assign, readonly) uint64_t seed;
+
+/** The checksum of all bytes added to the receiver so far. */
+@property (nonatomic, assign, readonly) uint64_t checksum;
+
+///---------------------------------
+/// @name Creating Checksum Objects
+///---------------------------------
+
+/** Creates and returns a checksum object for the given algorithm.
+ 
+ @param algorithm The checksum algorithm.
+ @return A new checksum object, or `nil` if *algorithm* is invalid.
+ @see initWithAlgorithm:seed:
+ */
++ (id)checksumWithAlgorithm:(BMChecksumAlgorithm)algorithm;
+
+/** Initializes the receiver with the given algorithm and a seed of 0.
+ 
+ @param algorithm The checksum algorithm.
+ @return The initialized receiver, or `nil` if *algorithm* is invalid.
+ @see initWithAlgorithm:seed:
+ */
+- (id)initWithAlgorithm:(BMChecksumAlgorithm)algorithm;
+
+/** Initializes the receiver with the given algorithm and seed.
+ 
+ @param algorithm The checksum algorithm.
+ @param seed The seed, see `BMChecksumInit`.
+ @return The initialized receiver, or `nil` if *algorithm* is invalid.
+ @see checksumWithAlgorithm:
+ */
+- (id)initWithAlgorithm:(BMChecksumAlgorithm)algorithm seed:(uint64_t)seed;
+
+///---------------------------
+/// @name Computing Checksums
+///---------------------------
+
+/** Adds bytes to the checksum computation.
+ 
+ @param bytes The bytes to add.
+ @param length The number of bytes to add.
+ @see updateWithData:
+ */
+- (void)updateWithBytes:(const void *)bytes length:(NSUInteger)length;
+
+/** Adds the bytes of the data object to the checksum computation.
+ 
+ @param data The data to add.
+ @see updateWithBytes:length:
+ */
+- (void)updateWithData:(NSData *)data;
+
+/** Adds the contents of a file to the checksum computation.
+ 
+ Regular files are mapped into memory window by window instead of being read into memory as a whole, see `BMFileEnumerateWindows`.
+ 
+ @param path The path of the file to read.
+ @return `YES` if the file was read successfully, `NO` otherwise.
+ @see updateWithContentsOfFileDescriptor:
+ */
+- (BOOL)updateWithContentsOfFile:(NSString *)path;
+
+/** Adds the contents of a file descriptor, from its current offset to its end, to the checksum computation.
+ 
+ @param fd The file descriptor to read.
+ @return `YES` if the file was read successfully, `NO` otherwise.
+ @see updateWithContentsOfFile:
+ */
+- (BOOL)updateWithContentsOfFileDescriptor:(int)fd;
+
+/** Resets the receiver for a new computation with the same algorithm and seed. */
+- (void)reset;
+
+///-------------------------------------
+/// @name Computing Checksums in Batch
+///-------------------------------------
+
+/** Computes the checksums of several data objects, without allocating any objects.
+ 
+ @param checksums The buffer that receives the checksums in the order of *dataObjects*. It must hold at least `[dataObjects count]` elements.
+ @param dataObjects An array of `NSData` objects.
+ @param algorithm The checksum algorithm.
+ @return `YES` if the checksums were stored in *checksums*, `NO` if *algorithm* is invalid.
+ */
++ (BOOL)getChecksums:(uint64_t *)checksums ofDataObjects:(NSArray *)dataObjects algorithm:(BMChecksumAlgorithm)algorithm;
+
+@end
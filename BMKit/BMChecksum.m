@@ -0,0 +1,159 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#import "BMChecksum.h"
+
+
+@implementation BMChecksum
+
+
++ (id)checksumWithAlgorithm:(BMChecksumAlgorithm)algorithm
+{
+    return [[[self alloc] initWithAlgorithm:algorithm] autorelease];
+}
+
+
+- (id)init
+{
+    return [self initWithAlgorithm:BMChecksumAlgorithmXXH3];
+}
+
+
+- (id)initWithAlgorithm:(BMChecksumAlgorithm)algorithm
+{
+    return [self initWithAlgorithm:algorithm seed:0];
+}
+
+
+- (id)initWithAlgorithm:(BMChecksumAlgorithm)algorithm seed:(uint64_t)seed
+{
+    self = [super init];
+    if (self) {
+        if (!BMChecksumInit(&_context, algorithm, seed)) {
+            [self release];
+            return nil;
+        }
+    }
+    return self;
+}
+
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    BMChecksum *checksum = [[[self class] allocWithZone:zone] initWithAlgorithm:_context.algorithm seed:_context.seed];
+    if (checksum) {
+        // The context is plain old data, so the copy continues the computation independently
+        checksum->_context = _context;
+    }
+    return checksum;
+}
+
+
+#pragma mark -
+#pragma mark Properties
+
+
+- (BMChecksumAlgorithm)algorithm
+{
+    return _context.algorithm;
+}
+
+
+- (uint64_t)seed
+{
+    return _context.seed;
+}
+
+
+- (uint64_t)checksum
+{
+    return BMChecksumFinal(&_context);
+}
+
+
+#pragma mark -
+#pragma mark Computing Checksums
+
+
+- (void)updateWithBytes:(const void *)bytes length:(NSUInteger)length
+{
+    BMChecksumUpdate(&_context, bytes, length);
+}
+
+
+- (void)updateWithData:(NSData *)data
+{
+    BMChecksumUpdate(&_context, [data bytes], [data length]);
+}
+
+
+- (BOOL)updateWithContentsOfFile:(NSString *)path
+{
+    BOOL succeeded = NO;
+    if ([path length]) {
+        int fd = open([path fileSystemRepresentation], O_RDONLY);
+        if (fd >= 0) {
+            succeeded = [self updateWithContentsOfFileDescriptor:fd];
+            close(fd);
+        }
+    }
+    return succeeded;
+}
+
+
+- (BOOL)updateWithContentsOfFileDescriptor:(int)fd
+{
+    return BMChecksumUpdateWithFile(&_context, fd);
+}
+
+
+- (void)reset
+{
+    BMChecksumInit(&_context, _context.algorithm, _context.seed);
+}
+
+
+#pragma mark -
+#pragma mark Computing Checksums in Batch
+
+
++ (BOOL)getChecksums:(uint64_t *)checksums ofDataObjects:(NSArray *)dataObjects algorithm:(BMChecksumAlgorithm)algorithm
+{
+    if ((unsigned)algorithm >= BMChecksumAlgorithmCount) {
+        return NO;
+    }
+    for (NSData *data in dataObjects) {
+        BMChecksumCompute(algorithm, 0, [data bytes], [data length], checksums++);
+    }
+    return YES;
+}
+
+
+@end
@@ -0,0 +1,764 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#include "BMChecksumUtilities.h"
+#include "BMFileUtilities.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+# define BMCHECKSUM_X86 1
+# include <cpuid.h>
+# include <immintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+# define BMCHECKSUM_ARMV8 1
+# include <arm_acle.h>
+#endif
+
+
+#pragma mark -
+#pragma mark Helpers
+
+
+static inline uint32_t BMChecksumReadLE32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+
+static inline uint64_t BMChecksumReadLE64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+
+static inline void BMChecksumWriteLE64(uint8_t *p, uint64_t v)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    memcpy(p, &v, sizeof(v));
+}
+
+
+static inline uint64_t BMChecksumRotl64(uint64_t x, unsigned r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+
+static inline uint64_t BMChecksumMul128Fold64(uint64_t lhs, uint64_t rhs)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t product = (__uint128_t)lhs * rhs;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+#else
+    uint64_t lo_lo = (lhs & 0xffffffff) * (rhs & 0xffffffff);
+    uint64_t hi_lo = (lhs >> 32) * (rhs & 0xffffffff);
+    uint64_t lo_hi = (lhs & 0xffffffff) * (rhs >> 32);
+    uint64_t hi_hi = (lhs >> 32) * (rhs >> 32);
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+    uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    uint64_t lower = (cross << 32) | (lo_lo & 0xffffffff);
+    return lower ^ upper;
+#endif
+}
+
+
+#pragma mark -
+#pragma mark CRC-32C
+
+
+// Reflected Castagnoli polynomial
+#define BMCRC32CPolynomial 0x82f63b78u
+
+typedef uint32_t (*BMCRC32CKernel)(uint32_t crc, const uint8_t *bytes, size_t length);
+
+static uint32_t       BMCRC32CTable[8][256];
+static pthread_once_t BMCRC32COnce = PTHREAD_ONCE_INIT;
+
+
+static uint32_t BMCRC32CTableKernel(uint32_t crc, const uint8_t *bytes, size_t length)
+{
+    // Slicing-by-8, processes eight bytes per table round
+    for (; length && ((uintptr_t)bytes & 7); --length) {
+        crc = BMCRC32CTable[0][(crc ^ *bytes++) & 0xff] ^ (crc >> 8);
+    }
+    for (; length >= 8; length -= 8, bytes += 8) {
+        uint32_t lo = BMChecksumReadLE32(bytes) ^ crc;
+        uint32_t hi = BMChecksumReadLE32(bytes + 4);
+        crc = BMCRC32CTable[7][lo & 0xff] ^ BMCRC32CTable[6][(lo >> 8) & 0xff]
+            ^ BMCRC32CTable[5][(lo >> 16) & 0xff] ^ BMCRC32CTable[4][lo >> 24]
+            ^ BMCRC32CTable[3][hi & 0xff] ^ BMCRC32CTable[2][(hi >> 8) & 0xff]
+            ^ BMCRC32CTable[1][(hi >> 16) & 0xff] ^ BMCRC32CTable[0][hi >> 24];
+    }
+    for (; length; --length) {
+        crc = BMCRC32CTable[0][(crc ^ *bytes++) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+
+#if defined(BMCHECKSUM_X86)
+
+__attribute__((target("sse4.2")))
+static uint32_t BMCRC32CSSE42Kernel(uint32_t crc, const uint8_t *bytes, size_t length)
+{
+    for (; length && ((uintptr_t)bytes & 7); --length) {
+        crc = _mm_crc32_u8(crc, *bytes++);
+    }
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    for (; length >= 8; length -= 8, bytes += 8) {
+        uint64_t v;
+        memcpy(&v, bytes, sizeof(v));
+        crc64 = _mm_crc32_u64(crc64, v);
+    }
+    crc = (uint32_t)crc64;
+#endif
+    for (; length >= 4; length -= 4, bytes += 4) {
+        uint32_t v;
+        memcpy(&v, bytes, sizeof(v));
+        crc = _mm_crc32_u32(crc, v);
+    }
+    for (; length; --length) {
+        crc = _mm_crc32_u8(crc, *bytes++);
+    }
+    return crc;
+}
+
+
+static bool BMCRC32CCPUSupportsSSE42(void)
+{
+    unsigned eax, ebx, ecx, edx;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_2);
+}
+
+#elif defined(BMCHECKSUM_ARMV8)
+
+static uint32_t BMCRC32CARMv8Kernel(uint32_t crc, const uint8_t *bytes, size_t length)
+{
+    for (; length && ((uintptr_t)bytes & 7); --length) {
+        crc = __crc32cb(crc, *bytes++);
+    }
+    for (; length >= 8; length -= 8, bytes += 8) {
+        uint64_t v;
+        memcpy(&v, bytes, sizeof(v));
+        crc = __crc32cd(crc, v);
+    }
+    for (; length; --length) {
+        crc = __crc32cb(crc, *bytes++);
+    }
+    return crc;
+}
+
+#endif
+
+
+static BMCRC32CKernel BMCRC32CUpdater = BMCRC32CTableKernel;
+
+
+static void BMCRC32CInitialize(void)
+{
+    for (unsigned n = 0; n < 256; ++n) {
+        uint32_t crc = n;
+        for (unsigned k = 0; k < 8; ++k) {
+            crc = (crc & 1) ? (crc >> 1) ^ BMCRC32CPolynomial : (crc >> 1);
+        }
+        BMCRC32CTable[0][n] = crc;
+    }
+    for (unsigned n = 0; n < 256; ++n) {
+        for (unsigned k = 1; k < 8; ++k) {
+            BMCRC32CTable[k][n] = BMCRC32CTable[0][BMCRC32CTable[k - 1][n] & 0xff] ^ (BMCRC32CTable[k - 1][n] >> 8);
+        }
+    }
+#if defined(BMCHECKSUM_X86)
+    if (BMCRC32CCPUSupportsSSE42()) {
+        BMCRC32CUpdater = BMCRC32CSSE42Kernel;
+    }
+#elif defined(BMCHECKSUM_ARMV8)
+    BMCRC32CUpdater = BMCRC32CARMv8Kernel;
+#endif
+}
+
+
+static inline uint32_t BMCRC32CUpdate(uint32_t crc, const void *bytes, size_t length)
+{
+    pthread_once(&BMCRC32COnce, BMCRC32CInitialize);
+    return BMCRC32CUpdater(crc, (const uint8_t *)bytes, length);
+}
+
+
+#pragma mark -
+#pragma mark xxHash64
+
+
+#define BMXXH32Prime1 0x9e3779b1u
+#define BMXXH32Prime2 0x85ebca77u
+#define BMXXH32Prime3 0xc2b2ae3du
+#define BMXXH64Prime1 0x9e3779b185ebca87ull
+#define BMXXH64Prime2 0xc2b2ae3d27d4eb4full
+#define BMXXH64Prime3 0x165667b19e3779f9ull
+#define BMXXH64Prime4 0x85ebca77c2b2ae63ull
+#define BMXXH64Prime5 0x27d4eb2f165667c5ull
+
+
+static inline uint64_t BMXXH64Round(uint64_t acc, uint64_t input)
+{
+    acc += input * BMXXH64Prime2;
+    return BMChecksumRotl64(acc, 31) * BMXXH64Prime1;
+}
+
+
+static inline uint64_t BMXXH64MergeRound(uint64_t acc, uint64_t v)
+{
+    acc ^= BMXXH64Round(0, v);
+    return acc * BMXXH64Prime1 + BMXXH64Prime4;
+}
+
+
+static inline uint64_t BMXXH64Avalanche(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= BMXXH64Prime2;
+    h ^= h >> 29;
+    h *= BMXXH64Prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+
+static const uint8_t *BMXXH64Stripes(uint64_t v[4], const uint8_t *p, const uint8_t *limit)
+{
+    uint64_t v1 = v[0], v2 = v[1], v3 = v[2], v4 = v[3];
+    for (; p + 32 <= limit; p += 32) {
+        v1 = BMXXH64Round(v1, BMChecksumReadLE64(p));
+        v2 = BMXXH64Round(v2, BMChecksumReadLE64(p + 8));
+        v3 = BMXXH64Round(v3, BMChecksumReadLE64(p + 16));
+        v4 = BMXXH64Round(v4, BMChecksumReadLE64(p + 24));
+    }
+    v[0] = v1, v[1] = v2, v[2] = v3, v[3] = v4;
+    return p;
+}
+
+
+static uint64_t BMXXH64Finalize(uint64_t h, const uint8_t *p, size_t length)
+{
+    for (; length >= 8; length -= 8, p += 8) {
+        h ^= BMXXH64Round(0, BMChecksumReadLE64(p));
+        h = BMChecksumRotl64(h, 27) * BMXXH64Prime1 + BMXXH64Prime4;
+    }
+    if (length >= 4) {
+        h ^= (uint64_t)BMChecksumReadLE32(p) * BMXXH64Prime1;
+        h = BMChecksumRotl64(h, 23) * BMXXH64Prime2 + BMXXH64Prime3;
+        length -= 4, p += 4;
+    }
+    for (; length; --length) {
+        h ^= (*p++) * BMXXH64Prime5;
+        h = BMChecksumRotl64(h, 11) * BMXXH64Prime1;
+    }
+    return BMXXH64Avalanche(h);
+}
+
+
+static void BMXXH64Init(uint64_t v[4], uint64_t seed)
+{
+    v[0] = seed + BMXXH64Prime1 + BMXXH64Prime2;
+    v[1] = seed + BMXXH64Prime2;
+    v[2] = seed;
+    v[3] = seed - BMXXH64Prime1;
+}
+
+
+static uint64_t BMXXH64Merge(const uint64_t v[4], uint64_t seed, uint64_t length)
+{
+    uint64_t h;
+    if (length >= 32) {
+        h = BMChecksumRotl64(v[0], 1) + BMChecksumRotl64(v[1], 7) + BMChecksumRotl64(v[2], 12) + BMChecksumRotl64(v[3], 18);
+        h = BMXXH64MergeRound(h, v[0]);
+        h = BMXXH64MergeRound(h, v[1]);
+        h = BMXXH64MergeRound(h, v[2]);
+        h = BMXXH64MergeRound(h, v[3]);
+    }
+    else {
+        h = seed + BMXXH64Prime5;
+    }
+    return h + length;
+}
+
+
+static uint64_t BMXXH64Compute(const uint8_t *bytes, size_t length, uint64_t seed)
+{
+    uint64_t v[4];
+    BMXXH64Init(v, seed);
+    const uint8_t *p = BMXXH64Stripes(v, bytes, bytes + length);
+    return BMXXH64Finalize(BMXXH64Merge(v, seed, length), p, length - (size_t)(p - bytes));
+}
+
+
+#pragma mark -
+#pragma mark XXH3
+
+
+#define BMXXH3SecretLength     192
+#define BMXXH3StripeLength     64
+#define BMXXH3StripesPerBlock  ((BMXXH3SecretLength - BMXXH3StripeLength) / 8)
+#define BMXXH3MidSizeMax       240
+#define BMXXH3PrimeMX1         0x165667919e3779f9ull
+#define BMXXH3PrimeMX2         0x9fb21c651e98df25ull
+
+static const uint8_t BMXXH3DefaultSecret[BMXXH3SecretLength] =
+{
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+};
+
+
+static inline uint64_t BMXXH3Avalanche(uint64_t h)
+{
+    h ^= h >> 37;
+    h *= BMXXH3PrimeMX1;
+    return h ^ (h >> 32);
+}
+
+
+static inline uint64_t BMXXH3Rrmxmx(uint64_t h, uint64_t length)
+{
+    h ^= BMChecksumRotl64(h, 49) ^ BMChecksumRotl64(h, 24);
+    h *= BMXXH3PrimeMX2;
+    h ^= (h >> 35) + length;
+    h *= BMXXH3PrimeMX2;
+    return h ^ (h >> 28);
+}
+
+
+static inline uint64_t BMXXH3Mix16(const uint8_t *p, const uint8_t *secret, uint64_t seed)
+{
+    return BMChecksumMul128Fold64(BMChecksumReadLE64(p) ^ (BMChecksumReadLE64(secret) + seed),
+                                  BMChecksumReadLE64(p + 8) ^ (BMChecksumReadLE64(secret + 8) - seed));
+}
+
+
+static uint64_t BMXXH3ComputeShort(const uint8_t *p, size_t length, uint64_t seed)
+{
+    const uint8_t *secret = BMXXH3DefaultSecret;
+    if (length > 128) {
+        uint64_t acc = length * BMXXH64Prime1;
+        size_t rounds = length / 16;
+        for (size_t i = 0; i < 8; ++i) {
+            acc += BMXXH3Mix16(p + 16 * i, secret + 16 * i, seed);
+        }
+        acc = BMXXH3Avalanche(acc);
+        for (size_t i = 8; i < rounds; ++i) {
+            acc += BMXXH3Mix16(p + 16 * i, secret + 16 * (i - 8) + 3, seed);
+        }
+        acc += BMXXH3Mix16(p + length - 16, secret + 136 - 17, seed);
+        return BMXXH3Avalanche(acc);
+    }
+    if (length > 16) {
+        uint64_t acc = length * BMXXH64Prime1;
+        if (length > 32) {
+            if (length > 64) {
+                if (length > 96) {
+                    acc += BMXXH3Mix16(p + 48, secret + 96, seed);
+                    acc += BMXXH3Mix16(p + length - 64, secret + 112, seed);
+                }
+                acc += BMXXH3Mix16(p + 32, secret + 64, seed);
+                acc += BMXXH3Mix16(p + length - 48, secret + 80, seed);
+            }
+            acc += BMXXH3Mix16(p + 16, secret + 32, seed);
+            acc += BMXXH3Mix16(p + length - 32, secret + 48, seed);
+        }
+        acc += BMXXH3Mix16(p, secret, seed);
+        acc += BMXXH3Mix16(p + length - 16, secret + 16, seed);
+        return BMXXH3Avalanche(acc);
+    }
+    if (length > 8) {
+        uint64_t lo = BMChecksumReadLE64(p) ^ ((BMChecksumReadLE64(secret + 24) ^ BMChecksumReadLE64(secret + 32)) + seed);
+        uint64_t hi = BMChecksumReadLE64(p + length - 8) ^ ((BMChecksumReadLE64(secret + 40) ^ BMChecksumReadLE64(secret + 48)) - seed);
+        return BMXXH3Avalanche(length + __builtin_bswap64(lo) + hi + BMChecksumMul128Fold64(lo, hi));
+    }
+    if (length >= 4) {
+        seed ^= (uint64_t)__builtin_bswap32((uint32_t)seed) << 32;
+        uint64_t input = BMChecksumReadLE32(p + length - 4) + ((uint64_t)BMChecksumReadLE32(p) << 32);
+        uint64_t bitflip = (BMChecksumReadLE64(secret + 8) ^ BMChecksumReadLE64(secret + 16)) - seed;
+        return BMXXH3Rrmxmx(input ^ bitflip, length);
+    }
+    if (length) {
+        uint32_t combined = ((uint32_t)p[0] << 16) | ((uint32_t)p[length >> 1] << 24) | p[length - 1] | ((uint32_t)length << 8);
+        uint64_t bitflip = (BMChecksumReadLE32(secret) ^ BMChecksumReadLE32(secret + 4)) + seed;
+        return BMXXH64Avalanche(combined ^ bitflip);
+    }
+    return BMXXH64Avalanche(seed ^ BMChecksumReadLE64(secret + 56) ^ BMChecksumReadLE64(secret + 64));
+}
+
+
+#if defined(__SSE2__)
+
+static inline void BMXXH3Accumulate512(uint64_t acc[8], const uint8_t *p, const uint8_t *secret)
+{
+    for (size_t i = 0; i < 4; ++i) {
+        __m128i data = _mm_loadu_si128((const __m128i *)(p + 16 * i));
+        __m128i key = _mm_xor_si128(data, _mm_loadu_si128((const __m128i *)(secret + 16 * i)));
+        __m128i product = _mm_mul_epu32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+        __m128i sum = _mm_add_epi64(_mm_loadu_si128((const __m128i *)(acc + 2 * i)), _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2)));
+        _mm_storeu_si128((__m128i *)(acc + 2 * i), _mm_add_epi64(product, sum));
+    }
+}
+
+
+static inline void BMXXH3Scramble(uint64_t acc[8], const uint8_t *secret)
+{
+    const __m128i prime = _mm_set1_epi32((int)BMXXH32Prime1);
+    for (size_t i = 0; i < 4; ++i) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(acc + 2 * i));
+        a = _mm_xor_si128(_mm_xor_si128(a, _mm_srli_epi64(a, 47)), _mm_loadu_si128((const __m128i *)(secret + 16 * i)));
+        __m128i lo = _mm_mul_epu32(a, prime);
+        __m128i hi = _mm_mul_epu32(_mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        _mm_storeu_si128((__m128i *)(acc + 2 * i), _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+    }
+}
+
+#else
+
+static inline void BMXXH3Accumulate512(uint64_t acc[8], const uint8_t *p, const uint8_t *secret)
+{
+    for (size_t i = 0; i < 8; ++i) {
+        uint64_t data = BMChecksumReadLE64(p + 8 * i);
+        uint64_t key = data ^ BMChecksumReadLE64(secret + 8 * i);
+        acc[i ^ 1] += data;
+        acc[i] += (uint64_t)(uint32_t)key * (key >> 32);
+    }
+}
+
+
+static inline void BMXXH3Scramble(uint64_t acc[8], const uint8_t *secret)
+{
+    for (size_t i = 0; i < 8; ++i) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= BMChecksumReadLE64(secret + 8 * i);
+        acc[i] = a * BMXXH32Prime1;
+    }
+}
+
+#endif
+
+
+static inline void BMXXH3Accumulate(uint64_t acc[8], const uint8_t *p, const uint8_t *secret, size_t stripes)
+{
+    for (size_t n = 0; n < stripes; ++n) {
+        BMXXH3Accumulate512(acc, p + n * BMXXH3StripeLength, secret + n * 8);
+    }
+}
+
+
+static void BMXXH3InitAccumulators(uint64_t acc[8])
+{
+    acc[0] = BMXXH32Prime3;
+    acc[1] = BMXXH64Prime1;
+    acc[2] = BMXXH64Prime2;
+    acc[3] = BMXXH64Prime3;
+    acc[4] = BMXXH64Prime4;
+    acc[5] = BMXXH32Prime2;
+    acc[6] = BMXXH64Prime5;
+    acc[7] = BMXXH32Prime1;
+}
+
+
+static void BMXXH3InitSecret(uint8_t secret[BMXXH3SecretLength], uint64_t seed)
+{
+    for (size_t i = 0; i < BMXXH3SecretLength; i += 16) {
+        BMChecksumWriteLE64(secret + i, BMChecksumReadLE64(BMXXH3DefaultSecret + i) + seed);
+        BMChecksumWriteLE64(secret + i + 8, BMChecksumReadLE64(BMXXH3DefaultSecret + i + 8) - seed);
+    }
+}
+
+
+static uint64_t BMXXH3MergeAccumulators(const uint64_t acc[8], const uint8_t *secret, uint64_t length)
+{
+    uint64_t result = length * BMXXH64Prime1;
+    for (size_t i = 0; i < 4; ++i) {
+        result += BMChecksumMul128Fold64(acc[2 * i] ^ BMChecksumReadLE64(secret + 11 + 16 * i),
+                                         acc[2 * i + 1] ^ BMChecksumReadLE64(secret + 11 + 16 * i + 8));
+    }
+    return BMXXH3Avalanche(result);
+}
+
+
+static uint64_t BMXXH3ComputeLong(const uint8_t *p, size_t length, uint64_t seed)
+{
+    uint8_t secret[BMXXH3SecretLength];
+    uint64_t acc[8];
+    const size_t blockLength = BMXXH3StripeLength * BMXXH3StripesPerBlock;
+    size_t blocks = (length - 1) / blockLength;
+    BMXXH3InitSecret(secret, seed);
+    BMXXH3InitAccumulators(acc);
+    for (size_t n = 0; n < blocks; ++n) {
+        BMXXH3Accumulate(acc, p + n * blockLength, secret, BMXXH3StripesPerBlock);
+        BMXXH3Scramble(acc, secret + BMXXH3SecretLength - BMXXH3StripeLength);
+    }
+    size_t stripes = ((length - 1) - blocks * blockLength) / BMXXH3StripeLength;
+    BMXXH3Accumulate(acc, p + blocks * blockLength, secret, stripes);
+    BMXXH3Accumulate512(acc, p + length - BMXXH3StripeLength, secret + BMXXH3SecretLength - BMXXH3StripeLength - 7);
+    return BMXXH3MergeAccumulators(acc, secret, length);
+}
+
+
+static uint64_t BMXXH3Compute(const uint8_t *bytes, size_t length, uint64_t seed)
+{
+    return (length <= BMXXH3MidSizeMax) ? BMXXH3ComputeShort(bytes, length, seed) : BMXXH3ComputeLong(bytes, length, seed);
+}
+
+
+// Feeds stripes into the accumulators, scrambling whenever a block is complete
+static void BMXXH3ConsumeStripes(uint64_t acc[8], size_t *stripesSoFar, const uint8_t *p, size_t stripes, const uint8_t *secret)
+{
+    if (BMXXH3StripesPerBlock - *stripesSoFar <= stripes) {
+        size_t stripesToEnd = BMXXH3StripesPerBlock - *stripesSoFar;
+        BMXXH3Accumulate(acc, p, secret + *stripesSoFar * 8, stripesToEnd);
+        BMXXH3Scramble(acc, secret + BMXXH3SecretLength - BMXXH3StripeLength);
+        BMXXH3Accumulate(acc, p + stripesToEnd * BMXXH3StripeLength, secret, stripes - stripesToEnd);
+        *stripesSoFar = stripes - stripesToEnd;
+    }
+    else {
+        BMXXH3Accumulate(acc, p, secret + *stripesSoFar * 8, stripes);
+        *stripesSoFar += stripes;
+    }
+}
+
+
+#pragma mark -
+#pragma mark Checksum Contexts
+
+
+bool BMChecksumInit(BMChecksumContext *context, BMChecksumAlgorithm algorithm, uint64_t seed)
+{
+    context->algorithm = algorithm;
+    context->seed = seed;
+    context->length = 0;
+    switch (algorithm) {
+        case BMChecksumAlgorithmCRC32C:
+            context->u.crc32c = ~(uint32_t)seed;
+            return true;
+        case BMChecksumAlgorithmXXH64:
+            BMXXH64Init(context->u.xxh64.v, seed);
+            return true;
+        case BMChecksumAlgorithmXXH3:
+            BMXXH3InitAccumulators(context->u.xxh3.acc);
+            BMXXH3InitSecret(context->u.xxh3.secret, seed);
+            context->u.xxh3.bufferLength = 0;
+            context->u.xxh3.stripes = 0;
+            return true;
+    }
+    return false;
+}
+
+
+static void BMXXH64Update(BMChecksumContext *context, const uint8_t *p, size_t length)
+{
+    uint8_t *buffer = context->u.xxh64.buffer;
+    size_t bufferLength = (size_t)(context->length % 32);
+    context->length += length;
+    if (bufferLength) {
+        size_t fill = 32 - bufferLength;
+        if (length < fill) {
+            memcpy(buffer + bufferLength, p, length);
+            return;
+        }
+        memcpy(buffer + bufferLength, p, fill);
+        BMXXH64Stripes(context->u.xxh64.v, buffer, buffer + 32);
+        p += fill;
+        length -= fill;
+    }
+    const uint8_t *q = BMXXH64Stripes(context->u.xxh64.v, p, p + length);
+    memcpy(buffer, q, length - (size_t)(q - p));
+}
+
+
+static void BMXXH3Update(BMChecksumContext *context, const uint8_t *p, size_t length)
+{
+    const size_t bufferCapacity = sizeof(context->u.xxh3.buffer);
+    const size_t bufferStripes = bufferCapacity / BMXXH3StripeLength;
+    uint8_t *buffer = context->u.xxh3.buffer;
+    context->length += length;
+    if (context->u.xxh3.bufferLength + length <= bufferCapacity) {
+        memcpy(buffer + context->u.xxh3.bufferLength, p, length);
+        context->u.xxh3.bufferLength += length;
+        return;
+    }
+    const uint8_t *end = p + length;
+    if (context->u.xxh3.bufferLength) {
+        size_t fill = bufferCapacity - context->u.xxh3.bufferLength;
+        memcpy(buffer + context->u.xxh3.bufferLength, p, fill);
+        p += fill;
+        BMXXH3ConsumeStripes(context->u.xxh3.acc, &context->u.xxh3.stripes, buffer, bufferStripes, context->u.xxh3.secret);
+        context->u.xxh3.bufferLength = 0;
+    }
+    if (p + bufferCapacity < end) {
+        // Always keep some input in the buffer, the last stripe is processed specially
+        do {
+            BMXXH3ConsumeStripes(context->u.xxh3.acc, &context->u.xxh3.stripes, p, bufferStripes, context->u.xxh3.secret);
+            p += bufferCapacity;
+        } while (p + bufferCapacity < end);
+        memcpy(buffer + bufferCapacity - BMXXH3StripeLength, p - BMXXH3StripeLength, BMXXH3StripeLength);
+    }
+    memcpy(buffer, p, (size_t)(end - p));
+    context->u.xxh3.bufferLength = (size_t)(end - p);
+}
+
+
+static uint64_t BMXXH3Final(const BMChecksumContext *context)
+{
+    const uint8_t *buffer = context->u.xxh3.buffer;
+    size_t bufferLength = context->u.xxh3.bufferLength;
+    if (context->length <= BMXXH3MidSizeMax) {
+        return BMXXH3ComputeShort(buffer, (size_t)context->length, context->seed);
+    }
+    uint64_t acc[8];
+    uint8_t lastStripe[BMXXH3StripeLength];
+    const uint8_t *secret = context->u.xxh3.secret;
+    const uint8_t *stripe = lastStripe;
+    memcpy(acc, context->u.xxh3.acc, sizeof(acc));
+    if (bufferLength >= BMXXH3StripeLength) {
+        size_t stripesSoFar = context->u.xxh3.stripes;
+        BMXXH3ConsumeStripes(acc, &stripesSoFar, buffer, (bufferLength - 1) / BMXXH3StripeLength, secret);
+        stripe = buffer + bufferLength - BMXXH3StripeLength;
+    }
+    else {
+        // Complete the last stripe with bytes from the previous buffer contents
+        size_t catchup = BMXXH3StripeLength - bufferLength;
+        memcpy(lastStripe, buffer + sizeof(context->u.xxh3.buffer) - catchup, catchup);
+        memcpy(lastStripe + catchup, buffer, bufferLength);
+    }
+    BMXXH3Accumulate512(acc, stripe, secret + BMXXH3SecretLength - BMXXH3StripeLength - 7);
+    return BMXXH3MergeAccumulators(acc, secret, context->length);
+}
+
+
+void BMChecksumUpdate(BMChecksumContext *context, const void *bytes, size_t length)
+{
+    switch (context->algorithm) {
+        case BMChecksumAlgorithmCRC32C:
+            context->u.crc32c = BMCRC32CUpdate(context->u.crc32c, bytes, length);
+            context->length += length;
+            break;
+        case BMChecksumAlgorithmXXH64:
+            BMXXH64Update(context, (const uint8_t *)bytes, length);
+            break;
+        case BMChecksumAlgorithmXXH3:
+            BMXXH3Update(context, (const uint8_t *)bytes, length);
+            break;
+    }
+}
+
+
+static bool BMChecksumFileWindowFunction(const void *bytes, size_t length, void *context)
+{
+    BMChecksumUpdate((BMChecksumContext *)context, bytes, length);
+    return true;
+}
+
+
+bool BMChecksumUpdateWithFile(BMChecksumContext *context, int fd)
+{
+    return BMFileEnumerateWindows(fd, BMChecksumFileWindowFunction, context);
+}
+
+
+uint64_t BMChecksumFinal(const BMChecksumContext *context)
+{
+    uint64_t checksum = 0;
+    switch (context->algorithm) {
+        case BMChecksumAlgorithmCRC32C:
+            checksum = ~context->u.crc32c;
+            break;
+        case BMChecksumAlgorithmXXH64: {
+            uint64_t h = BMXXH64Merge(context->u.xxh64.v, context->seed, context->length);
+            checksum = BMXXH64Finalize(h, context->u.xxh64.buffer, (size_t)(context->length % 32));
+            break;
+        }
+        case BMChecksumAlgorithmXXH3:
+            checksum = BMXXH3Final(context);
+            break;
+    }
+    return checksum;
+}
+
+
+#pragma mark -
+#pragma mark Computing Checksums in One Go
+
+
+bool BMChecksumCompute(BMChecksumAlgorithm algorithm, uint64_t seed, const void *bytes, size_t length, uint64_t *checksum)
+{
+    switch (algorithm) {
+        case BMChecksumAlgorithmCRC32C:
+            *checksum = ~BMCRC32CUpdate(~(uint32_t)seed, bytes, length);
+            return true;
+        case BMChecksumAlgorithmXXH64:
+            *checksum = BMXXH64Compute((const uint8_t *)bytes, length, seed);
+            return true;
+        case BMChecksumAlgorithmXXH3:
+            *checksum = BMXXH3Compute((const uint8_t *)bytes, length, seed);
+            return true;
+    }
+    return false;
+}
+
+
+bool BMChecksumComputeBatch(BMChecksumAlgorithm algorithm, uint64_t seed, const BMDigestRange *ranges, size_t count, uint64_t *checksums)
+{
+    if ((unsigned)algorithm >= BMChecksumAlgorithmCount) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        BMChecksumCompute(algorithm, seed, ranges[i].bytes, ranges[i].length, checksums + i);
+    }
+    return true;
+}
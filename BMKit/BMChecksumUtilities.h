@@ -0,0 +1,93 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __BMCHECKSUMUTILITIES__
+#define __BMCHECKSUMUTILITIES__
+
+#include <sys/cdefs.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "BMDigestUtilities.h"
+
+__BEGIN_DECLS
+
+/** Supported checksum algorithms.
+ 
+ Checksums are fast, non-cryptographic hash functions for cache keys and change detection, where the strength of a message digest is wasted. */
+typedef enum _BMChecksumAlgorithm {
+    BMChecksumAlgorithmCRC32C = 0,  /**< CRC-32C (Castagnoli), 32 bits, hardware accelerated where available. */
+    BMChecksumAlgorithmXXH64  = 1,  /**< xxHash64, 64 bits. */
+    BMChecksumAlgorithmXXH3   = 2   /**< XXH3 (64-bit variant), 64 bits. */
+} BMChecksumAlgorithm;
+
+/** The number of supported checksum algorithms. */
+#define BMChecksumAlgorithmCount 3
+
+/** State of an incremental checksum computation. */
+typedef struct _BMChecksumContext {
+    BMChecksumAlgorithm algorithm;
+    uint64_t            seed;
+    uint64_t            length;
+    union {
+        uint32_t crc32c;
+        struct {
+            uint64_t v[4];
+            uint8_t  buffer[32];
+        } xxh64;
+        struct {
+            uint64_t acc[8];
+            uint8_t  secret[192];
+            uint8_t  buffer[256];
+            size_t   bufferLength;
+            size_t   stripes;
+        } xxh3;
+    } u;
+} BMChecksumContext;
+
+/** Initializes _context_ for a new checksum computation using _algorithm_ and _seed_. For CRC-32C, the _seed_ is the checksum of preceding bytes, so pass 0 to start a new checksum. Returns `false` if _algorithm_ is invalid. */
+extern bool BMChecksumInit(BMChecksumContext *context, BMChecksumAlgorithm algorithm, uint64_t seed);
+
+/** Adds _length_ bytes from _bytes_ to the checksum computation. */
+extern void BMChecksumUpdate(BMChecksumContext *context, const void *bytes, size_t length);
+
+/** Adds the contents of the file descriptor _fd_, from its current offset to its end, to _context_, see `BMFileEnumerateWindows`. Returns `false` if an I/O error occurred. */
+extern bool BMChecksumUpdateWithFile(BMChecksumContext *context, int fd);
+
+/** Returns the checksum of all bytes added to _context_ so far. The _context_ is not modified, so more bytes may be added afterwards. */
+extern uint64_t BMChecksumFinal(const BMChecksumContext *context);
+
+/** Computes the checksum of _length_ bytes from _bytes_ using _algorithm_ and _seed_, and stores it in _checksum_. Returns `false` if _algorithm_ is invalid. */
+extern bool BMChecksumCompute(BMChecksumAlgorithm algorithm, uint64_t seed, const void *bytes, size_t length, uint64_t *checksum);
+
+/** Computes the checksums of _count_ byte _ranges_ using _algorithm_ and _seed_, and stores them in _checksums_, which must hold at least _count_ elements. Returns `false` if _algorithm_ is invalid. */
+extern bool BMChecksumComputeBatch(BMChecksumAlgorithm algorithm, uint64_t seed, const BMDigestRange *ranges, size_t count, uint64_t *checksums);
+
+__END_DECLS
+
+#endif /* !__BMCHECKSUMUTILITIES__ */
@@ -0,0 +1,48 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __BMCOLLECTIONUTILITIES__
+#define __BMCOLLECTIONUTILITIES__
+
+#import <Foundation/Foundation.h>
+
+#import "BMKitTypes.h"
+
+__BEGIN_DECLS
+
+/** Returns the number of objects per chunk for processing _count_ objects concurrently, which is _grainSize_, or a few chunks per core if _grainSize_ is 0. */
+extern NSUInteger BMCollectionGetChunkLength(NSUInteger count, NSUInteger grainSize);
+
+/** Moves the objects for which _predicateBlock_ returns `YES` to the front of _objects_, keeping their order, and returns their number. The chunks of _grainSize_ objects are filtered concurrently. Returns `NSNotFound` if memory cannot be allocated. */
+extern NSUInteger BMCollectionFilterObjects(id *objects, NSUInteger count, NSUInteger grainSize, BMPredicateBlock predicateBlock);
+
+/** Replaces every object in _objects_ with the result of _aTransformator_, or `NSNull` if the result is `nil`, which is retained and must be released by the caller. The chunks of _grainSize_ objects are transformed concurrently. */
+extern void BMCollectionTransformObjects(id *objects, NSUInteger count, NSUInteger grainSize, BMTransformator aTransformator);
+
+__END_DECLS
+
+#endif /* !__BMCOLLECTIONUTILITIES__ */
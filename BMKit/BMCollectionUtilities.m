@@ -0,0 +1,94 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <dispatch/dispatch.h>
+
+#import "BMCollectionUtilities.h"
+
+
+NSUInteger BMCollectionGetChunkLength(NSUInteger count, NSUInteger grainSize)
+{
+    if (!grainSize) {
+        // A few chunks per core, so that chunks that take longer even out
+        NSUInteger numberOfChunks = 4 * [[NSProcessInfo processInfo] activeProcessorCount];
+        grainSize = (count + numberOfChunks - 1) / numberOfChunks;
+    }
+    return grainSize ? grainSize : 1;
+}
+
+
+NSUInteger BMCollectionFilterObjects(id *objects, NSUInteger count, NSUInteger grainSize, BMPredicateBlock predicateBlock)
+{
+    NSUInteger chunkLength = BMCollectionGetChunkLength(count, grainSize);
+    NSUInteger numberOfChunks = (count + chunkLength - 1) / chunkLength;
+    NSUInteger *counts = (NSUInteger *)malloc((numberOfChunks + 1) * sizeof(NSUInteger));
+    if (!counts) {
+        return NSNotFound;
+    }
+    
+    // Each chunk moves its survivors to its front and counts them
+    dispatch_apply(numberOfChunks, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        NSUInteger i = chunk * chunkLength, j = i, end = MIN(i + chunkLength, count);
+        for (; i < end; ++i) {
+            id object = objects[i];
+            if (predicateBlock(object)) {
+                objects[j++] = object;
+            }
+        }
+        counts[chunk] = j - chunk * chunkLength;
+        [pool drain];
+    });
+    
+    // The prefix sums of the counts are the final positions of the survivors
+    // of each chunk, which never lie behind their current positions
+    NSUInteger j = 0;
+    for (NSUInteger chunk = 0; chunk < numberOfChunks; ++chunk) {
+        memmove(objects + j, objects + chunk * chunkLength, counts[chunk] * sizeof(id));
+        j += counts[chunk];
+    }
+    free(counts);
+    return j;
+}
+
+
+void BMCollectionTransformObjects(id *objects, NSUInteger count, NSUInteger grainSize, BMTransformator aTransformator)
+{
+    NSUInteger chunkLength = BMCollectionGetChunkLength(count, grainSize);
+    NSUInteger numberOfChunks = (count + chunkLength - 1) / chunkLength;
+    
+    // The transformed objects are retained before the pool of their chunk
+    // is drained, and released by the caller once they are in place
+    dispatch_apply(numberOfChunks, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        NSUInteger end = MIN((chunk + 1) * chunkLength, count);
+        for (NSUInteger i = chunk * chunkLength; i < end; ++i) {
+            objects[i] = [(aTransformator(objects[i]) ?: [NSNull null]) retain];
+        }
+        [pool drain];
+    });
+}
@@ -0,0 +1,193 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+#include "BMDigestUtilities.h"
+
+
+/** You use a digest object to compute a message digest incrementally, for example over the contents of a file or a network stream, without buffering the complete input in memory.
+ 
+ A digest object supports all message digest algorithms of the `NSData` class, see `BMDigestAlgorithm`. After the final digest was retrieved, the receiver is reset and can be reused for a new computation. Digest objects are not thread-safe.
+ */
+@interface BMDigest : NSObject <NSCopying> {
+@private
+    BMDigestContext _context;
+}
+
+/** The message digest algorithm of the receiver. */
+@property (nonatomic, assign, readonly) BMDigestAlgorithm algorithm;
+
+/** The length of the message digest of the receiver in bytes. */
+@property (nonatomic, assign, readonly) NSUInteger digestLength;
+
+///-------------------------------
+/// @name Creating Digest Objects
+///-------------------------------
+
+/** Creates and returns a digest object for the given algorithm.
+ 
+ @param algorithm The message digest algorithm.
+ @return A new digest object, or `nil` if *algorithm* is invalid.
+ @see initWithAlgorithm:
+ */
++ (id)digestWithAlgorithm:(BMDigestAlgorithm)algorithm;
+
+/** Initializes the receiver with the given algorithm.
+ 
+ @param algorithm The message digest algorithm.
+ @return The initialized receiver, or `nil` if *algorithm* is invalid.
+ @see digestWithAlgorithm:
+ */
+- (id)initWithAlgorithm:(BMDigestAlgorithm)algorithm;
+
+///---------------------------------
+/// @name Computing Message Digests
+///---------------------------------
+
+/** Adds bytes to the message digest computation.
+ 
+ @param bytes The bytes to add.
+ @param length The number of bytes to add.
+ @see updateWithData:
+ */
+- (void)updateWithBytes:(const void *)bytes length:(NSUInteger)length;
+
+/** Adds the bytes of the data object to the message digest computation.
+ 
+ @param data The data to add.
+ @see updateWithBytes:length:
+ */
+- (void)updateWithData:(NSData *)data;
+
+/** Adds the remaining contents of an input stream to the message digest computation.
+ 
+ The input stream is read in fixed-size chunks until it reaches its end. If the stream is not open yet, it is opened and closed again afterwards.
+ 
+ @param inputStream The input stream to read.
+ @return `YES` if the input stream was read successfully, `NO` otherwise.
+ @see updateWithContentsOfFile:
+ */
+- (BOOL)updateWithContentsOfInputStream:(NSInputStream *)inputStream;
+
+/** Adds the contents of a file to the message digest computation.
+ 
+ Regular files are mapped into memory window by window instead of being read into memory as a whole, see `BMFileEnumerateWindows`.
+ 
+ @param path The path of the file to read.
+ @return `YES` if the file was read successfully, `NO` otherwise.
+ @see updateWithContentsOfFileDescriptor:
+ @see updateWithContentsOfInputStream:
+ */
+- (BOOL)updateWithContentsOfFile:(NSString *)path;
+
+/** Adds the contents of a file descriptor, from its current offset to its end, to the message digest computation.
+ 
+ Regular files are mapped into memory window by window, other files like pipes are read in fixed-size chunks.
+ 
+ @param fd The file descriptor to read.
+ @return `YES` if the file was read successfully, `NO` otherwise.
+ @see updateWithContentsOfFile:
+ */
+- (BOOL)updateWithContentsOfFileDescriptor:(int)fd;
+
+/** Finishes the message digest computation and returns the message digest.
+ 
+ The receiver is reset afterwards, and can be reused for a new computation.
+ 
+ @return The message digest of all bytes added to the receiver.
+ */
+- (NSData *)finalDigest;
+
+/** Finishes the message digest computation and stores the message digest in a buffer, without allocating any objects.
+ 
+ The receiver is reset afterwards, and can be reused for a new computation.
+ 
+ @param buffer The buffer that receives the message digest. It must hold at least digestLength bytes.
+ @return The number of bytes stored in *buffer*.
+ @see finalDigest
+ */
+- (NSUInteger)getFinalDigest:(void *)buffer;
+
+///--------------------------------------------
+/// @name Computing Message Digests in One Go
+///--------------------------------------------
+
+/** Returns the message digest of the contents of an input stream.
+ 
+ @param inputStream The input stream to read.
+ @param algorithm The message digest algorithm.
+ @return The message digest of the contents of *inputStream*, or `nil` in case of an error.
+ @see digestOfContentsOfFile:algorithm:
+ */
++ (NSData *)digestOfContentsOfInputStream:(NSInputStream *)inputStream algorithm:(BMDigestAlgorithm)algorithm;
+
+/** Returns the message digest of the contents of a file.
+ 
+ @param path The path of the file to read.
+ @param algorithm The message digest algorithm.
+ @return The message digest of the contents of the file at *path*, or `nil` in case of an error.
+ @see digestOfContentsOfFileDescriptor:algorithm:
+ @see digestOfContentsOfInputStream:algorithm:
+ */
++ (NSData *)digestOfContentsOfFile:(NSString *)path algorithm:(BMDigestAlgorithm)algorithm;
+
+/** Returns the message digest of the contents of a file descriptor, from its current offset to its end.
+ 
+ @param fd The file descriptor to read.
+ @param algorithm The message digest algorithm.
+ @return The message digest of the contents of *fd*, or `nil` in case of an error.
+ @see digestOfContentsOfFile:algorithm:
+ */
++ (NSData *)digestOfContentsOfFileDescriptor:(int)fd algorithm:(BMDigestAlgorithm)algorithm;
+
+///------------------------------------------
+/// @name Computing Message Digests in Batch
+///------------------------------------------
+
+/** Computes the message digests of several data objects into a buffer, without allocating any objects.
+ 
+ The message digests are packed contiguously in the order of *dataObjects*, so the message digest of the i-th data object starts at byte `i * BMDigestGetLength(algorithm)` of *buffer*.
+ 
+ @param buffer The buffer that receives the message digests. It must hold at least `[dataObjects count] * BMDigestGetLength(algorithm)` bytes.
+ @param dataObjects An array of `NSData` objects.
+ @param algorithm The message digest algorithm.
+ @return `YES` if the message digests were stored in *buffer*, `NO` if *algorithm* is invalid.
+ @see digestsOfDataObjects:algorithm:
+ */
++ (BOOL)getDigests:(void *)buffer ofDataObjects:(NSArray *)dataObjects algorithm:(BMDigestAlgorithm)algorithm;
+
+/** Returns the message digests of several data objects packed contiguously into a single data object.
+ 
+ @param dataObjects An array of `NSData` objects.
+ @param algorithm The message digest algorithm.
+ @return The message digests of *dataObjects* packed contiguously, or `nil` if *algorithm* is invalid.
+ @see getDigests:ofDataObjects:algorithm:
+ */
++ (NSData *)digestsOfDataObjects:(NSArray *)dataObjects algorithm:(BMDigestAlgorithm)algorithm;
+
+@end
@@ -0,0 +1,226 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#import "BMDigest.h"
+
+
+// Number of bytes read from input streams at once
+#define BMDigestInputStreamChunkLength ((NSUInteger)(64 * 1024))
+
+
+@implementation BMDigest
+
+
++ (id)digestWithAlgorithm:(BMDigestAlgorithm)algorithm
+{
+    return [[[self alloc] initWithAlgorithm:algorithm] autorelease];
+}
+
+
+- (id)init
+{
+    return [self initWithAlgorithm:BMDigestAlgorithmSHA1];
+}
+
+
+- (id)initWithAlgorithm:(BMDigestAlgorithm)algorithm
+{
+    self = [super init];
+    if (self) {
+        if (!BMDigestInit(&_context, algorithm)) {
+            [self release];
+            return nil;
+        }
+    }
+    return self;
+}
+
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    BMDigest *digest = [[[self class] allocWithZone:zone] initWithAlgorithm:_context.algorithm];
+    if (digest) {
+        // The context is plain old data, so the copy continues the computation independently
+        digest->_context = _context;
+    }
+    return digest;
+}
+
+
+#pragma mark -
+#pragma mark Properties
+
+
+- (BMDigestAlgorithm)algorithm
+{
+    return _context.algorithm;
+}
+
+
+- (NSUInteger)digestLength
+{
+    return BMDigestGetLength(_context.algorithm);
+}
+
+
+#pragma mark -
+#pragma mark Computing Message Digests
+
+
+- (void)updateWithBytes:(const void *)bytes length:(NSUInteger)length
+{
+    BMDigestUpdate(&_context, bytes, length);
+}
+
+
+- (void)updateWithData:(NSData *)data
+{
+    BMDigestUpdate(&_context, [data bytes], [data length]);
+}
+
+
+- (BOOL)updateWithContentsOfInputStream:(NSInputStream *)inputStream
+{
+    BOOL succeeded = NO;
+    if (inputStream) {
+        uint8_t *buffer = (uint8_t *)malloc(BMDigestInputStreamChunkLength);
+        if (buffer) {
+            BOOL opened = NO;
+            if ([inputStream streamStatus] == NSStreamStatusNotOpen) {
+                [inputStream open];
+                opened = YES;
+            }
+            for (;;) {
+                NSInteger length = [inputStream read:buffer maxLength:BMDigestInputStreamChunkLength];
+                if (length <= 0) {
+                    succeeded = (length == 0);
+                    break;
+                }
+                BMDigestUpdate(&_context, buffer, length);
+            }
+            if (opened) {
+                [inputStream close];
+            }
+            free(buffer);
+        }
+    }
+    return succeeded;
+}
+
+
+- (BOOL)updateWithContentsOfFile:(NSString *)path
+{
+    BOOL succeeded = NO;
+    if ([path length]) {
+        int fd = open([path fileSystemRepresentation], O_RDONLY);
+        if (fd >= 0) {
+            succeeded = [self updateWithContentsOfFileDescriptor:fd];
+            close(fd);
+        }
+    }
+    return succeeded;
+}
+
+
+- (BOOL)updateWithContentsOfFileDescriptor:(int)fd
+{
+    return BMDigestUpdateWithFile(&_context, fd);
+}
+
+
+- (NSData *)finalDigest
+{
+    UInt8 digest[BMDigestMaxLength];
+    NSUInteger digestLength = [self getFinalDigest:digest];
+    return [NSData dataWithBytes:digest length:digestLength];
+}
+
+
+- (NSUInteger)getFinalDigest:(void *)buffer
+{
+    BMDigestAlgorithm algorithm = _context.algorithm;
+    BMDigestFinal(&_context, buffer);
+    BMDigestInit(&_context, algorithm);
+    return BMDigestGetLength(algorithm);
+}
+
+
+#pragma mark -
+#pragma mark Computing Message Digests in One Go
+
+
++ (NSData *)digestOfContentsOfInputStream:(NSInputStream *)inputStream algorithm:(BMDigestAlgorithm)algorithm
+{
+    BMDigest *digest = [self digestWithAlgorithm:algorithm];
+    return [digest updateWithContentsOfInputStream:inputStream] ? [digest finalDigest] : nil;
+}
+
+
++ (NSData *)digestOfContentsOfFile:(NSString *)path algorithm:(BMDigestAlgorithm)algorithm
+{
+    BMDigest *digest = [self digestWithAlgorithm:algorithm];
+    return [digest updateWithContentsOfFile:path] ? [digest finalDigest] : nil;
+}
+
+
++ (NSData *)digestOfContentsOfFileDescriptor:(int)fd algorithm:(BMDigestAlgorithm)algorithm
+{
+    BMDigest *digest = [self digestWithAlgorithm:algorithm];
+    return [digest updateWithContentsOfFileDescriptor:fd] ? [digest finalDigest] : nil;
+}
+
+
+#pragma mark -
+#pragma mark Computing Message Digests in Batch
+
+
++ (BOOL)getDigests:(void *)buffer ofDataObjects:(NSArray *)dataObjects algorithm:(BMDigestAlgorithm)algorithm
+{
+    size_t digestLength = BMDigestGetLength(algorithm);
+    if (!digestLength) {
+        return NO;
+    }
+    UInt8 *digest = (UInt8 *)buffer;
+    for (NSData *data in dataObjects) {
+        BMDigestCompute(algorithm, [data bytes], [data length], digest);
+        digest += digestLength;
+    }
+    return YES;
+}
+
+
++ (NSData *)digestsOfDataObjects:(NSArray *)dataObjects algorithm:(BMDigestAlgorithm)algorithm
+{
+    NSMutableData *digests = [NSMutableData dataWithLength:[dataObjects count] * BMDigestGetLength(algorithm)];
+    return [self getDigests:[digests mutableBytes] ofDataObjects:dataObjects algorithm:algorithm] ? digests : nil;
+}
+
+
+@end
@@ -0,0 +1,943 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__APPLE__)
+# include <dispatch/dispatch.h>
+#endif
+
+#include "BMDigestUtilities.h"
+#include "BMFileUtilities.h"
+
+
+static const struct {
+    size_t length;
+    size_t blockSize;
+} BMDigestAlgorithmInfo[BMDigestAlgorithmCount] =
+{
+    { 16,  16 }, // MD2
+    { 16,  64 }, // MD4
+    { 16,  64 }, // MD5
+    { 20,  64 }, // SHA1
+    { 28,  64 }, // SHA224
+    { 32,  64 }, // SHA256
+    { 48, 128 }, // SHA384
+    { 64, 128 }  // SHA512
+};
+
+
+size_t BMDigestGetLength(BMDigestAlgorithm algorithm)
+{
+    return ((unsigned)algorithm < BMDigestAlgorithmCount) ? BMDigestAlgorithmInfo[algorithm].length : 0;
+}
+
+
+size_t BMDigestGetBlockSize(BMDigestAlgorithm algorithm)
+{
+    return ((unsigned)algorithm < BMDigestAlgorithmCount) ? BMDigestAlgorithmInfo[algorithm].blockSize : 0;
+}
+
+
+bool BMDigestCompute(BMDigestAlgorithm algorithm, const void *bytes, size_t length, void *digest)
+{
+    BMDigestContext context;
+    if (!BMDigestInit(&context, algorithm)) {
+        return false;
+    }
+    BMDigestUpdate(&context, bytes, length);
+    BMDigestFinal(&context, digest);
+    return true;
+}
+
+
+bool BMDigestComputeHex(BMDigestAlgorithm algorithm, const void *bytes, size_t length, char *buffer, BMHexEncodeOptions options)
+{
+    uint8_t digest[BMDigestMaxLength];
+    if (!BMDigestCompute(algorithm, bytes, length, digest)) {
+        return false;
+    }
+    buffer[BMHexEncode(digest, BMDigestGetLength(algorithm), buffer, options, '\0', 0)] = '\0';
+    return true;
+}
+
+
+bool BMDigestComputeBatch(BMDigestAlgorithm algorithm, const BMDigestRange *ranges, size_t count, void *digests)
+{
+    size_t digestLength = BMDigestGetLength(algorithm);
+    if (!digestLength) {
+        return false;
+    }
+    uint8_t *digest = (uint8_t *)digests;
+    for (size_t i = 0; i < count; ++i, digest += digestLength) {
+        BMDigestCompute(algorithm, ranges[i].bytes, ranges[i].length, digest);
+    }
+    return true;
+}
+
+
+// Number of bytes fed to each context in turn by BMDigestUpdateMultiple, small
+// enough to stay in the L1 cache until all contexts have consumed them
+#define BMDigestMultipleBlockLength ((size_t)(16 * 1024))
+
+
+void BMDigestUpdateMultiple(BMDigestContext *contexts, size_t count, const void *bytes, size_t length)
+{
+    const uint8_t *data = (const uint8_t *)bytes;
+    while (length) {
+        size_t blockLength = (length > BMDigestMultipleBlockLength) ? BMDigestMultipleBlockLength : length;
+        for (size_t i = 0; i < count; ++i) {
+            BMDigestUpdate(contexts + i, data, blockLength);
+        }
+        data += blockLength;
+        length -= blockLength;
+    }
+}
+
+
+bool BMDigestComputeMultiple(const BMDigestAlgorithm *algorithms, size_t count, const void *bytes, size_t length, void *const *digests)
+{
+    BMDigestContext contexts[BMDigestAlgorithmCount];
+    while (count) {
+        // Process at most BMDigestAlgorithmCount algorithms per pass, which
+        // is only exceeded if the caller asks for duplicate algorithms
+        size_t n = (count > BMDigestAlgorithmCount) ? BMDigestAlgorithmCount : count;
+        for (size_t i = 0; i < n; ++i) {
+            if (!BMDigestInit(contexts + i, algorithms[i])) {
+                return false;
+            }
+        }
+        BMDigestUpdateMultiple(contexts, n, bytes, length);
+        for (size_t i = 0; i < n; ++i) {
+            BMDigestFinal(contexts + i, digests[i]);
+        }
+        algorithms += n;
+        digests += n;
+        count -= n;
+    }
+    return true;
+}
+
+
+static bool BMDigestFileWindowFunction(const void *bytes, size_t length, void *context)
+{
+    BMDigestUpdate((BMDigestContext *)context, bytes, length);
+    return true;
+}
+
+
+bool BMDigestUpdateWithFile(BMDigestContext *context, int fd)
+{
+    return BMFileEnumerateWindows(fd, BMDigestFileWindowFunction, context);
+}
+
+
+bool BMDigestComputeFile(BMDigestAlgorithm algorithm, int fd, void *digest)
+{
+    BMDigestContext context;
+    if (!BMDigestInit(&context, algorithm) || !BMDigestUpdateWithFile(&context, fd)) {
+        return false;
+    }
+    BMDigestFinal(&context, digest);
+    return true;
+}
+
+
+#pragma mark -
+#pragma mark HMAC
+
+
+bool BMHMACInit(BMHMACContext *context, BMDigestAlgorithm algorithm, const void *key, size_t keyLength)
+{
+    size_t blockSize = BMDigestGetBlockSize(algorithm);
+    if (!blockSize) {
+        return false;
+    }
+    
+    // Keys longer than the block size are replaced by their digest
+    uint8_t block[BMDigestMaxBlockSize];
+    memset(block, 0, sizeof(block));
+    if (keyLength > blockSize) {
+        BMDigestCompute(algorithm, key, keyLength, block);
+    }
+    else if (keyLength) {
+        memcpy(block, key, keyLength);
+    }
+    
+    // Absorb the inner (ipad) and outer (opad) key blocks
+    for (size_t i = 0; i < blockSize; ++i) {
+        block[i] ^= 0x36;
+    }
+    BMDigestInit(&context->inner, algorithm);
+    BMDigestUpdate(&context->inner, block, blockSize);
+    for (size_t i = 0; i < blockSize; ++i) {
+        block[i] ^= 0x36 ^ 0x5c;
+    }
+    BMDigestInit(&context->outer, algorithm);
+    BMDigestUpdate(&context->outer, block, blockSize);
+    memset(block, 0, sizeof(block));
+    return true;
+}
+
+
+void BMHMACUpdate(BMHMACContext *context, const void *bytes, size_t length)
+{
+    BMDigestUpdate(&context->inner, bytes, length);
+}
+
+
+void BMHMACFinal(BMHMACContext *context, void *mac)
+{
+    uint8_t digest[BMDigestMaxLength];
+    BMDigestFinal(&context->inner, digest);
+    BMDigestUpdate(&context->outer, digest, BMDigestGetLength(context->outer.algorithm));
+    BMDigestFinal(&context->outer, mac);
+}
+
+
+bool BMHMACCompute(BMDigestAlgorithm algorithm, const void *key, size_t keyLength, const void *bytes, size_t length, void *mac)
+{
+    BMHMACContext context;
+    if (!BMHMACInit(&context, algorithm, key, keyLength)) {
+        return false;
+    }
+    BMHMACUpdate(&context, bytes, length);
+    BMHMACFinal(&context, mac);
+    return true;
+}
+
+
+void BMHMACComputeBatch(const BMHMACContext *keyContext, const BMDigestRange *ranges, size_t count, void *macs)
+{
+    size_t macLength = BMDigestGetLength(keyContext->inner.algorithm);
+    uint8_t *mac = (uint8_t *)macs;
+    for (size_t i = 0; i < count; ++i, mac += macLength) {
+        BMHMACContext context = *keyContext;
+        BMHMACUpdate(&context, ranges[i].bytes, ranges[i].length);
+        BMHMACFinal(&context, mac);
+    }
+}
+
+
+#pragma mark -
+#pragma mark Digest Trees
+
+
+typedef struct _BMDigestTreeJob {
+    BMDigestAlgorithm  algorithm;
+    const uint8_t     *bytes;
+    size_t             length;
+    uint8_t           *leafDigests;
+    size_t             digestLength;
+} BMDigestTreeJob;
+
+
+size_t BMDigestTreeGetLeafCount(size_t length)
+{
+    return length ? (length + BMDigestTreeChunkLength - 1) / BMDigestTreeChunkLength : 1;
+}
+
+
+bool BMDigestComputeTreeLeaf(BMDigestAlgorithm algorithm, const void *bytes, size_t length, void *digest)
+{
+    static const uint8_t leafPrefix = 0x00;
+    BMDigestContext context;
+    if (!BMDigestInit(&context, algorithm)) {
+        return false;
+    }
+    BMDigestUpdate(&context, &leafPrefix, 1);
+    BMDigestUpdate(&context, bytes, length);
+    BMDigestFinal(&context, digest);
+    return true;
+}
+
+
+bool BMDigestComputeTreeRoot(BMDigestAlgorithm algorithm, const void *leafDigests, size_t leafCount, void *rootDigest)
+{
+    static const uint8_t nodePrefix = 0x01;
+    size_t digestLength = BMDigestGetLength(algorithm);
+    if (!digestLength || !leafCount) {
+        return false;
+    }
+    uint8_t *nodes = (uint8_t *)malloc(leafCount * digestLength);
+    if (!nodes) {
+        return false;
+    }
+    memcpy(nodes, leafDigests, leafCount * digestLength);
+    for (size_t count = leafCount; count > 1; count = (count + 1) / 2) {
+        // Combine adjacent pairs in place, promoting an odd node at the end
+        for (size_t i = 0; i < count; i += 2) {
+            uint8_t *node = nodes + (i / 2) * digestLength;
+            if (i + 1 < count) {
+                BMDigestContext context;
+                BMDigestInit(&context, algorithm);
+                BMDigestUpdate(&context, &nodePrefix, 1);
+                BMDigestUpdate(&context, nodes + i * digestLength, 2 * digestLength);
+                BMDigestFinal(&context, node);
+            }
+            else {
+                memmove(node, nodes + i * digestLength, digestLength);
+            }
+        }
+    }
+    memcpy(rootDigest, nodes, digestLength);
+    free(nodes);
+    return true;
+}
+
+
+static void BMDigestTreeLeafApplier(void *context, size_t index)
+{
+    BMDigestTreeJob *job = (BMDigestTreeJob *)context;
+    size_t offset = index * BMDigestTreeChunkLength;
+    size_t length = job->length - offset;
+    if (length > BMDigestTreeChunkLength) {
+        length = BMDigestTreeChunkLength;
+    }
+    BMDigestComputeTreeLeaf(job->algorithm, job->bytes + offset, length, job->leafDigests + index * job->digestLength);
+}
+
+
+bool BMDigestComputeTree(BMDigestAlgorithm algorithm, const void *bytes, size_t length, void *rootDigest, void *leafDigests)
+{
+    size_t digestLength = BMDigestGetLength(algorithm);
+    if (!digestLength) {
+        return false;
+    }
+    size_t leafCount = BMDigestTreeGetLeafCount(length);
+    BMDigestTreeJob job;
+    job.algorithm = algorithm;
+    job.bytes = (const uint8_t *)bytes;
+    job.length = length;
+    job.digestLength = digestLength;
+    // The scratch leaf digests are zeroed, since gcc cannot tell that the
+    // appliers below fill all of them before the root is computed
+    job.leafDigests = leafDigests ? (uint8_t *)leafDigests : (uint8_t *)calloc(leafCount, digestLength);
+    if (!job.leafDigests) {
+        return false;
+    }
+#if defined(__APPLE__)
+    if (leafCount > 1) {
+        dispatch_apply_f(leafCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), &job, BMDigestTreeLeafApplier);
+    }
+    else {
+        BMDigestTreeLeafApplier(&job, 0);
+    }
+#else
+    for (size_t i = 0; i < leafCount; ++i) {
+        BMDigestTreeLeafApplier(&job, i);
+    }
+#endif
+    bool succeeded = BMDigestComputeTreeRoot(algorithm, job.leafDigests, leafCount, rootDigest);
+    if (!leafDigests) {
+        free(job.leafDigests);
+    }
+    return succeeded;
+}
+
+
+#ifdef BMDIGEST_COMMONCRYPTO
+
+#pragma mark -
+#pragma mark CommonCrypto Backend
+
+
+bool BMDigestInit(BMDigestContext *context, BMDigestAlgorithm algorithm)
+{
+    context->algorithm = algorithm;
+    switch (algorithm) {
+        case BMDigestAlgorithmMD2:    CC_MD2_Init(&context->u.md2); return true;
+        case BMDigestAlgorithmMD4:    CC_MD4_Init(&context->u.md4); return true;
+        case BMDigestAlgorithmMD5:    CC_MD5_Init(&context->u.md5); return true;
+        case BMDigestAlgorithmSHA1:   CC_SHA1_Init(&context->u.sha1); return true;
+        case BMDigestAlgorithmSHA224: CC_SHA224_Init(&context->u.sha256); return true;
+        case BMDigestAlgorithmSHA256: CC_SHA256_Init(&context->u.sha256); return true;
+        case BMDigestAlgorithmSHA384: CC_SHA384_Init(&context->u.sha512); return true;
+        case BMDigestAlgorithmSHA512: CC_SHA512_Init(&context->u.sha512); return true;
+    }
+    return false;
+}
+
+
+void BMDigestUpdate(BMDigestContext *context, const void *bytes, size_t length)
+{
+    const uint8_t *data = (const uint8_t *)bytes;
+    while (length) {
+        // CC_LONG is only 32 bit wide
+        CC_LONG chunkLength = (length > 0x40000000) ? 0x40000000 : (CC_LONG)length;
+        switch (context->algorithm) {
+            case BMDigestAlgorithmMD2:    CC_MD2_Update(&context->u.md2, data, chunkLength); break;
+            case BMDigestAlgorithmMD4:    CC_MD4_Update(&context->u.md4, data, chunkLength); break;
+            case BMDigestAlgorithmMD5:    CC_MD5_Update(&context->u.md5, data, chunkLength); break;
+            case BMDigestAlgorithmSHA1:   CC_SHA1_Update(&context->u.sha1, data, chunkLength); break;
+            case BMDigestAlgorithmSHA224: CC_SHA224_Update(&context->u.sha256, data, chunkLength); break;
+            case BMDigestAlgorithmSHA256: CC_SHA256_Update(&context->u.sha256, data, chunkLength); break;
+            case BMDigestAlgorithmSHA384: CC_SHA384_Update(&context->u.sha512, data, chunkLength); break;
+            case BMDigestAlgorithmSHA512: CC_SHA512_Update(&context->u.sha512, data, chunkLength); break;
+        }
+        data += chunkLength;
+        length -= chunkLength;
+    }
+}
+
+
+void BMDigestFinal(BMDigestContext *context, void *digest)
+{
+    switch (context->algorithm) {
+        case BMDigestAlgorithmMD2:    CC_MD2_Final(digest, &context->u.md2); break;
+        case BMDigestAlgorithmMD4:    CC_MD4_Final(digest, &context->u.md4); break;
+        case BMDigestAlgorithmMD5:    CC_MD5_Final(digest, &context->u.md5); break;
+        case BMDigestAlgorithmSHA1:   CC_SHA1_Final(digest, &context->u.sha1); break;
+        case BMDigestAlgorithmSHA224: CC_SHA224_Final(digest, &context->u.sha256); break;
+        case BMDigestAlgorithmSHA256: CC_SHA256_Final(digest, &context->u.sha256); break;
+        case BMDigestAlgorithmSHA384: CC_SHA384_Final(digest, &context->u.sha512); break;
+        case BMDigestAlgorithmSHA512: CC_SHA512_Final(digest, &context->u.sha512); break;
+    }
+}
+
+
+#else /* !BMDIGEST_COMMONCRYPTO */
+
+#pragma mark -
+#pragma mark Portable Backend
+
+
+#define BMROL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define BMROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define BMROR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+
+static inline uint32_t BMDigestLoad32LE(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+static inline uint32_t BMDigestLoad32BE(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+
+static inline uint64_t BMDigestLoad64BE(const uint8_t *p)
+{
+    return ((uint64_t)BMDigestLoad32BE(p) << 32) | BMDigestLoad32BE(p + 4);
+}
+
+
+static inline void BMDigestStore32LE(uint8_t *p, uint32_t x)
+{
+    p[0] = (uint8_t)x; p[1] = (uint8_t)(x >> 8); p[2] = (uint8_t)(x >> 16); p[3] = (uint8_t)(x >> 24);
+}
+
+
+static inline void BMDigestStore32BE(uint8_t *p, uint32_t x)
+{
+    p[0] = (uint8_t)(x >> 24); p[1] = (uint8_t)(x >> 16); p[2] = (uint8_t)(x >> 8); p[3] = (uint8_t)x;
+}
+
+
+static inline void BMDigestStore64BE(uint8_t *p, uint64_t x)
+{
+    BMDigestStore32BE(p, (uint32_t)(x >> 32));
+    BMDigestStore32BE(p + 4, (uint32_t)x);
+}
+
+
+#pragma mark MD2
+
+
+static const uint8_t BMDigestMD2Table[256] =
+{
+     41,  46,  67, 201, 162, 216, 124,   1,  61,  54,  84, 161, 236, 240,   6,  19,
+     98, 167,   5, 243, 192, 199, 115, 140, 152, 147,  43, 217, 188,  76, 130, 202,
+     30, 155,  87,  60, 253, 212, 224,  22, 103,  66, 111,  24, 138,  23, 229,  18,
+    190,  78, 196, 214, 218, 158, 222,  73, 160, 251, 245, 142, 187,  47, 238, 122,
+    169, 104, 121, 145,  21, 178,   7,  63, 148, 194,  16, 137,  11,  34,  95,  33,
+    128, 127,  93, 154,  90, 144,  50,  39,  53,  62, 204, 231, 191, 247, 151,   3,
+    255,  25,  48, 179,  72, 165, 181, 209, 215,  94, 146,  42, 172,  86, 170, 198,
+     79, 184,  56, 210, 150, 164, 125, 182, 118, 252, 107, 226, 156, 116,   4, 241,
+     69, 157, 112,  89, 100, 113, 135,  32, 134,  91, 207, 101, 230,  45, 168,   2,
+     27,  96,  37, 173, 174, 176, 185, 246,  28,  70,  97, 105,  52,  64, 126,  15,
+     85,  71, 163,  35, 221,  81, 175,  58, 195,  92, 249, 206, 186, 197, 234,  38,
+     44,  83,  13, 110, 133,  40, 132,   9, 211, 223, 205, 244,  65, 129,  77,  82,
+    106, 220,  55, 200, 108, 193, 171, 250,  36, 225, 123,   8,  12, 189, 177,  74,
+    120, 136, 149, 139, 227,  99, 232, 109, 233, 203, 213, 254,  59,   0,  29,  57,
+    242, 239, 183,  14, 102,  88, 208, 228, 166, 119, 114, 248, 235, 117,  75,  10,
+     49,  68,  80, 180, 143, 237,  31,  26, 219, 153, 141,  51, 159,  17, 131,  20
+};
+
+
+static void BMDigestMD2Transform(BMDigestContext *context, const uint8_t *block)
+{
+    uint8_t *x = context->u.md2.state;
+    uint8_t *checksum = context->u.md2.checksum;
+    unsigned i, j, t;
+    for (i = 0; i < 16; ++i) {
+        x[16 + i] = block[i];
+        x[32 + i] = x[16 + i] ^ x[i];
+    }
+    for (i = 0, t = 0; i < 18; ++i) {
+        for (j = 0; j < 48; ++j) {
+            t = x[j] ^= BMDigestMD2Table[t];
+        }
+        t = (t + i) & 0xff;
+    }
+    for (i = 0, t = checksum[15]; i < 16; ++i) {
+        t = checksum[i] ^= BMDigestMD2Table[block[i] ^ t];
+    }
+}
+
+
+static void BMDigestMD2Update(BMDigestContext *context, const uint8_t *data, size_t length)
+{
+    unsigned count = context->u.md2.count;
+    while (length) {
+        if (count == 0 && length >= 16) {
+            BMDigestMD2Transform(context, data);
+            data += 16;
+            length -= 16;
+            continue;
+        }
+        size_t n = 16 - count;
+        if (n > length) {
+            n = length;
+        }
+        memcpy(context->u.md2.buffer + count, data, n);
+        count += (unsigned)n;
+        data += n;
+        length -= n;
+        if (count == 16) {
+            BMDigestMD2Transform(context, context->u.md2.buffer);
+            count = 0;
+        }
+    }
+    context->u.md2.count = count;
+}
+
+
+static void BMDigestMD2Final(BMDigestContext *context, uint8_t *digest)
+{
+    uint8_t padding[16];
+    uint8_t checksum[16];
+    unsigned n = 16 - context->u.md2.count;
+    memset(padding, (int)n, n);
+    BMDigestMD2Update(context, padding, n);
+    memcpy(checksum, context->u.md2.checksum, 16);
+    BMDigestMD2Update(context, checksum, 16);
+    memcpy(digest, context->u.md2.state, 16);
+}
+
+
+#pragma mark MD4 and MD5
+
+
+static void BMDigestMD4Transform(uint32_t *state, const uint8_t *block)
+{
+    uint32_t x[16], a = state[0], b = state[1], c = state[2], d = state[3];
+    for (unsigned i = 0; i < 16; ++i) {
+        x[i] = BMDigestLoad32LE(block + 4 * i);
+    }
+#define F(x, y, z) (((x) & (y)) | (~(x) & (z)))
+#define G(x, y, z) (((x) & (y)) | ((x) & (z)) | ((y) & (z)))
+#define H(x, y, z) ((x) ^ (y) ^ (z))
+#define R1(a, b, c, d, k, s) a = BMROL32(a + F(b, c, d) + x[k], s)
+#define R2(a, b, c, d, k, s) a = BMROL32(a + G(b, c, d) + x[k] + 0x5a827999, s)
+#define R3(a, b, c, d, k, s) a = BMROL32(a + H(b, c, d) + x[k] + 0x6ed9eba1, s)
+    for (unsigned i = 0; i < 16; i += 4) {
+        R1(a, b, c, d, i + 0, 3); R1(d, a, b, c, i + 1, 7); R1(c, d, a, b, i + 2, 11); R1(b, c, d, a, i + 3, 19);
+    }
+    for (unsigned i = 0; i < 4; ++i) {
+        R2(a, b, c, d, i + 0, 3); R2(d, a, b, c, i + 4, 5); R2(c, d, a, b, i + 8, 9); R2(b, c, d, a, i + 12, 13);
+    }
+    static const uint8_t order[4] = { 0, 2, 1, 3 };
+    for (unsigned i = 0; i < 4; ++i) {
+        unsigned k = order[i];
+        R3(a, b, c, d, k + 0, 3); R3(d, a, b, c, k + 8, 9); R3(c, d, a, b, k + 4, 11); R3(b, c, d, a, k + 12, 15);
+    }
+#undef R3
+#undef R2
+#undef R1
+#undef H
+#undef G
+#undef F
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+}
+
+
+static const uint32_t BMDigestMD5Constants[64] =
+{
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const uint8_t BMDigestMD5Shifts[16] = { 7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21 };
+
+
+static void BMDigestMD5Transform(uint32_t *state, const uint8_t *block)
+{
+    uint32_t x[16], a = state[0], b = state[1], c = state[2], d = state[3];
+    for (unsigned i = 0; i < 16; ++i) {
+        x[i] = BMDigestLoad32LE(block + 4 * i);
+    }
+    for (unsigned i = 0; i < 64; ++i) {
+        uint32_t f;
+        unsigned k;
+        switch (i / 16) {
+            case 0:  f = (b & c) | (~b & d); k = i; break;
+            case 1:  f = (d & b) | (~d & c); k = (5 * i + 1) % 16; break;
+            case 2:  f = b ^ c ^ d;          k = (3 * i + 5) % 16; break;
+            default: f = c ^ (b | ~d);       k = (7 * i) % 16; break;
+        }
+        f += a + BMDigestMD5Constants[i] + x[k];
+        a = d;
+        d = c;
+        c = b;
+        b += BMROL32(f, BMDigestMD5Shifts[(i / 16) * 4 + (i % 4)]);
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+}
+
+
+#pragma mark SHA1
+
+
+static void BMDigestSHA1Transform(uint32_t *state, const uint8_t *block)
+{
+    uint32_t w[80], a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (unsigned i = 0; i < 16; ++i) {
+        w[i] = BMDigestLoad32BE(block + 4 * i);
+    }
+    for (unsigned i = 16; i < 80; ++i) {
+        uint32_t t = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16];
+        w[i] = BMROL32(t, 1);
+    }
+    for (unsigned i = 0; i < 80; ++i) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5a827999;
+        }
+        else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ed9eba1;
+        }
+        else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8f1bbcdc;
+        }
+        else {
+            f = b ^ c ^ d;
+            k = 0xca62c1d6;
+        }
+        uint32_t t = BMROL32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = BMROL32(b, 30);
+        b = a;
+        a = t;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
+}
+
+
+#pragma mark SHA224 and SHA256
+
+
+static const uint32_t BMDigestSHA256Constants[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+
+static void BMDigestSHA256Transform(uint32_t *state, const uint8_t *block)
+{
+    uint32_t w[64], s[8];
+    for (unsigned i = 0; i < 16; ++i) {
+        w[i] = BMDigestLoad32BE(block + 4 * i);
+    }
+    for (unsigned i = 16; i < 64; ++i) {
+        uint32_t s0 = BMROR32(w[i - 15], 7) ^ BMROR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = BMROR32(w[i - 2], 17) ^ BMROR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    memcpy(s, state, sizeof(s));
+    for (unsigned i = 0; i < 64; ++i) {
+        uint32_t S1 = BMROR32(s[4], 6) ^ BMROR32(s[4], 11) ^ BMROR32(s[4], 25);
+        uint32_t ch = (s[4] & s[5]) ^ (~s[4] & s[6]);
+        uint32_t t1 = s[7] + S1 + ch + BMDigestSHA256Constants[i] + w[i];
+        uint32_t S0 = BMROR32(s[0], 2) ^ BMROR32(s[0], 13) ^ BMROR32(s[0], 22);
+        uint32_t maj = (s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]);
+        uint32_t t2 = S0 + maj;
+        s[7] = s[6]; s[6] = s[5]; s[5] = s[4]; s[4] = s[3] + t1;
+        s[3] = s[2]; s[2] = s[1]; s[1] = s[0]; s[0] = t1 + t2;
+    }
+    for (unsigned i = 0; i < 8; ++i) {
+        state[i] += s[i];
+    }
+}
+
+
+#pragma mark SHA384 and SHA512
+
+
+static const uint64_t BMDigestSHA512Constants[80] =
+{
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+
+static void BMDigestSHA512Transform(uint64_t *state, const uint8_t *block)
+{
+    uint64_t w[80], s[8];
+    for (unsigned i = 0; i < 16; ++i) {
+        w[i] = BMDigestLoad64BE(block + 8 * i);
+    }
+    for (unsigned i = 16; i < 80; ++i) {
+        uint64_t s0 = BMROR64(w[i - 15], 1) ^ BMROR64(w[i - 15], 8) ^ (w[i - 15] >> 7);
+        uint64_t s1 = BMROR64(w[i - 2], 19) ^ BMROR64(w[i - 2], 61) ^ (w[i - 2] >> 6);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    memcpy(s, state, sizeof(s));
+    for (unsigned i = 0; i < 80; ++i) {
+        uint64_t S1 = BMROR64(s[4], 14) ^ BMROR64(s[4], 18) ^ BMROR64(s[4], 41);
+        uint64_t ch = (s[4] & s[5]) ^ (~s[4] & s[6]);
+        uint64_t t1 = s[7] + S1 + ch + BMDigestSHA512Constants[i] + w[i];
+        uint64_t S0 = BMROR64(s[0], 28) ^ BMROR64(s[0], 34) ^ BMROR64(s[0], 39);
+        uint64_t maj = (s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]);
+        uint64_t t2 = S0 + maj;
+        s[7] = s[6]; s[6] = s[5]; s[5] = s[4]; s[4] = s[3] + t1;
+        s[3] = s[2]; s[2] = s[1]; s[1] = s[0]; s[0] = t1 + t2;
+    }
+    for (unsigned i = 0; i < 8; ++i) {
+        state[i] += s[i];
+    }
+}
+
+
+#pragma mark Merkle-Damgard Framework
+
+
+static void BMDigestTransform(BMDigestContext *context, const uint8_t *block)
+{
+    switch (context->algorithm) {
+        case BMDigestAlgorithmMD4:
+            BMDigestMD4Transform(context->u.md32.state, block);
+            break;
+            
+        case BMDigestAlgorithmMD5:
+            BMDigestMD5Transform(context->u.md32.state, block);
+            break;
+            
+        case BMDigestAlgorithmSHA1:
+            BMDigestSHA1Transform(context->u.md32.state, block);
+            break;
+            
+        case BMDigestAlgorithmSHA224:
+        case BMDigestAlgorithmSHA256:
+            BMDigestSHA256Transform(context->u.md32.state, block);
+            break;
+            
+        case BMDigestAlgorithmSHA384:
+        case BMDigestAlgorithmSHA512:
+            BMDigestSHA512Transform(context->u.md64.state, block);
+            break;
+            
+        default:
+            break;
+    }
+}
+
+
+bool BMDigestInit(BMDigestContext *context, BMDigestAlgorithm algorithm)
+{
+    static const uint32_t MD5State[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+    static const uint32_t SHA1State[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+    static const uint32_t SHA224State[8] = {
+        0xc1059ed8, 0x367cd507, 0x3070dd17, 0xf70e5939, 0xffc00b31, 0x68581511, 0x64f98fa7, 0xbefa4fa4
+    };
+    static const uint32_t SHA256State[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    static const uint64_t SHA384State[8] = {
+        0xcbbb9d5dc1059ed8ULL, 0x629a292a367cd507ULL, 0x9159015a3070dd17ULL, 0x152fecd8f70e5939ULL,
+        0x67332667ffc00b31ULL, 0x8eb44a8768581511ULL, 0xdb0c2e0d64f98fa7ULL, 0x47b5481dbefa4fa4ULL
+    };
+    static const uint64_t SHA512State[8] = {
+        0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+        0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+    };
+    memset(&context->u, 0, sizeof(context->u));
+    context->algorithm = algorithm;
+    switch (algorithm) {
+        case BMDigestAlgorithmMD2:
+            return true;
+            
+        case BMDigestAlgorithmMD4:
+        case BMDigestAlgorithmMD5:
+            memcpy(context->u.md32.state, MD5State, sizeof(MD5State));
+            return true;
+            
+        case BMDigestAlgorithmSHA1:
+            memcpy(context->u.md32.state, SHA1State, sizeof(SHA1State));
+            return true;
+            
+        case BMDigestAlgorithmSHA224:
+            memcpy(context->u.md32.state, SHA224State, sizeof(SHA224State));
+            return true;
+            
+        case BMDigestAlgorithmSHA256:
+            memcpy(context->u.md32.state, SHA256State, sizeof(SHA256State));
+            return true;
+            
+        case BMDigestAlgorithmSHA384:
+            memcpy(context->u.md64.state, SHA384State, sizeof(SHA384State));
+            return true;
+            
+        case BMDigestAlgorithmSHA512:
+            memcpy(context->u.md64.state, SHA512State, sizeof(SHA512State));
+            return true;
+    }
+    return false;
+}
+
+
+void BMDigestUpdate(BMDigestContext *context, const void *bytes, size_t length)
+{
+    const uint8_t *data = (const uint8_t *)bytes;
+    if (context->algorithm == BMDigestAlgorithmMD2) {
+        BMDigestMD2Update(context, data, length);
+        return;
+    }
+    
+    // Algorithms with 64 and 128 byte blocks keep their state in different union members
+    size_t blockSize = BMDigestAlgorithmInfo[context->algorithm].blockSize;
+    uint64_t *totalLength = (blockSize == 64) ? &context->u.md32.length : &context->u.md64.length;
+    uint8_t *buffer = (blockSize == 64) ? context->u.md32.buffer : context->u.md64.buffer;
+    size_t count = (size_t)(*totalLength % blockSize);
+    *totalLength += length;
+    if (count) {
+        size_t n = blockSize - count;
+        if (n > length) {
+            n = length;
+        }
+        memcpy(buffer + count, data, n);
+        count += n;
+        data += n;
+        length -= n;
+        if (count < blockSize) {
+            return;
+        }
+        BMDigestTransform(context, buffer);
+    }
+    for (; length >= blockSize; data += blockSize, length -= blockSize) {
+        BMDigestTransform(context, data);
+    }
+    memcpy(buffer, data, length);
+}
+
+
+void BMDigestFinal(BMDigestContext *context, void *digest)
+{
+    uint8_t *out = (uint8_t *)digest;
+    if (context->algorithm == BMDigestAlgorithmMD2) {
+        BMDigestMD2Final(context, out);
+        return;
+    }
+    
+    // Append the 0x80 terminator, zero padding and the message length in bits
+    size_t blockSize = BMDigestAlgorithmInfo[context->algorithm].blockSize;
+    size_t lengthSize = blockSize / 8;
+    uint64_t totalLength = (blockSize == 64) ? context->u.md32.length : context->u.md64.length;
+    uint8_t padding[2 * BMDigestMaxBlockSize];
+    size_t count = (size_t)(totalLength % blockSize);
+    size_t paddingLength = ((count + 1 + lengthSize <= blockSize) ? blockSize : 2 * blockSize) - count;
+    memset(padding, 0, paddingLength);
+    padding[0] = 0x80;
+    uint64_t bits = totalLength << 3;
+    if (context->algorithm == BMDigestAlgorithmMD4 || context->algorithm == BMDigestAlgorithmMD5) {
+        BMDigestStore32LE(padding + paddingLength - 8, (uint32_t)bits);
+        BMDigestStore32LE(padding + paddingLength - 4, (uint32_t)(bits >> 32));
+    }
+    else {
+        // SHA384 and SHA512 use a 128 bit length, whose upper half is always zero here
+        BMDigestStore64BE(padding + paddingLength - 8, bits);
+    }
+    BMDigestUpdate(context, padding, paddingLength);
+    
+    size_t digestLength = BMDigestAlgorithmInfo[context->algorithm].length;
+    if (blockSize == 64) {
+        for (size_t i = 0; i < digestLength; i += 4) {
+            if (context->algorithm == BMDigestAlgorithmMD4 || context->algorithm == BMDigestAlgorithmMD5) {
+                BMDigestStore32LE(out + i, context->u.md32.state[i / 4]);
+            }
+            else {
+                BMDigestStore32BE(out + i, context->u.md32.state[i / 4]);
+            }
+        }
+    }
+    else {
+        for (size_t i = 0; i < digestLength; i += 8) {
+            BMDigestStore64BE(out + i, context->u.md64.state[i / 8]);
+        }
+    }
+}
+
+#endif /* !BMDIGEST_COMMONCRYPTO */
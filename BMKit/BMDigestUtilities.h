@@ -0,0 +1,183 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __BMDIGESTUTILITIES__
+#define __BMDIGESTUTILITIES__
+
+#include <sys/cdefs.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "BMHex.h"
+
+#if !defined(BMDIGEST_PORTABLE) && defined(__APPLE__)
+# define BMDIGEST_COMMONCRYPTO 1
+# include <CommonCrypto/CommonDigest.h>
+#endif
+
+__BEGIN_DECLS
+
+/** Message digest algorithms. */
+typedef enum _BMDigestAlgorithm {
+    BMDigestAlgorithmMD2    = 0,
+    BMDigestAlgorithmMD4    = 1,
+    BMDigestAlgorithmMD5    = 2,
+    BMDigestAlgorithmSHA1   = 3,
+    BMDigestAlgorithmSHA224 = 4,
+    BMDigestAlgorithmSHA256 = 5,
+    BMDigestAlgorithmSHA384 = 6,
+    BMDigestAlgorithmSHA512 = 7
+} BMDigestAlgorithm;
+
+/** The number of supported message digest algorithms. */
+#define BMDigestAlgorithmCount 8
+
+/** The length of the longest message digest in bytes. */
+#define BMDigestMaxLength 64
+
+/** The largest block size of all message digest algorithms in bytes. */
+#define BMDigestMaxBlockSize 128
+
+/** The size of a buffer that holds the hex string of any message digest including the terminating NUL character. */
+#define BMDigestMaxHexLength (2 * BMDigestMaxLength + 1)
+
+/** A range of bytes for batch message digest computations. */
+typedef struct _BMDigestRange {
+    const void *bytes;
+    size_t      length;
+} BMDigestRange;
+
+/** State of an incremental message digest computation. */
+typedef struct _BMDigestContext {
+    BMDigestAlgorithm algorithm;
+    union {
+#ifdef BMDIGEST_COMMONCRYPTO
+        CC_MD2_CTX    md2;
+        CC_MD4_CTX    md4;
+        CC_MD5_CTX    md5;
+        CC_SHA1_CTX   sha1;
+        CC_SHA256_CTX sha256;
+        CC_SHA512_CTX sha512;
+#else
+        struct {
+            uint8_t  state[48];
+            uint8_t  checksum[16];
+            uint8_t  buffer[16];
+            unsigned count;
+        } md2;
+        struct {
+            uint32_t state[8];
+            uint64_t length;
+            uint8_t  buffer[64];
+        } md32;
+        struct {
+            uint64_t state[8];
+            uint64_t length;
+            uint8_t  buffer[128];
+        } md64;
+#endif
+    } u;
+} BMDigestContext;
+
+/** State of an incremental HMAC computation, see RFC 2104. */
+typedef struct _BMHMACContext {
+    BMDigestContext inner;
+    BMDigestContext outer;
+} BMHMACContext;
+
+/** Returns the length of the message digest for _algorithm_ in bytes, or 0 if _algorithm_ is invalid. */
+extern size_t BMDigestGetLength(BMDigestAlgorithm algorithm);
+
+/** Returns the block size of _algorithm_ in bytes, or 0 if _algorithm_ is invalid. */
+extern size_t BMDigestGetBlockSize(BMDigestAlgorithm algorithm);
+
+/** Initializes _context_ for a new message digest computation using _algorithm_. Returns `false` if _algorithm_ is invalid. */
+extern bool BMDigestInit(BMDigestContext *context, BMDigestAlgorithm algorithm);
+
+/** Adds _length_ bytes from _bytes_ to the message digest computation. */
+extern void BMDigestUpdate(BMDigestContext *context, const void *bytes, size_t length);
+
+/** Finishes the message digest computation and stores the message digest in _digest_, which must hold at least `BMDigestGetLength(context->algorithm)` bytes. The _context_ must be initialized again before it can be reused. */
+extern void BMDigestFinal(BMDigestContext *context, void *digest);
+
+/** Computes the message digest of _length_ bytes from _bytes_ using _algorithm_ and stores it in _digest_. Returns `false` if _algorithm_ is invalid. */
+extern bool BMDigestCompute(BMDigestAlgorithm algorithm, const void *bytes, size_t length, void *digest);
+
+/** Computes the message digest of _length_ bytes from _bytes_ using _algorithm_ and stores it as NUL-terminated hex string in _buffer_, which must hold at least `2 * BMDigestGetLength(algorithm) + 1` characters. Returns `false` if _algorithm_ is invalid. */
+extern bool BMDigestComputeHex(BMDigestAlgorithm algorithm, const void *bytes, size_t length, char *buffer, BMHexEncodeOptions options);
+
+/** Computes the message digests of _count_ byte _ranges_ using _algorithm_ and stores them packed contiguously in _digests_, which must hold at least `count * BMDigestGetLength(algorithm)` bytes. Returns `false` if _algorithm_ is invalid. */
+extern bool BMDigestComputeBatch(BMDigestAlgorithm algorithm, const BMDigestRange *ranges, size_t count, void *digests);
+
+/** Adds _length_ bytes from _bytes_ to _count_ message digest computations at once. The bytes are processed in blocks that fit into the L1 cache, so each byte is loaded from memory only once, no matter how many digests are computed. */
+extern void BMDigestUpdateMultiple(BMDigestContext *contexts, size_t count, const void *bytes, size_t length);
+
+/** Computes the message digests of _length_ bytes from _bytes_ for _count_ algorithms in a single pass, and stores the message digest for `algorithms[i]` in `digests[i]`. Returns `false` if any of the _algorithms_ is invalid. */
+extern bool BMDigestComputeMultiple(const BMDigestAlgorithm *algorithms, size_t count, const void *bytes, size_t length, void *const *digests);
+
+/** Adds the contents of the file descriptor _fd_, from its current offset to its end, to _context_. Regular files are mapped into memory window by window, see `BMFileEnumerateWindows`. Returns `false` if an I/O error occurred. */
+extern bool BMDigestUpdateWithFile(BMDigestContext *context, int fd);
+
+/** Computes the message digest of the contents of the file descriptor _fd_, from its current offset to its end, and stores it in _digest_. Returns `false` if _algorithm_ is invalid or an I/O error occurred. */
+extern bool BMDigestComputeFile(BMDigestAlgorithm algorithm, int fd, void *digest);
+
+/** Initializes _context_ for a new HMAC computation using _algorithm_ and _keyLength_ bytes of _key_. The key schedule, i.e. the inner and outer digest states after the padded key blocks, is complete afterwards, so copying an initialized _context_ is the cheapest way to start another HMAC computation with the same key. Returns `false` if _algorithm_ is invalid. */
+extern bool BMHMACInit(BMHMACContext *context, BMDigestAlgorithm algorithm, const void *key, size_t keyLength);
+
+/** Adds _length_ bytes from _bytes_ to the HMAC computation. */
+extern void BMHMACUpdate(BMHMACContext *context, const void *bytes, size_t length);
+
+/** Finishes the HMAC computation and stores the HMAC in _mac_, which must hold at least `BMDigestGetLength(context->inner.algorithm)` bytes. The _context_ must be initialized again before it can be reused. */
+extern void BMHMACFinal(BMHMACContext *context, void *mac);
+
+/** Computes the HMAC of _length_ bytes from _bytes_ using _algorithm_ and _keyLength_ bytes of _key_, and stores it in _mac_. Returns `false` if _algorithm_ is invalid. */
+extern bool BMHMACCompute(BMDigestAlgorithm algorithm, const void *key, size_t keyLength, const void *bytes, size_t length, void *mac);
+
+/** Computes the HMACs of _count_ byte _ranges_ starting from the initialized _keyContext_, which is not modified, and stores them packed contiguously in _macs_, which must hold at least `count * BMDigestGetLength(keyContext->inner.algorithm)` bytes. */
+extern void BMHMACComputeBatch(const BMHMACContext *keyContext, const BMDigestRange *ranges, size_t count, void *macs);
+
+/** The number of input bytes covered by each leaf of a digest tree (1 MiB).
+ 
+ A digest tree is a Merkle tree over fixed-size chunks of the input. The leaf digests are computed as `H(0x00 || chunk)`, with the last chunk possibly being shorter and an empty input having a single empty chunk. The inner nodes are computed level by level as `H(0x01 || left || right)` over adjacent pairs; an odd node at the end of a level is promoted to the next level unchanged. The root of the tree is the digest of the topmost level. */
+#define BMDigestTreeChunkLength ((size_t)1 << 20)
+
+/** Returns the number of leaves of the digest tree for _length_ bytes of input. */
+extern size_t BMDigestTreeGetLeafCount(size_t length);
+
+/** Computes the leaf digest of a single chunk of at most `BMDigestTreeChunkLength` bytes and stores it in _digest_. Returns `false` if _algorithm_ is invalid. */
+extern bool BMDigestComputeTreeLeaf(BMDigestAlgorithm algorithm, const void *bytes, size_t length, void *digest);
+
+/** Computes the root digest of the digest tree with the given _leafCount_ leaf digests, which are packed contiguously in _leafDigests_, and stores it in _rootDigest_. Returns `false` if _algorithm_ is invalid or _leafCount_ is 0. */
+extern bool BMDigestComputeTreeRoot(BMDigestAlgorithm algorithm, const void *leafDigests, size_t leafCount, void *rootDigest);
+
+/** Computes the digest tree of _length_ bytes from _bytes_, hashing the leaves in parallel on a global dispatch queue on Apple platforms, and one after another elsewhere. The root digest is stored in _rootDigest_, and if _leafDigests_ is not `NULL`, the leaf digests are packed contiguously into _leafDigests_, which must hold `BMDigestTreeGetLeafCount(length) * BMDigestGetLength(algorithm)` bytes. Returns `false` if _algorithm_ is invalid or memory is exhausted. */
+extern bool BMDigestComputeTree(BMDigestAlgorithm algorithm, const void *bytes, size_t length, void *rootDigest, void *leafDigests);
+
+__END_DECLS
+
+#endif /* !__BMDIGESTUTILITIES__ */
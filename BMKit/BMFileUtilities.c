@@ -0,0 +1,124 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "BMFileUtilities.h"
+
+
+static bool BMFileEnumerateReadWindows(int fd, off_t offset, off_t size, BMFileWindowFunction function, void *context)
+{
+    // Page-aligned buffers let the kernel copy straight from the page cache
+    void *buffer = NULL;
+    if (posix_memalign(&buffer, (size_t)getpagesize(), BMFileReadWindowLength) != 0) {
+        return false;
+    }
+    bool succeeded = true;
+    for (;;) {
+        ssize_t length = (offset >= 0)
+                       ? pread(fd, buffer, BMFileReadWindowLength, offset)
+                       : read(fd, buffer, BMFileReadWindowLength);
+        if (length < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            succeeded = false;
+            break;
+        }
+        if (length == 0 || !function(buffer, (size_t)length, context)) {
+            succeeded = (length == 0);
+            break;
+        }
+        if (offset >= 0) {
+            offset += length;
+            if (offset >= size) {
+                break;
+            }
+        }
+    }
+    free(buffer);
+    return succeeded;
+}
+
+
+bool BMFileEnumerateWindows(int fd, BMFileWindowFunction function, void *context)
+{
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        return false;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        return BMFileEnumerateReadWindows(fd, -1, 0, function, context);
+    }
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset < 0) {
+        return false;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    (void)posix_fadvise(fd, offset, 0, POSIX_FADV_SEQUENTIAL);
+#elif defined(F_RDAHEAD)
+    (void)fcntl(fd, F_RDAHEAD, 1);
+#endif
+    off_t pageMask = (off_t)getpagesize() - 1;
+    while (offset < st.st_size) {
+        // Map the next window, starting at the page containing offset
+        off_t base = offset & ~pageMask;
+        size_t delta = (size_t)(offset - base);
+        size_t length = (size_t)MIN((off_t)BMFileMapWindowLength, st.st_size - base);
+        void *window = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, base);
+        if (window == MAP_FAILED) {
+            return BMFileEnumerateReadWindows(fd, offset, st.st_size, function, context);
+        }
+        (void)madvise(window, length, MADV_SEQUENTIAL);
+        bool proceed = function((const uint8_t *)window + delta, length - delta, context);
+        munmap(window, length);
+        if (!proceed) {
+            return false;
+        }
+        offset = base + (off_t)length;
+    }
+    return true;
+}
+
+
+bool BMFileEnumerateWindowsAtPath(const char *path, BMFileWindowFunction function, void *context)
+{
+    bool succeeded = false;
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        succeeded = BMFileEnumerateWindows(fd, function, context);
+        close(fd);
+    }
+    return succeeded;
+}
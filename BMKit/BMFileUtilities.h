@@ -0,0 +1,54 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __BMFILEUTILITIES__
+#define __BMFILEUTILITIES__
+
+#include <sys/cdefs.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+__BEGIN_DECLS
+
+/** Number of bytes of a regular file that are mapped into memory at once (32 MiB). */
+#define BMFileMapWindowLength ((size_t)32 << 20)
+
+/** Number of bytes read at once if a file cannot be mapped into memory (1 MiB). */
+#define BMFileReadWindowLength ((size_t)1 << 20)
+
+/** Callback invoked for each window of a file, return `false` to stop the enumeration. */
+typedef bool (*BMFileWindowFunction)(const void *bytes, size_t length, void *context);
+
+/** Enumerates the contents of the file descriptor _fd_ from its current offset to its end in consecutive windows, calling _function_ with each window and _context_. Regular files are mapped into memory window by window with a sequential access hint, so they are processed without copying and without growing the resident set; if mapping fails, the file is read using page-aligned `pread` windows instead. Other files, i.e. pipes and sockets, are read using `read`. The file offset of _fd_ is left unchanged for regular files. Returns `false` if an I/O error occurred or _function_ returned `false`. */
+extern bool BMFileEnumerateWindows(int fd, BMFileWindowFunction function, void *context);
+
+/** Opens the file at _path_ read-only and enumerates its contents like `BMFileEnumerateWindows`. Returns `false` if the file could not be opened, an I/O error occurred or _function_ returned `false`. */
+extern bool BMFileEnumerateWindowsAtPath(const char *path, BMFileWindowFunction function, void *context);
+
+__END_DECLS
+
+#endif /* !__BMFILEUTILITIES__ */
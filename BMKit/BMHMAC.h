@@ -0,0 +1,153 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+#include "BMDigestUtilities.h"
+
+
+/** You use an HMAC object to compute keyed-hash message authentication codes (RFC 2104) for many messages under the same key.
+ 
+ The key schedule, i.e. the inner and outer digest states after the padded key blocks, is computed once when the HMAC object is created, so each message only costs the digest work for the message itself. An HMAC object supports all message digest algorithms, although you will usually want to use one of the SHA variants.
+ 
+ The incremental methods are not thread-safe, but the one-shot methods MACOfData:, getMAC:ofBytes:length: and the batch methods do not modify the receiver and can be used from several threads at once.
+ 
+ @see BMDigest
+ */
+@interface BMHMAC : NSObject <NSCopying> {
+@private
+    BMHMACContext _keyContext;
+    BMHMACContext _context;
+}
+
+/** The message digest algorithm of the receiver. */
+@property (nonatomic, assign, readonly) BMDigestAlgorithm algorithm;
+
+/** The length of the message authentication codes of the receiver in bytes. */
+@property (nonatomic, assign, readonly) NSUInteger MACLength;
+
+///-----------------------------
+/// @name Creating HMAC Objects
+///-----------------------------
+
+/** Creates and returns an HMAC object for the given algorithm and key.
+ 
+ @param algorithm The message digest algorithm.
+ @param key The secret key.
+ @return A new HMAC object, or `nil` if *algorithm* is invalid.
+ @see initWithAlgorithm:key:
+ */
++ (id)HMACWithAlgorithm:(BMDigestAlgorithm)algorithm key:(NSData *)key;
+
+/** Initializes the receiver with the given algorithm and key.
+ 
+ @param algorithm The message digest algorithm.
+ @param key The secret key.
+ @return The initialized receiver, or `nil` if *algorithm* is invalid.
+ @see initWithAlgorithm:keyBytes:length:
+ */
+- (id)initWithAlgorithm:(BMDigestAlgorithm)algorithm key:(NSData *)key;
+
+/** Initializes the receiver with the given algorithm and key bytes.
+ 
+ @param algorithm The message digest algorithm.
+ @param keyBytes The bytes of the secret key.
+ @param keyLength The number of bytes of the secret key.
+ @return The initialized receiver, or `nil` if *algorithm* is invalid.
+ @see initWithAlgorithm:key:
+ */
+- (id)initWithAlgorithm:(BMDigestAlgorithm)algorithm keyBytes:(const void *)keyBytes length:(NSUInteger)keyLength;
+
+///------------------------------------------------
+/// @name Computing Message Authentication Codes
+///------------------------------------------------
+
+/** Returns the message authentication code of the data object.
+ 
+ @param data The message.
+ @return The message authentication code of *data*.
+ @see getMAC:ofBytes:length:
+ */
+- (NSData *)MACOfData:(NSData *)data;
+
+/** Computes the message authentication code of a message into a buffer, without allocating any objects.
+ 
+ @param buffer The buffer that receives the message authentication code. It must hold at least MACLength bytes.
+ @param bytes The bytes of the message.
+ @param length The number of bytes of the message.
+ @see MACOfData:
+ */
+- (void)getMAC:(void *)buffer ofBytes:(const void *)bytes length:(NSUInteger)length;
+
+/** Adds bytes to the incremental message authentication code computation.
+ 
+ @param bytes The bytes to add.
+ @param length The number of bytes to add.
+ @see updateWithData:
+ @see finalMAC
+ */
+- (void)updateWithBytes:(const void *)bytes length:(NSUInteger)length;
+
+/** Adds the bytes of the data object to the incremental message authentication code computation.
+ 
+ @param data The data to add.
+ @see updateWithBytes:length:
+ @see finalMAC
+ */
+- (void)updateWithData:(NSData *)data;
+
+/** Finishes the incremental message authentication code computation and returns the message authentication code.
+ 
+ The receiver is reset afterwards, and can be reused for the next message under the same key.
+ 
+ @return The message authentication code of all bytes added to the receiver.
+ */
+- (NSData *)finalMAC;
+
+///----------------------------------------------------------
+/// @name Computing Message Authentication Codes in Batch
+///----------------------------------------------------------
+
+/** Computes the message authentication codes of several data objects into a buffer, without allocating any objects.
+ 
+ The message authentication codes are packed contiguously in the order of *dataObjects*, so the code of the i-th data object starts at byte `i * MACLength` of *buffer*.
+ 
+ @param buffer The buffer that receives the message authentication codes. It must hold at least `[dataObjects count] * MACLength` bytes.
+ @param dataObjects An array of `NSData` objects.
+ @see MACsOfDataObjects:
+ */
+- (void)getMACs:(void *)buffer ofDataObjects:(NSArray *)dataObjects;
+
+/** Returns the message authentication codes of several data objects packed contiguously into a single data object.
+ 
+ @param dataObjects An array of `NSData` objects.
+ @return The message authentication codes of *dataObjects* packed contiguously.
+ @see getMACs:ofDataObjects:
+ */
+- (NSData *)MACsOfDataObjects:(NSArray *)dataObjects;
+
+@end
@@ -0,0 +1,181 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#import "BMHMAC.h"
+
+
+@interface BMHMAC (BMKitInternals)
+
+- (id)BM_initWithKeyContext:(const BMHMACContext *)keyContext context:(const BMHMACContext *)context;
+
+@end
+
+
+@implementation BMHMAC
+
+
++ (id)HMACWithAlgorithm:(BMDigestAlgorithm)algorithm key:(NSData *)key
+{
+    return [[[self alloc] initWithAlgorithm:algorithm key:key] autorelease];
+}
+
+
+- (id)init
+{
+    return [self initWithAlgorithm:BMDigestAlgorithmSHA256 keyBytes:NULL length:0];
+}
+
+
+- (id)initWithAlgorithm:(BMDigestAlgorithm)algorithm key:(NSData *)key
+{
+    return [self initWithAlgorithm:algorithm keyBytes:[key bytes] length:[key length]];
+}
+
+
+- (id)initWithAlgorithm:(BMDigestAlgorithm)algorithm keyBytes:(const void *)keyBytes length:(NSUInteger)keyLength
+{
+    self = [super init];
+    if (self) {
+        if (!BMHMACInit(&_keyContext, algorithm, keyBytes, keyLength)) {
+            [self release];
+            return nil;
+        }
+        _context = _keyContext;
+    }
+    return self;
+}
+
+
+- (id)BM_initWithKeyContext:(const BMHMACContext *)keyContext context:(const BMHMACContext *)context
+{
+    self = [super init];
+    if (self) {
+        // The contexts are plain old data, so the copy continues the computation independently
+        _keyContext = *keyContext;
+        _context = *context;
+    }
+    return self;
+}
+
+
+- (void)dealloc
+{
+    // Do not leave the key schedule behind in freed memory
+    memset(&_keyContext, 0, sizeof(_keyContext));
+    memset(&_context, 0, sizeof(_context));
+    [super dealloc];
+}
+
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    // Take over the key schedule instead of computing a throwaway one in init
+    return [[[self class] allocWithZone:zone] BM_initWithKeyContext:&_keyContext context:&_context];
+}
+
+
+#pragma mark -
+#pragma mark Properties
+
+
+- (BMDigestAlgorithm)algorithm
+{
+    return _keyContext.inner.algorithm;
+}
+
+
+- (NSUInteger)MACLength
+{
+    return BMDigestGetLength(_keyContext.inner.algorithm);
+}
+
+
+#pragma mark -
+#pragma mark Computing Message Authentication Codes
+
+
+- (NSData *)MACOfData:(NSData *)data
+{
+    UInt8 mac[BMDigestMaxLength];
+    [self getMAC:mac ofBytes:[data bytes] length:[data length]];
+    return [NSData dataWithBytes:mac length:[self MACLength]];
+}
+
+
+- (void)getMAC:(void *)buffer ofBytes:(const void *)bytes length:(NSUInteger)length
+{
+    BMHMACContext context = _keyContext;
+    BMHMACUpdate(&context, bytes, length);
+    BMHMACFinal(&context, buffer);
+}
+
+
+- (void)updateWithBytes:(const void *)bytes length:(NSUInteger)length
+{
+    BMHMACUpdate(&_context, bytes, length);
+}
+
+
+- (void)updateWithData:(NSData *)data
+{
+    BMHMACUpdate(&_context, [data bytes], [data length]);
+}
+
+
+- (NSData *)finalMAC
+{
+    UInt8 mac[BMDigestMaxLength];
+    BMHMACFinal(&_context, mac);
+    _context = _keyContext;
+    return [NSData dataWithBytes:mac length:[self MACLength]];
+}
+
+
+#pragma mark -
+#pragma mark Computing Message Authentication Codes in Batch
+
+
+- (void)getMACs:(void *)buffer ofDataObjects:(NSArray *)dataObjects
+{
+    NSUInteger MACLength = [self MACLength];
+    UInt8 *mac = (UInt8 *)buffer;
+    for (NSData *data in dataObjects) {
+        [self getMAC:mac ofBytes:[data bytes] length:[data length]];
+        mac += MACLength;
+    }
+}
+
+
+- (NSData *)MACsOfDataObjects:(NSArray *)dataObjects
+{
+    NSMutableData *MACs = [NSMutableData dataWithLength:[dataObjects count] * [self MACLength]];
+    [self getMACs:[MACs mutableBytes] ofDataObjects:dataObjects];
+    return MACs;
+}
+
+
+@end
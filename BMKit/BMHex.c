@@ -0,0 +1,322 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+
+#include "BMHex.h"
+
+#if defined(__SSE2__)
+# define BMHEX_SSE2 1
+# include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+# define BMHEX_NEON 1
+# include <arm_neon.h>
+#endif
+
+
+#pragma mark -
+#pragma mark Tables
+
+
+// Digit values 0 to 15, 16 for separators and 17 for invalid characters
+static const uint8_t BMHexDecodingTable[256] =
+{
+	17, 17, 17, 17, 17, 17, 17, 17, 17, 16, 16, 16, 16, 16, 17, 17,
+	17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	16, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 16, 17, 17,
+	 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 16, 17, 17, 17, 17, 17,
+	17, 10, 11, 12, 13, 14, 15, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	17, 10, 11, 12, 13, 14, 15, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17
+};
+
+static const char BMHexLowercaseDigits[] = "0123456789abcdef";
+static const char BMHexUppercaseDigits[] = "0123456789ABCDEF";
+
+
+#pragma mark -
+#pragma mark Vector Kernels
+
+
+// The vector kernels map each nibble n to '0' + n, plus the distance to
+// the letters for n > 9, which needs no table lookups and works with the
+// baseline SSE2 and NEON instruction sets. Decoding only handles blocks of
+// 32 digits without separators, everything else is left to the scalar code.
+
+#if defined(BMHEX_SSE2)
+
+static size_t BMHexEncodeVector(const uint8_t *bytes, size_t length, char *buffer, bool uppercase)
+{
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i alpha = _mm_set1_epi8(uppercase ? 'A' - '0' - 10 : 'a' - '0' - 10);
+    size_t n = length & ~(size_t)15;
+    for (size_t i = 0; i < n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(bytes + i));
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+        __m128i lo = _mm_and_si128(v, mask);
+        hi = _mm_add_epi8(_mm_add_epi8(hi, zero), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), alpha));
+        lo = _mm_add_epi8(_mm_add_epi8(lo, zero), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), alpha));
+        _mm_storeu_si128((__m128i *)(buffer + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(buffer + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return n;
+}
+
+
+static inline __m128i BMHexDecodeNibbles(__m128i c, __m128i *valid)
+{
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i five = _mm_set1_epi8(5);
+    __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, nine), digit);
+    __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, five), letter);
+    *valid = _mm_and_si128(*valid, _mm_or_si128(isDigit, isLetter));
+    return _mm_or_si128(_mm_and_si128(isDigit, digit),
+                        _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+
+static bool BMHexDecodeVector(const uint8_t *string, uint8_t *buffer)
+{
+    const __m128i low = _mm_set1_epi16(0x00ff);
+    __m128i valid = _mm_set1_epi8(-1);
+    __m128i v0 = BMHexDecodeNibbles(_mm_loadu_si128((const __m128i *)string), &valid);
+    __m128i v1 = BMHexDecodeNibbles(_mm_loadu_si128((const __m128i *)(string + 16)), &valid);
+    if (_mm_movemask_epi8(valid) != 0xffff) {
+        return false;
+    }
+    // Each 16-bit lane holds the high nibble in its low byte and vice versa
+    v0 = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v0, low), 4), _mm_srli_epi16(v0, 8));
+    v1 = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v1, low), 4), _mm_srli_epi16(v1, 8));
+    _mm_storeu_si128((__m128i *)buffer, _mm_packus_epi16(v0, v1));
+    return true;
+}
+
+#elif defined(BMHEX_NEON)
+
+static size_t BMHexEncodeVector(const uint8_t *bytes, size_t length, char *buffer, bool uppercase)
+{
+    const uint8x16_t mask = vdupq_n_u8(0x0f);
+    const uint8x16_t nine = vdupq_n_u8(9);
+    const uint8x16_t zero = vdupq_n_u8('0');
+    const uint8x16_t alpha = vdupq_n_u8(uppercase ? 'A' - '0' - 10 : 'a' - '0' - 10);
+    size_t n = length & ~(size_t)15;
+    for (size_t i = 0; i < n; i += 16) {
+        uint8x16_t v = vld1q_u8(bytes + i);
+        uint8x16_t hi = vshrq_n_u8(v, 4);
+        uint8x16_t lo = vandq_u8(v, mask);
+        uint8x16x2_t digits;
+        digits.val[0] = vaddq_u8(vaddq_u8(hi, zero), vandq_u8(vcgtq_u8(hi, nine), alpha));
+        digits.val[1] = vaddq_u8(vaddq_u8(lo, zero), vandq_u8(vcgtq_u8(lo, nine), alpha));
+        vst2q_u8((uint8_t *)buffer + 2 * i, digits);
+    }
+    return n;
+}
+
+
+static inline uint8x16_t BMHexDecodeNibbles(uint8x16_t c, uint8x16_t *valid)
+{
+    uint8x16_t digit = vsubq_u8(c, vdupq_n_u8('0'));
+    uint8x16_t letter = vsubq_u8(vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t isDigit = vcleq_u8(digit, vdupq_n_u8(9));
+    uint8x16_t isLetter = vcleq_u8(letter, vdupq_n_u8(5));
+    *valid = vandq_u8(*valid, vorrq_u8(isDigit, isLetter));
+    return vorrq_u8(vandq_u8(isDigit, digit), vandq_u8(isLetter, vaddq_u8(letter, vdupq_n_u8(10))));
+}
+
+
+static bool BMHexDecodeVector(const uint8_t *string, uint8_t *buffer)
+{
+    uint8x16x2_t c = vld2q_u8(string);
+    uint8x16_t valid = vdupq_n_u8(0xff);
+    uint8x16_t hi = BMHexDecodeNibbles(c.val[0], &valid);
+    uint8x16_t lo = BMHexDecodeNibbles(c.val[1], &valid);
+    uint64x2_t v = vreinterpretq_u64_u8(valid);
+    if ((vgetq_lane_u64(v, 0) & vgetq_lane_u64(v, 1)) != ~(uint64_t)0) {
+        return false;
+    }
+    vst1q_u8(buffer, vorrq_u8(vshlq_n_u8(hi, 4), lo));
+    return true;
+}
+
+#endif
+
+
+#pragma mark -
+#pragma mark Encoding
+
+
+size_t BMHexEncodedLength(size_t length, size_t groupLength)
+{
+    size_t separators = (groupLength && length) ? (length - 1) / groupLength : 0;
+    return 2 * length + separators;
+}
+
+
+static size_t BMHexEncodeRun(const uint8_t *bytes, size_t length, char *buffer, bool uppercase)
+{
+    const char *digits = uppercase ? BMHexUppercaseDigits : BMHexLowercaseDigits;
+    size_t n = 0;
+#if defined(BMHEX_SSE2) || defined(BMHEX_NEON)
+    n = BMHexEncodeVector(bytes, length, buffer, uppercase);
+#endif
+    for (; n < length; ++n) {
+        buffer[2 * n]     = digits[bytes[n] >> 4];
+        buffer[2 * n + 1] = digits[bytes[n] & 0xf];
+    }
+    return 2 * length;
+}
+
+
+size_t BMHexEncode(const void *bytes, size_t length, char *buffer, BMHexEncodeOptions options, char separator, size_t groupLength)
+{
+    const uint8_t *data = (const uint8_t *)bytes;
+    bool uppercase = (options & BMHexEncodeUppercase) != 0;
+    char *bufptr = buffer;
+    while (length) {
+        size_t runLength = (groupLength && groupLength < length) ? groupLength : length;
+        bufptr += BMHexEncodeRun(data, runLength, bufptr, uppercase);
+        data += runLength;
+        length -= runLength;
+        if (length) {
+            *bufptr++ = separator;
+        }
+    }
+    return bufptr - buffer;
+}
+
+
+#pragma mark -
+#pragma mark Decoding
+
+
+size_t BMHexDecodedMaxLength(size_t length)
+{
+    return length / 2;
+}
+
+
+bool BMHexDecode(const char *string, size_t length, void *buffer, size_t *decodedLength)
+{
+    BMHexDecodeState state;
+    BMHexDecodeInit(&state);
+    return BMHexDecodeUpdate(&state, string, length, buffer, decodedLength) && BMHexDecodeFinal(&state);
+}
+
+
+void BMHexDecodeInit(BMHexDecodeState *state)
+{
+    state->nibble = 0;
+    state->pending = false;
+}
+
+
+size_t BMHexDecodeUpdateMaxLength(size_t length)
+{
+    return (length + 1) / 2;
+}
+
+
+bool BMHexDecodeUpdate(BMHexDecodeState *state, const char *string, size_t length, void *buffer, size_t *decodedLength)
+{
+    const uint8_t *s = (const uint8_t *)string, *end = s + length;
+    uint8_t *bufptr = (uint8_t *)buffer;
+    bool succeeded = true;
+    
+    // Complete the byte left over from the previous chunk
+    if (state->pending && s < end) {
+        uint8_t value = BMHexDecodingTable[*s++];
+        if (value > 15) {
+            return false;
+        }
+        *bufptr++ = (uint8_t)(state->nibble << 4) | value;
+        state->pending = false;
+    }
+    
+    while (s < end) {
+        const uint8_t *stop = end;
+#if defined(BMHEX_SSE2) || defined(BMHEX_NEON)
+        if (end - s >= 32) {
+            if (BMHexDecodeVector(s, bufptr)) {
+                s += 32;
+                bufptr += 16;
+                continue;
+            }
+            // Decode this block by hand, it contains separators or invalid characters
+            stop = s + 32;
+        }
+#endif
+        while (s < stop) {
+            uint8_t hi = BMHexDecodingTable[*s++];
+            if (hi == 16) {
+                continue;
+            }
+            if (hi > 15) {
+                succeeded = false;
+                break;
+            }
+            if (s == end) {
+                state->nibble = hi;
+                state->pending = true;
+                break;
+            }
+            uint8_t lo = BMHexDecodingTable[*s++];
+            if (lo > 15) {
+                succeeded = false;
+                break;
+            }
+            *bufptr++ = (uint8_t)(hi << 4) | lo;
+        }
+        if (!succeeded) {
+            break;
+        }
+    }
+    if (succeeded && decodedLength) {
+        *decodedLength = bufptr - (uint8_t *)buffer;
+    }
+    return succeeded;
+}
+
+
+bool BMHexDecodeFinal(BMHexDecodeState *state)
+{
+    bool succeeded = !state->pending;
+    BMHexDecodeInit(state);
+    return succeeded;
+}
@@ -0,0 +1,75 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __BMHEX__
+#define __BMHEX__
+
+#include <sys/cdefs.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+__BEGIN_DECLS
+
+/** Options for hex encoding. */
+typedef enum _BMHexEncodeOptions {
+    BMHexEncodeLowercase = 0,       /**< Use the lowercase digits `a` to `f`. */
+    BMHexEncodeUppercase = 1 << 0,  /**< Use the uppercase digits `A` to `F`. */
+} BMHexEncodeOptions;
+
+/** Returns the number of characters required to hex-encode _length_ bytes with a separator after every _groupLength_ bytes, or without separators if _groupLength_ is 0. */
+extern size_t BMHexEncodedLength(size_t length, size_t groupLength);
+
+/** Hex-encodes _length_ bytes from _bytes_ into _buffer_, which must hold at least `BMHexEncodedLength(length, groupLength)` characters, and returns the number of characters written. If _groupLength_ is not 0, the _separator_ character is inserted between every _groupLength_ bytes, i.e. a _groupLength_ of 1 with a _separator_ of `':'` yields `"0a:1b:2c"`. */
+extern size_t BMHexEncode(const void *bytes, size_t length, char *buffer, BMHexEncodeOptions options, char separator, size_t groupLength);
+
+/** Returns an upper bound for the number of bytes produced by decoding _length_ hex characters. */
+extern size_t BMHexDecodedMaxLength(size_t length);
+
+/** Decodes _length_ hex characters from _string_ into _buffer_, which must hold at least `BMHexDecodedMaxLength(length)` bytes. Both lowercase and uppercase digits are accepted, and whitespace, `':'` and `'-'` are skipped between bytes. Returns `false` if _string_ contains an invalid character or an odd number of digits, otherwise stores the number of decoded bytes in _decodedLength_ and returns `true`. */
+extern bool BMHexDecode(const char *string, size_t length, void *buffer, size_t *decodedLength);
+
+/** State of an incremental hex decoding. */
+typedef struct _BMHexDecodeState {
+    unsigned char nibble;
+    bool          pending;
+} BMHexDecodeState;
+
+/** Initializes _state_ for a new incremental hex decoding. */
+extern void BMHexDecodeInit(BMHexDecodeState *state);
+
+/** Returns the number of bytes a single `BMHexDecodeUpdate` call with _length_ characters may produce at most. */
+extern size_t BMHexDecodeUpdateMaxLength(size_t length);
+
+/** Decodes the next _length_ hex characters from _string_ into _buffer_, which must hold at least `BMHexDecodeUpdateMaxLength(length)` bytes. A digit at the end of the chunk is kept in _state_ until its partner arrives. Returns `false` if _string_ contains an invalid character, otherwise stores the number of decoded bytes in _decodedLength_ and returns `true`. */
+extern bool BMHexDecodeUpdate(BMHexDecodeState *state, const char *string, size_t length, void *buffer, size_t *decodedLength);
+
+/** Finishes the incremental hex decoding in _state_, and returns `false` if an unpaired digit is left. */
+extern bool BMHexDecodeFinal(BMHexDecodeState *state);
+
+__END_DECLS
+
+#endif /* !__BMHEX__ */
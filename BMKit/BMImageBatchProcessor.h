@@ -0,0 +1,118 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <dispatch/dispatch.h>
+
+#import <Foundation/Foundation.h>
+
+#import "BMKitTypes.h"
+
+#include "BMImageUtilities.h"
+
+
+/** The block invoked for each processed input of an image batch processor.
+ 
+ @param index The index of the input in the array passed to `processInputs:itemCompletionBlock:completionBlock:`.
+ @param data The encoded result, or `nil` if the input could not be read, decoded or encoded.
+ @param stats The time spent in the stages of the image pipeline for the input.
+ */
+typedef void (^BMImageBatchItemBlock)(NSUInteger index, NSData *data, const BMImagePipelineStats *stats);
+
+
+/** You use an image batch processor to run the image pipeline of `BMImageCopyDataWithOptions` over many encoded images, using all available cores.
+ 
+ Instead of running a fixed number of images at once, the processor limits the number of bytes in flight to its memory budget. Before an image is decoded, its size and orientation are read from its header, and the image is only started if the memory it needs, as estimated by `BMImagePipelineGetMemoryLength` for the copy of its decoded pixels and the result, fits into what is left of the budget. An image that is larger than the whole budget runs alone. So many small images run in parallel, while a few huge images do not exhaust the available memory.
+ 
+ Each input is processed with the pipeline options of the receiver, except for the orientation, which is taken from the EXIF orientation of the input. The results stream back through blocks on the callback queue as the images finish, which is not necessarily in the order of the inputs.
+ */
+@interface BMImageBatchProcessor : NSObject {
+@private
+    BMImagePipelineOptions  _options;
+    unsigned long long      _memoryBudget;
+    unsigned long long      _bytesInFlight;
+    NSUInteger              _generation;
+    NSCondition            *_condition;
+    dispatch_queue_t        _queue;
+    dispatch_queue_t        _callbackQueue;
+    dispatch_group_t        _group;
+}
+
+/** The pipeline options used for every input. The orientation is ignored, the EXIF orientation of each input is used instead. */
+@property (nonatomic, assign, readonly) BMImagePipelineOptions options;
+
+/** The maximum number of bytes in flight, see `BMImagePipelineGetMemoryLength`. Defaults to a quarter of the physical memory. */
+@property (assign) unsigned long long memoryBudget;
+
+/** The serial queue on which the item and completion blocks are invoked. Defaults to the main queue. */
+@property (nonatomic, assign) dispatch_queue_t callbackQueue;
+
+///-----------------------------------------------
+/// @name Initializing an Image Batch Processor
+///-----------------------------------------------
+
+/** Initializes the receiver with the default pipeline options, see `BMImagePipelineOptionsInit`.
+ 
+ @return The initialized receiver.
+ @see initWithOptions:
+ */
+- (id)init;
+
+/** Initializes the receiver with the given pipeline options.
+ 
+ @param options The pipeline options used for every input.
+ @return The initialized receiver, or `nil` if *options* is `NULL`.
+ */
+- (id)initWithOptions:(const BMImagePipelineOptions *)options;
+
+///----------------------------
+/// @name Processing Images
+///----------------------------
+
+/** Processes the inputs in the background and returns immediately.
+ 
+ This method raises `NSInvalidArgumentException` if any of the inputs is not an `NSData`, `NSURL` or `NSString` object.
+ 
+ @param inputs An array of encoded images, given as `NSData` objects, file URLs or paths.
+ @param itemBlock The block invoked on the callback queue with the result for each input, may be `nil`.
+ @param completionBlock The block invoked on the callback queue after the blocks for all inputs, may be `nil`.
+ @see cancel
+ @see waitUntilFinished
+ */
+- (void)processInputs:(NSArray *)inputs itemCompletionBlock:(BMImageBatchItemBlock)itemBlock completionBlock:(BMBlock)completionBlock;
+
+/** Stops processing the inputs of all batches that have been started so far.
+ 
+ Images that are already being decoded or encoded run to completion, and their item blocks are invoked. The remaining inputs, including inputs that were admitted under the memory budget but not decoded yet, are skipped without invoking their item blocks, and their share of the budget is released. The completion blocks are still invoked.
+ */
+- (void)cancel;
+
+/** Blocks the current thread until all inputs of all batches that have been started so far are processed.
+ 
+ The item and completion blocks may still be pending on the callback queue afterwards.
+ */
+- (void)waitUntilFinished;
+
+@end
@@ -0,0 +1,291 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <string.h>
+
+#include <ImageIO/ImageIO.h>
+
+#import "BMImageBatchProcessor.h"
+
+
+@interface BMImageBatchProcessor (BMKitInternals)
+
+- (BOOL)BM_reserveBytes:(unsigned long long)length generation:(NSUInteger)generation;
+- (void)BM_releaseBytes:(unsigned long long)length;
+- (BOOL)BM_isCancelledGeneration:(NSUInteger)generation;
+
+@end
+
+
+static CGImageSourceRef BMImageBatchCreateImageSource(id input)
+{
+    CGImageSourceRef imageSource;
+    if ([input isKindOfClass:[NSData class]]) {
+        imageSource = CGImageSourceCreateWithData((CFDataRef)input, NULL);
+    }
+    else {
+        NSURL *URL = [input isKindOfClass:[NSURL class]] ? (NSURL *)input : [NSURL fileURLWithPath:input];
+        imageSource = CGImageSourceCreateWithURL((CFURLRef)URL, NULL);
+    }
+    return imageSource;
+}
+
+
+@implementation BMImageBatchProcessor
+
+
+- (id)init
+{
+    BMImagePipelineOptions options;
+    BMImagePipelineOptionsInit(&options);
+    return [self initWithOptions:&options];
+}
+
+
+- (id)initWithOptions:(const BMImagePipelineOptions *)options
+{
+    self = [super init];
+    if (self) {
+        if (!options) {
+            [self release];
+            return nil;
+        }
+        _options = *options;
+        if (_options.encoderOptions.type) CFRetain(_options.encoderOptions.type);
+        _memoryBudget = [[NSProcessInfo processInfo] physicalMemory] / 4;
+        _condition = [[NSCondition alloc] init];
+        _queue = dispatch_queue_create("BMImageBatchProcessor", NULL);
+        _callbackQueue = dispatch_get_main_queue();
+        dispatch_retain(_callbackQueue);
+        _group = dispatch_group_create();
+    }
+    return self;
+}
+
+
+- (void)dealloc
+{
+    if (_group) dispatch_release(_group), _group = NULL;
+    if (_callbackQueue) dispatch_release(_callbackQueue), _callbackQueue = NULL;
+    if (_queue) dispatch_release(_queue), _queue = NULL;
+    [_condition release], _condition = nil;
+    if (_options.encoderOptions.type) CFRelease(_options.encoderOptions.type), _options.encoderOptions.type = NULL;
+    [super dealloc];
+}
+
+
+#pragma mark -
+#pragma mark Properties
+
+
+- (BMImagePipelineOptions)options
+{
+    return _options;
+}
+
+
+- (unsigned long long)memoryBudget
+{
+    [_condition lock];
+    unsigned long long memoryBudget = _memoryBudget;
+    [_condition unlock];
+    return memoryBudget;
+}
+
+
+- (void)setMemoryBudget:(unsigned long long)memoryBudget
+{
+    [_condition lock];
+    _memoryBudget = memoryBudget;
+    [_condition broadcast];
+    [_condition unlock];
+}
+
+
+- (dispatch_queue_t)callbackQueue
+{
+    return _callbackQueue;
+}
+
+
+- (void)setCallbackQueue:(dispatch_queue_t)callbackQueue
+{
+    if (!callbackQueue) {
+        [NSException raise:NSInvalidArgumentException
+                    format:@"callbackQueue is NULL (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    dispatch_retain(callbackQueue);
+    dispatch_release(_callbackQueue);
+    _callbackQueue = callbackQueue;
+}
+
+
+#pragma mark -
+#pragma mark Memory Budget
+
+
+- (BOOL)BM_reserveBytes:(unsigned long long)length generation:(NSUInteger)generation
+{
+    // Wait until the bytes fit into the budget, but always admit
+    // a single image, no matter how large it is
+    [_condition lock];
+    while (_bytesInFlight && _bytesInFlight + length > _memoryBudget && generation == _generation) {
+        [_condition wait];
+    }
+    BOOL reserved = (generation == _generation);
+    if (reserved) {
+        _bytesInFlight += length;
+    }
+    [_condition unlock];
+    return reserved;
+}
+
+
+- (void)BM_releaseBytes:(unsigned long long)length
+{
+    [_condition lock];
+    _bytesInFlight -= length;
+    [_condition broadcast];
+    [_condition unlock];
+}
+
+
+- (BOOL)BM_isCancelledGeneration:(NSUInteger)generation
+{
+    [_condition lock];
+    BOOL cancelled = (generation != _generation);
+    [_condition unlock];
+    return cancelled;
+}
+
+
+#pragma mark -
+#pragma mark Processing Images
+
+
+- (void)processInputs:(NSArray *)inputs itemCompletionBlock:(BMImageBatchItemBlock)itemBlock completionBlock:(BMBlock)completionBlock
+{
+    for (id input in inputs) {
+        if (![input isKindOfClass:[NSData class]] && ![input isKindOfClass:[NSURL class]] && ![input isKindOfClass:[NSString class]]) {
+            [NSException raise:NSInvalidArgumentException
+                        format:@"Input %@ is not an NSData, NSURL or NSString object (in '%@')", input, NSStringFromSelector(_cmd)];
+        }
+    }
+    inputs = [[inputs copy] autorelease];
+    
+    [_condition lock];
+    NSUInteger generation = _generation;
+    [_condition unlock];
+    
+    // The batch sticks to the callback queue it was started with
+    dispatch_queue_t callbackQueue = _callbackQueue;
+    dispatch_retain(callbackQueue);
+    
+    // The inputs are admitted one by one on the private serial queue, which
+    // waits for the memory budget, and processed on the global queue
+    dispatch_group_enter(_group);
+    dispatch_async(_queue, ^{
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        dispatch_queue_t workQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+        dispatch_group_t batchGroup = dispatch_group_create();
+        NSUInteger count = [inputs count];
+        for (NSUInteger index = 0; index < count; ++index) {
+            // Estimate the memory needed by the pipeline from the image header
+            CGImageSourceRef imageSource = BMImageBatchCreateImageSource([inputs objectAtIndex:index]);
+            size_t width = 0, height = 0;
+            BMImageOrientation imageOrientation = BMImageOrientationUp;
+            if (imageSource) {
+                BMImageSourceGetSize(imageSource, 0, &width, &height, &imageOrientation);
+            }
+            BMImagePipelineOptions imageOptions = _options;
+            imageOptions.orientation = imageOrientation;
+            unsigned long long length = BMImagePipelineGetMemoryLength(width, height, &imageOptions);
+            if (![self BM_reserveBytes:length generation:generation]) {
+                // The batch was cancelled
+                if (imageSource) CFRelease(imageSource);
+                break;
+            }
+            
+            dispatch_group_async(batchGroup, workQueue, ^{
+                NSAutoreleasePool *workPool = [[NSAutoreleasePool alloc] init];
+                BMImagePipelineStats stats;
+                memset(&stats, 0, sizeof(stats));
+                NSData *data = nil;
+                
+                // Inputs admitted before the batch was cancelled are skipped
+                // as well, unless they are being decoded already
+                BOOL cancelled = [self BM_isCancelledGeneration:generation];
+                if (imageSource) {
+                    CGImageRef image = cancelled ? NULL : CGImageSourceCreateImageAtIndex(imageSource, 0, NULL);
+                    if (image) {
+                        BMImagePipelineOptions options = _options;
+                        options.orientation = imageOrientation;
+                        data = [(NSData *)BMImageCopyDataWithOptions(image, &options, &stats) autorelease];
+                        CGImageRelease(image);
+                    }
+                    CFRelease(imageSource);
+                }
+                [self BM_releaseBytes:length];
+                if (itemBlock && !cancelled) {
+                    dispatch_async(callbackQueue, ^{
+                        itemBlock(index, data, &stats);
+                    });
+                }
+                [workPool drain];
+            });
+        }
+        
+        // The item blocks are queued on the serial callback queue before the
+        // work blocks finish, so the completion block is always invoked last
+        dispatch_group_notify(batchGroup, _queue, ^{
+            if (completionBlock) {
+                dispatch_async(callbackQueue, completionBlock);
+            }
+            dispatch_release(callbackQueue);
+            dispatch_group_leave(_group);
+        });
+        dispatch_release(batchGroup);
+        [pool drain];
+    });
+}
+
+
+- (void)cancel
+{
+    [_condition lock];
+    _generation++;
+    [_condition broadcast];
+    [_condition unlock];
+}
+
+
+- (void)waitUntilFinished
+{
+    dispatch_group_wait(_group, DISPATCH_TIME_FOREVER);
+}
+
+
+@end
@@ -0,0 +1,530 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "BMImageProbe.h"
+
+
+static inline uint16_t BMImageProbeRead16(const uint8_t *bytes, bool bigEndian)
+{
+    return bigEndian
+         ? (uint16_t)((bytes[0] << 8) | bytes[1])
+         : (uint16_t)((bytes[1] << 8) | bytes[0]);
+}
+
+
+static inline uint32_t BMImageProbeRead32(const uint8_t *bytes, bool bigEndian)
+{
+    return bigEndian
+         ? ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3]
+         : ((uint32_t)bytes[3] << 24) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[1] << 8) | bytes[0];
+}
+
+
+static inline uint64_t BMImageProbeRead64(const uint8_t *bytes)
+{
+    return ((uint64_t)BMImageProbeRead32(bytes, true) << 32) | BMImageProbeRead32(bytes + 4, true);
+}
+
+
+// Returns the orientation tag of the first IFD of TIFF structured EXIF data,
+// or "Up" if there is none
+static BMImageOrientation BMImageProbeGetExifOrientation(const uint8_t *tiff, size_t length)
+{
+    if (length >= 8 && tiff[0] == tiff[1] && (tiff[0] == 'I' || tiff[0] == 'M')) {
+        bool bigEndian = (tiff[0] == 'M');
+        uint32_t offset = BMImageProbeRead32(tiff + 4, bigEndian);
+        if (BMImageProbeRead16(tiff + 2, bigEndian) == 42 && offset <= length - 2) {
+            unsigned count = BMImageProbeRead16(tiff + offset, bigEndian);
+            const uint8_t *entry = tiff + offset + 2;
+            for (; count > 0 && (size_t)(entry + 12 - tiff) <= length; --count, entry += 12) {
+                // The orientation is a single SHORT, stored in the value field
+                if (BMImageProbeRead16(entry, bigEndian) == 0x0112 && BMImageProbeRead16(entry + 2, bigEndian) == 3) {
+                    unsigned orientation = BMImageProbeRead16(entry + 8, bigEndian);
+                    if (orientation >= BMImageOrientationUp && orientation <= BMImageOrientationRight) {
+                        return (BMImageOrientation)orientation;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    return BMImageOrientationUp;
+}
+
+
+#pragma mark -
+#pragma mark JPEG
+
+
+static BMImageProbeStatus BMImageProbeJPEG(const uint8_t *bytes, size_t length, BMImageInfo *info)
+{
+    bool hasExif = false;
+    size_t offset = 2;
+    for (;;) {
+        // Markers may be preceded by any number of fill bytes
+        if (offset >= length) {
+            return BMImageProbeStatusTruncated;
+        }
+        if (bytes[offset] != 0xFF) {
+            return BMImageProbeStatusInvalid;
+        }
+        while (offset < length && bytes[offset] == 0xFF) {
+            ++offset;
+        }
+        if (offset >= length) {
+            return BMImageProbeStatusTruncated;
+        }
+        uint8_t marker = bytes[offset++];
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+            // Markers without segment
+            continue;
+        }
+        if (marker == 0xD9 || marker == 0xDA) {
+            // End of image or start of scan before the frame header
+            return BMImageProbeStatusInvalid;
+        }
+        if (length - offset < 2) {
+            return BMImageProbeStatusTruncated;
+        }
+        size_t segmentLength = BMImageProbeRead16(bytes + offset, true);
+        if (segmentLength < 2) {
+            return BMImageProbeStatusInvalid;
+        }
+        if (length - offset < segmentLength) {
+            return BMImageProbeStatusTruncated;
+        }
+        const uint8_t *segment = bytes + offset + 2;
+        size_t segmentDataLength = segmentLength - 2;
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            // Start of frame, the APPn segments come before it
+            if (segmentDataLength < 6) {
+                return BMImageProbeStatusInvalid;
+            }
+            unsigned components = segment[5];
+            info->bitsPerComponent = segment[0];
+            info->height = BMImageProbeRead16(segment + 1, true);
+            info->width = BMImageProbeRead16(segment + 3, true);
+            // Three components are YCbCr or RGB, four are YCCK or CMYK
+            if (components == 1) {
+                info->colorModel = BMImageColorModelGray;
+            }
+            else if (components == 3) {
+                info->colorModel = BMImageColorModelRGB;
+            }
+            else if (components == 4) {
+                info->colorModel = BMImageColorModelCMYK;
+            }
+            // A height of 0 is only defined later by a DNL segment, which is
+            // not worth scanning the entropy coded data for
+            if (!info->width || !info->height || !info->colorModel) {
+                return BMImageProbeStatusInvalid;
+            }
+            return BMImageProbeStatusComplete;
+        }
+        if (marker == 0xE1 && !hasExif && segmentDataLength >= 6 && memcmp(segment, "Exif\0\0", 6) == 0) {
+            info->orientation = BMImageProbeGetExifOrientation(segment + 6, segmentDataLength - 6);
+            hasExif = true;
+        }
+        offset += segmentLength;
+    }
+}
+
+
+#pragma mark -
+#pragma mark PNG
+
+
+static const uint8_t BMImageProbePNGSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+
+static BMImageProbeStatus BMImageProbePNG(const uint8_t *bytes, size_t length, BMImageInfo *info)
+{
+    // The IHDR chunk must come first
+    if (length < 33) {
+        return BMImageProbeStatusTruncated;
+    }
+    if (BMImageProbeRead32(bytes + 8, true) != 13 || memcmp(bytes + 12, "IHDR", 4) != 0) {
+        return BMImageProbeStatusInvalid;
+    }
+    uint32_t width = BMImageProbeRead32(bytes + 16, true);
+    uint32_t height = BMImageProbeRead32(bytes + 20, true);
+    unsigned bitDepth = bytes[24];
+    switch (bytes[25]) {
+        case 0:
+            info->colorModel = BMImageColorModelGray;
+            break;
+        case 2:
+            info->colorModel = BMImageColorModelRGB;
+            break;
+        case 3:
+            info->colorModel = BMImageColorModelIndexed;
+            break;
+        case 4:
+            info->colorModel = BMImageColorModelGray;
+            info->hasAlpha = true;
+            break;
+        case 6:
+            info->colorModel = BMImageColorModelRGB;
+            info->hasAlpha = true;
+            break;
+        default:
+            return BMImageProbeStatusInvalid;
+    }
+    if (width == 0 || width > INT32_MAX || height == 0 || height > INT32_MAX || bitDepth == 0 || bitDepth > 16) {
+        return BMImageProbeStatusInvalid;
+    }
+    info->width = width;
+    info->height = height;
+    info->bitsPerComponent = bitDepth;
+    
+    // Look for the eXIf and tRNS chunks, which must come before the image data
+    size_t offset = 33;
+    for (;;) {
+        if (length - offset < 8) {
+            return BMImageProbeStatusTruncated;
+        }
+        size_t chunkLength = BMImageProbeRead32(bytes + offset, true);
+        const uint8_t *chunkType = bytes + offset + 4;
+        if (memcmp(chunkType, "IDAT", 4) == 0 || memcmp(chunkType, "IEND", 4) == 0) {
+            return BMImageProbeStatusComplete;
+        }
+        if (chunkLength > INT32_MAX) {
+            return BMImageProbeStatusInvalid;
+        }
+        if (length - offset - 8 < chunkLength + 4) {
+            return BMImageProbeStatusTruncated;
+        }
+        if (memcmp(chunkType, "eXIf", 4) == 0) {
+            info->orientation = BMImageProbeGetExifOrientation(bytes + offset + 8, chunkLength);
+        }
+        else if (memcmp(chunkType, "tRNS", 4) == 0) {
+            info->hasAlpha = true;
+        }
+        offset += 8 + chunkLength + 4;
+    }
+}
+
+
+#pragma mark -
+#pragma mark HEIF
+
+
+#define BMImageProbeFourCC(a, b, c, d) (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 8) | (uint32_t)(d))
+
+
+// An ISO base media file format box, with its data from start to end
+typedef struct _BMImageProbeBox {
+    uint32_t       type;
+    const uint8_t *start;
+    const uint8_t *end;
+} BMImageProbeBox;
+
+
+// Reads the header of the box at the start of bytes, whose container ends at end,
+// and checks that the whole box is available
+static BMImageProbeStatus BMImageProbeReadBox(const uint8_t *bytes, const uint8_t *end, BMImageProbeBox *box)
+{
+    size_t available = (size_t)(end - bytes);
+    if (available < 8) {
+        return BMImageProbeStatusTruncated;
+    }
+    uint64_t size = BMImageProbeRead32(bytes, true);
+    size_t headerLength = 8;
+    box->type = BMImageProbeRead32(bytes + 4, true);
+    if (size == 1) {
+        if (available < 16) {
+            return BMImageProbeStatusTruncated;
+        }
+        size = BMImageProbeRead64(bytes + 8);
+        headerLength = 16;
+    }
+    else if (size == 0) {
+        // The box extends to the end of its container
+        size = available;
+    }
+    if (size < headerLength) {
+        return BMImageProbeStatusInvalid;
+    }
+    if (size > available) {
+        return BMImageProbeStatusTruncated;
+    }
+    box->start = bytes + headerLength;
+    box->end = bytes + size;
+    return BMImageProbeStatusComplete;
+}
+
+
+// Finds the first box of the given type among the boxes from bytes to end,
+// which must all be available
+static bool BMImageProbeFindBox(const uint8_t *bytes, const uint8_t *end, uint32_t type, BMImageProbeBox *box)
+{
+    while (bytes < end && BMImageProbeReadBox(bytes, end, box) == BMImageProbeStatusComplete) {
+        if (box->type == type) {
+            return true;
+        }
+        bytes = box->end;
+    }
+    return false;
+}
+
+
+// Finds the property box with the given one-based index in the ipco box
+static bool BMImageProbeGetProperty(const BMImageProbeBox *ipco, unsigned index, BMImageProbeBox *property)
+{
+    const uint8_t *bytes = ipco->start;
+    while (bytes < ipco->end && BMImageProbeReadBox(bytes, ipco->end, property) == BMImageProbeStatusComplete) {
+        if (--index == 0) {
+            return true;
+        }
+        bytes = property->end;
+    }
+    return false;
+}
+
+
+// Applies a rotation or mirroring after the transformation to "Up" orientation
+// given as mirroring followed by clockwise quarter turns
+static void BMImageProbeTransform(bool *mirrored, unsigned *turns, bool mirror, unsigned quarterTurns)
+{
+    // Mirroring after rotating is the same as rotating the other way after mirroring
+    *turns = (quarterTurns + (mirror ? 4 - *turns : *turns)) % 4;
+    *mirrored = (*mirrored != mirror);
+}
+
+
+static BMImageProbeStatus BMImageProbeHEIF(const uint8_t *bytes, size_t length, BMImageInfo *info)
+{
+    static const uint32_t brands[] = {
+        BMImageProbeFourCC('m', 'i', 'f', '1'), BMImageProbeFourCC('m', 's', 'f', '1'),
+        BMImageProbeFourCC('h', 'e', 'i', 'c'), BMImageProbeFourCC('h', 'e', 'i', 'x'),
+        BMImageProbeFourCC('h', 'e', 'v', 'c'), BMImageProbeFourCC('h', 'e', 'v', 'x'),
+        BMImageProbeFourCC('a', 'v', 'i', 'f'), BMImageProbeFourCC('a', 'v', 'i', 's')
+    };
+    const uint8_t *end = bytes + length;
+    
+    // The ftyp box must come first, and list a HEIF brand as major or compatible brand
+    BMImageProbeBox box;
+    BMImageProbeStatus status = BMImageProbeReadBox(bytes, end, &box);
+    if (status != BMImageProbeStatusComplete) {
+        return status;
+    }
+    bool hasBrand = false;
+    for (const uint8_t *brand = box.start; !hasBrand && box.end - brand >= 4; brand += (brand == box.start) ? 8 : 4) {
+        for (size_t i = 0; i < sizeof(brands) / sizeof(brands[0]); ++i) {
+            if (BMImageProbeRead32(brand, true) == brands[i]) {
+                hasBrand = true;
+                break;
+            }
+        }
+    }
+    if (!hasBrand) {
+        return BMImageProbeStatusInvalid;
+    }
+    
+    // Find the meta box, which usually comes right after the ftyp box
+    do {
+        status = BMImageProbeReadBox(box.end, end, &box);
+        if (status != BMImageProbeStatusComplete) {
+            return status;
+        }
+    } while (box.type != BMImageProbeFourCC('m', 'e', 't', 'a'));
+    if (box.end - box.start < 4) {
+        return BMImageProbeStatusInvalid;
+    }
+    const uint8_t *meta = box.start + 4;
+    
+    // Find the primary item and its properties
+    BMImageProbeBox pitm, iprp, ipco, ipma;
+    if (!BMImageProbeFindBox(meta, box.end, BMImageProbeFourCC('p', 'i', 't', 'm'), &pitm)
+        || !BMImageProbeFindBox(meta, box.end, BMImageProbeFourCC('i', 'p', 'r', 'p'), &iprp)
+        || !BMImageProbeFindBox(iprp.start, iprp.end, BMImageProbeFourCC('i', 'p', 'c', 'o'), &ipco)
+        || !BMImageProbeFindBox(iprp.start, iprp.end, BMImageProbeFourCC('i', 'p', 'm', 'a'), &ipma)
+        || pitm.end - pitm.start < ((pitm.start < pitm.end && pitm.start[0] == 0) ? 6 : 8)
+        || ipma.end - ipma.start < 8) {
+        return BMImageProbeStatusInvalid;
+    }
+    uint32_t primaryItem = (pitm.start[0] == 0) ? BMImageProbeRead16(pitm.start + 4, true) : BMImageProbeRead32(pitm.start + 4, true);
+    
+    unsigned version = ipma.start[0];
+    bool largeIndices = (ipma.start[3] & 1);
+    size_t itemLength = (version < 1) ? 2 : 4;
+    size_t indexLength = largeIndices ? 2 : 1;
+    uint32_t entries = BMImageProbeRead32(ipma.start + 4, true);
+    const uint8_t *entry = ipma.start + 8;
+    bool mirrored = false;
+    unsigned turns = 0;
+    bool hasSize = false;
+    info->colorModel = BMImageColorModelRGB;
+    info->bitsPerComponent = 8;
+    for (; entries > 0; --entries) {
+        if ((size_t)(ipma.end - entry) < itemLength + 1) {
+            return BMImageProbeStatusInvalid;
+        }
+        uint32_t item = (itemLength == 2) ? BMImageProbeRead16(entry, true) : BMImageProbeRead32(entry, true);
+        unsigned associations = entry[itemLength];
+        entry += itemLength + 1;
+        if ((size_t)(ipma.end - entry) < associations * indexLength) {
+            return BMImageProbeStatusInvalid;
+        }
+        if (item != primaryItem) {
+            entry += associations * indexLength;
+            continue;
+        }
+        
+        // Apply the properties in the order of association, which matters
+        // for the rotation and mirroring
+        for (; associations > 0; --associations, entry += indexLength) {
+            unsigned index = largeIndices ? (BMImageProbeRead16(entry, true) & 0x7FFF) : (entry[0] & 0x7F);
+            BMImageProbeBox property;
+            if (index == 0 || !BMImageProbeGetProperty(&ipco, index, &property)) {
+                continue;
+            }
+            size_t propertyLength = (size_t)(property.end - property.start);
+            switch (property.type) {
+                case BMImageProbeFourCC('i', 's', 'p', 'e'):
+                    if (propertyLength >= 12) {
+                        info->width = BMImageProbeRead32(property.start + 4, true);
+                        info->height = BMImageProbeRead32(property.start + 8, true);
+                        hasSize = true;
+                    }
+                    break;
+                    
+                case BMImageProbeFourCC('i', 'r', 'o', 't'):
+                    // Anti-clockwise quarter turns
+                    if (propertyLength >= 1) {
+                        BMImageProbeTransform(&mirrored, &turns, false, (4 - (property.start[0] & 3)) % 4);
+                    }
+                    break;
+                    
+                case BMImageProbeFourCC('i', 'm', 'i', 'r'):
+                    // Mirroring about the vertical axis, or about the horizontal axis,
+                    // which is the same as mirroring about the vertical axis and a half turn
+                    if (propertyLength >= 1) {
+                        BMImageProbeTransform(&mirrored, &turns, true, (property.start[0] & 1) ? 2 : 0);
+                    }
+                    break;
+                    
+                case BMImageProbeFourCC('p', 'i', 'x', 'i'):
+                    if (propertyLength >= 6 && property.start[4] > 0) {
+                        info->colorModel = (property.start[4] < 3) ? BMImageColorModelGray : BMImageColorModelRGB;
+                        info->bitsPerComponent = property.start[5];
+                    }
+                    break;
+            }
+        }
+        break;
+    }
+    if (!hasSize || info->width == 0 || info->height == 0) {
+        return BMImageProbeStatusInvalid;
+    }
+    static const BMImageOrientation orientations[2][4] = {
+        { BMImageOrientationUp, BMImageOrientationLeft, BMImageOrientationDown, BMImageOrientationRight },
+        { BMImageOrientationUpMirrored, BMImageOrientationRightMirrored, BMImageOrientationDownMirrored, BMImageOrientationLeftMirrored }
+    };
+    info->orientation = orientations[mirrored][turns];
+    
+    // Alpha planes are stored as auxiliary items with their own auxC property
+    const uint8_t *bytesOfProperty = ipco.start;
+    BMImageProbeBox property;
+    while (!info->hasAlpha && bytesOfProperty < ipco.end && BMImageProbeReadBox(bytesOfProperty, ipco.end, &property) == BMImageProbeStatusComplete) {
+        if (property.type == BMImageProbeFourCC('a', 'u', 'x', 'C') && property.end - property.start > 4) {
+            const char *auxType = (const char *)property.start + 4;
+            size_t auxTypeLength = strnlen(auxType, (size_t)(property.end - property.start) - 4);
+            info->hasAlpha = ((auxTypeLength == 26 && memcmp(auxType, "urn:mpeg:hevc:2015:auxid:1", 26) == 0)
+                              || (auxTypeLength == 43 && memcmp(auxType, "urn:mpeg:mpegB:cicp:systems:auxiliary:alpha", 43) == 0));
+        }
+        bytesOfProperty = property.end;
+    }
+    return BMImageProbeStatusComplete;
+}
+
+
+#pragma mark -
+
+
+BMImageProbeStatus BMImageProbe(const void *bytes, size_t length, BMImageInfo *info)
+{
+    const uint8_t *b = (const uint8_t *)bytes;
+    memset(info, 0, sizeof(*info));
+    info->orientation = BMImageOrientationUp;
+    if (length >= 2 && b[0] == 0xFF && b[1] == 0xD8) {
+        info->format = BMImageFormatJPEG;
+        return BMImageProbeJPEG(b, length, info);
+    }
+    if (length >= 8 && memcmp(b, BMImageProbePNGSignature, 8) == 0) {
+        info->format = BMImageFormatPNG;
+        return BMImageProbePNG(b, length, info);
+    }
+    if (length >= 12 && memcmp(b + 4, "ftyp", 4) == 0) {
+        info->format = BMImageFormatHEIF;
+        return BMImageProbeHEIF(b, length, info);
+    }
+    // Too few bytes to tell the format
+    if (length < 12) {
+        return BMImageProbeStatusTruncated;
+    }
+    return BMImageProbeStatusInvalid;
+}
+
+
+bool BMImageProbeFile(int fd, BMImageInfo *info)
+{
+    BMImageProbeStatus status = BMImageProbeStatusTruncated;
+    uint8_t *buffer = NULL;
+    size_t length = 0;
+    for (size_t capacity = BMImageProbeInitialLength; status == BMImageProbeStatusTruncated && capacity <= BMImageProbeMaxLength; capacity *= 2) {
+        uint8_t *newBuffer = realloc(buffer, capacity);
+        if (!newBuffer) {
+            break;
+        }
+        buffer = newBuffer;
+        
+        // Read the bytes that follow the bytes probed before
+        while (length < capacity) {
+            ssize_t n = pread(fd, buffer + length, capacity - length, (off_t)length);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            length += (size_t)n;
+        }
+        status = BMImageProbe(buffer, length, info);
+        if (length < capacity) {
+            // The end of file or an I/O error, so there are no more bytes
+            break;
+        }
+    }
+    free(buffer);
+    return (status == BMImageProbeStatusComplete);
+}
@@ -0,0 +1,89 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __BMIMAGEPROBE__
+#define __BMIMAGEPROBE__
+
+#include <sys/cdefs.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "BMBitmapUtilities.h"
+
+__BEGIN_DECLS
+
+/** The number of leading bytes that is enough to probe most images, since only the headers in front of the pixel data are parsed (4 KiB). */
+#define BMImageProbeInitialLength ((size_t)4 << 10)
+
+/** The largest number of leading bytes `BMImageProbeFile` reads, which covers JPEG images with large EXIF thumbnails or ICC profiles in front of the frame header (1 MiB). */
+#define BMImageProbeMaxLength ((size_t)1 << 20)
+
+/** Image formats recognized by `BMImageProbe`. */
+typedef enum _BMImageFormat {
+    BMImageFormatUnknown = 0,
+    BMImageFormatJPEG    = 1,
+    BMImageFormatPNG     = 2,
+    BMImageFormatHEIF    = 3  /**< HEIF images, including HEIC and AVIF. */
+} BMImageFormat;
+
+/** Color models of the decoded pixels of an image. */
+typedef enum _BMImageColorModel {
+    BMImageColorModelUnknown = 0,
+    BMImageColorModelGray    = 1,
+    BMImageColorModelRGB     = 2, /**< RGB pixels, including JPEG and HEIF images coded as YCbCr. */
+    BMImageColorModelCMYK    = 3, /**< CMYK pixels, including JPEG images coded as YCCK. */
+    BMImageColorModelIndexed = 4  /**< Palette indices. */
+} BMImageColorModel;
+
+/** Results of `BMImageProbe`. */
+typedef enum _BMImageProbeStatus {
+    BMImageProbeStatusInvalid   = 0, /**< The bytes are not the start of a supported image. */
+    BMImageProbeStatusTruncated = 1, /**< The bytes are the start of a supported image, but its headers continue after them. */
+    BMImageProbeStatusComplete  = 2  /**< The image info is complete. */
+} BMImageProbeStatus;
+
+/** Information about an image from its headers. */
+typedef struct _BMImageInfo {
+    BMImageFormat      format;           /**< The image format. */
+    size_t             width;            /**< The width of the stored pixels, before applying _orientation_, see `BMBitmapGetOrientedSize`. */
+    size_t             height;           /**< The height of the stored pixels, before applying _orientation_. */
+    BMImageOrientation orientation;      /**< The EXIF orientation, from the EXIF data of JPEG and PNG images and the rotation and mirroring properties of HEIF images. `BMImageOrientationUp` if the image has none. */
+    BMImageColorModel  colorModel;       /**< The color model of the decoded pixels. */
+    unsigned           bitsPerComponent; /**< The bits per color component. */
+    bool               hasAlpha;         /**< Whether the image has an alpha channel or transparency. */
+} BMImageInfo;
+
+/** Parses the headers of a JPEG, PNG or HEIF image from the first _length_ bytes of the image and stores the result in _info_. Only the headers in front of the pixel data are looked at, and nothing is decoded or allocated, so this is cheap enough to call on every image. If `BMImageProbeStatusTruncated` is returned, the call should be repeated with more bytes. */
+extern BMImageProbeStatus BMImageProbe(const void *bytes, size_t length, BMImageInfo *info);
+
+/** Probes the image in the file descriptor _fd_, reading from offset 0 without changing the file offset. Reads `BMImageProbeInitialLength` bytes first, and reads more up to `BMImageProbeMaxLength` bytes only when the headers continue. Returns `false` if the file is not a supported image or an I/O error occurred. */
+extern bool BMImageProbeFile(int fd, BMImageInfo *info);
+
+__END_DECLS
+
+#endif /* !__BMIMAGEPROBE__ */
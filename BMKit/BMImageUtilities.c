@@ -25,52 +25,419 @@
  * SUCH DAMAGE.
  */
 
+#include <string.h>
+
 #include <ImageIO/ImageIO.h>
 #include <MobileCoreServices/MobileCoreServices.h>
 
+#include "BMBufferPool.h"
 #include "BMImageUtilities.h"
 
+// Side length in pixels of the destination tiles of the tiled image functions
+#define BMImageTileLength ((size_t)256)
 
-CFDataRef BMImageCopyJPEGData(CGImageRef         image,
-                              BMImageOrientation imageOrientation,
-                              float              imageQuality)
+
+#pragma mark -
+#pragma mark Encoding
+
+
+void BMImageEncoderOptionsInit(BMImageEncoderOptions *options)
 {
-    CFDataRef JPEGData = NULL;
-    if (image) {
+    memset(options, 0, sizeof(*options));
+    options->type = kUTTypeJPEG;
+    options->quality = 0.8f;
+    options->progressive = false;
+}
+
+
+bool BMImageCanEncodeType(CFStringRef type)
+{
+    bool canEncode = false;
+    if (type) {
+        CFArrayRef types = CGImageDestinationCopyTypeIdentifiers();
+        if (types) {
+            canEncode = CFArrayContainsValue(types, CFRangeMake(0, CFArrayGetCount(types)), type);
+            CFRelease(types);
+        }
+    }
+    return canEncode;
+}
+
+
+// Adds a dictionary with a single boolean or integer value to the image properties
+static void BMImageSetNestedProperty(CFMutableDictionaryRef properties, CFStringRef dictionaryKey, CFStringRef key, CFTypeRef value)
+{
+    CFDictionaryRef dictionary = CFDictionaryCreate(CFGetAllocator(properties),
+                                                    (const void **)&key,
+                                                    (const void **)&value,
+                                                    1,
+                                                    &kCFTypeDictionaryKeyCallBacks,
+                                                    &kCFTypeDictionaryValueCallBacks);
+    if (dictionary) {
+        CFDictionarySetValue(properties, dictionaryKey, dictionary);
+        CFRelease(dictionary);
+    }
+}
+
+
+// Returns the ImageIO properties for encoding an image as the options describe
+static CFDictionaryRef BMImageCreateEncoderProperties(CFAllocatorRef               allocator,
+                                                      BMImageOrientation           imageOrientation,
+                                                      const BMImageEncoderOptions *options)
+{
+    CFMutableDictionaryRef properties = CFDictionaryCreateMutable(allocator,
+                                                                  0,
+                                                                  &kCFTypeDictionaryKeyCallBacks,
+                                                                  &kCFTypeDictionaryValueCallBacks);
+    if (properties) {
+        CFNumberRef orientation = CFNumberCreate(allocator, kCFNumberIntType, &imageOrientation);
+        CFNumberRef quality = CFNumberCreate(allocator, kCFNumberFloatType, &options->quality);
+        if (orientation && quality) {
+            CFDictionarySetValue(properties, kCGImagePropertyOrientation, orientation);
+            CFDictionarySetValue(properties, kCGImageDestinationLossyCompressionQuality, quality);
+            if (options->progressive) {
+                if (UTTypeConformsTo(options->type, kUTTypeJPEG)) {
+                    BMImageSetNestedProperty(properties, kCGImagePropertyJFIFDictionary, kCGImagePropertyJFIFIsProgressive, kCFBooleanTrue);
+                }
+                else if (UTTypeConformsTo(options->type, kUTTypePNG)) {
+                    // Adam7 interlacing
+                    int interlaceType = 1;
+                    CFNumberRef interlace = CFNumberCreate(allocator, kCFNumberIntType, &interlaceType);
+                    if (interlace) {
+                        BMImageSetNestedProperty(properties, kCGImagePropertyPNGDictionary, kCGImagePropertyPNGInterlaceType, interlace);
+                        CFRelease(interlace);
+                    }
+                }
+            }
+        }
+        else {
+            CFRelease(properties), properties = NULL;
+        }
+        if (quality) CFRelease(quality);
+        if (orientation) CFRelease(orientation);
+    }
+    return properties;
+}
+
+
+CFDataRef BMImageCopyDataWithEncoderOptions(CGImageRef                   image,
+                                            BMImageOrientation           imageOrientation,
+                                            const BMImageEncoderOptions *options)
+{
+    CFMutableDataRef encodedData = NULL;
+    if (image && options && options->type) {
         CFAllocatorRef allocator = CFGetAllocator(image);
         CFMutableDataRef data = CFDataCreateMutable(allocator, 0);
         if (data) {
-            CGImageDestinationRef destination = CGImageDestinationCreateWithData(data, kUTTypeJPEG, 1, NULL);
+            CGImageDestinationRef destination = CGImageDestinationCreateWithData(data, options->type, 1, NULL);
             if (destination) {
-                CFStringRef keys[2];
-                CFTypeRef values[2];
-                keys[0] = kCGImagePropertyOrientation;
-                values[0] = CFNumberCreate(allocator, kCFNumberIntType, &imageOrientation);
-                keys[1] = kCGImageDestinationLossyCompressionQuality;
-                values[1] = CFNumberCreate(allocator, kCFNumberFloatType, &imageQuality);
-                if (values[0] && values[1]) {
-                    CFDictionaryRef properties = CFDictionaryCreate(allocator,
-                                                                    (const void **)keys,
-                                                                    (const void **)values,
-                                                                    2,
-                                                                    &kCFTypeDictionaryKeyCallBacks,
-                                                                    &kCFTypeDictionaryValueCallBacks);
-                    if (properties) {
-                        CGImageDestinationAddImage(destination, image, properties);
-                        if (CGImageDestinationFinalize(destination)) {
-                            JPEGData = CFDataCreateCopy(allocator, data);
-                        }
-                        CFRelease(properties);
+                CFDictionaryRef properties = BMImageCreateEncoderProperties(allocator, imageOrientation, options);
+                if (properties) {
+                    CGImageDestinationAddImage(destination, image, properties);
+                    if (CGImageDestinationFinalize(destination)) {
+                        // Hand out the data the encoder wrote into, instead of copying it
+                        encodedData = (CFMutableDataRef)CFRetain(data);
                     }
+                    CFRelease(properties);
                 }
-                if (values[1]) CFRelease(values[1]);
-                if (values[0]) CFRelease(values[0]);
                 CFRelease(destination);
             }
             CFRelease(data);
         }
     }
-    return JPEGData;
+    return encodedData;
+}
+
+
+CFDataRef BMImageCopyJPEGData(CGImageRef         image,
+                              BMImageOrientation imageOrientation,
+                              float              imageQuality)
+{
+    BMImageEncoderOptions options;
+    BMImageEncoderOptionsInit(&options);
+    options.quality = imageQuality;
+    return BMImageCopyDataWithEncoderOptions(image, imageOrientation, &options);
+}
+
+
+#pragma mark -
+#pragma mark Transformations
+
+
+BMBitmapScaleQuality BMImageGetBitmapScaleQuality(CGInterpolationQuality interpolationQuality)
+{
+    switch (interpolationQuality) {
+        case kCGInterpolationNone:
+            return BMBitmapScaleQualityLow;
+            
+        case kCGInterpolationDefault:
+        case kCGInterpolationLow:
+            return BMBitmapScaleQualityMedium;
+            
+        default:
+            return BMBitmapScaleQualityHigh;
+    }
+}
+
+
+// Copies the pixels of the image into a bitmap, as long as the pixel size is
+// supported by the BMBitmap functions, returns the data backing the bitmap
+static CFDataRef BMImageCopyBitmap(CGImageRef image, BMBitmap *bitmap)
+{
+    CFDataRef pixelData = NULL;
+    size_t bitsPerPixel = CGImageGetBitsPerPixel(image);
+    if ((bitsPerPixel == 8 || bitsPerPixel == 16 || bitsPerPixel == 32) && !CGImageIsMask(image)) {
+        pixelData = CGDataProviderCopyData(CGImageGetDataProvider(image));
+        if (pixelData) {
+            bitmap->data = (void *)CFDataGetBytePtr(pixelData);
+            bitmap->width = CGImageGetWidth(image);
+            bitmap->height = CGImageGetHeight(image);
+            bitmap->bytesPerRow = CGImageGetBytesPerRow(image);
+            bitmap->bytesPerPixel = bitsPerPixel / 8;
+            if ((size_t)CFDataGetLength(pixelData) < bitmap->bytesPerRow * bitmap->height) {
+                CFRelease(pixelData);
+                pixelData = NULL;
+            }
+        }
+    }
+    return pixelData;
+}
+
+
+// Allocates the pixels for a bitmap of the given width, height and bytes per pixel
+// from the default buffer pool, with 16 byte aligned rows
+static bool BMImageAllocateBitmap(BMBitmap *bitmap)
+{
+    bitmap->bytesPerRow = (bitmap->width * bitmap->bytesPerPixel + 15) & ~(size_t)15;
+    bitmap->data = BMBufferPoolAllocate(BMBufferPoolGetDefault(), bitmap->bytesPerRow * bitmap->height);
+    return (bitmap->data != NULL);
+}
+
+
+// Returns the pixels of a bitmap allocated with BMImageAllocateBitmap to the pool
+static void BMImageFreeBitmap(const BMBitmap *bitmap)
+{
+    BMBufferPoolFree(BMBufferPoolGetDefault(), bitmap->data, bitmap->bytesPerRow * bitmap->height);
+}
+
+
+static void BMImageReleasePooledData(void *info, const void *data, size_t size)
+{
+    BMBufferPoolFree(BMBufferPoolGetDefault(), (void *)data, size);
+}
+
+
+// Creates an image from pixels allocated from the default buffer pool without copying
+// them; the image returns the pixels to the pool when it goes away, and if the image
+// cannot be created, the pixels are returned right away
+static CGImageRef BMImageCreateWithPooledData(void                  *data,
+                                              size_t                 width,
+                                              size_t                 height,
+                                              size_t                 bitsPerComponent,
+                                              size_t                 bitsPerPixel,
+                                              size_t                 bytesPerRow,
+                                              CGColorSpaceRef        colorSpace,
+                                              CGBitmapInfo           bitmapInfo,
+                                              const CGFloat         *decode,
+                                              bool                   shouldInterpolate,
+                                              CGColorRenderingIntent renderingIntent)
+{
+    CGImageRef pooledImage = NULL;
+    CGDataProviderRef provider = CGDataProviderCreateWithData(NULL, data, bytesPerRow * height, BMImageReleasePooledData);
+    if (provider) {
+        pooledImage = CGImageCreate(width,
+                                    height,
+                                    bitsPerComponent,
+                                    bitsPerPixel,
+                                    bytesPerRow,
+                                    colorSpace,
+                                    bitmapInfo,
+                                    provider,
+                                    decode,
+                                    shouldInterpolate,
+                                    renderingIntent);
+        CGDataProviderRelease(provider);
+    }
+    else {
+        BMBufferPoolFree(BMBufferPoolGetDefault(), data, bytesPerRow * height);
+    }
+    return pooledImage;
+}
+
+
+// Creates an image from the pixels of a bitmap allocated with BMImageAllocateBitmap,
+// which have the pixel format of the image; the image takes over the pixels
+static CGImageRef BMImageCreateWithBitmap(CGImageRef image, const BMBitmap *bitmap)
+{
+    return BMImageCreateWithPooledData(bitmap->data,
+                                       bitmap->width,
+                                       bitmap->height,
+                                       CGImageGetBitsPerComponent(image),
+                                       CGImageGetBitsPerPixel(image),
+                                       bitmap->bytesPerRow,
+                                       CGImageGetColorSpace(image),
+                                       CGImageGetBitmapInfo(image),
+                                       CGImageGetDecode(image),
+                                       CGImageGetShouldInterpolate(image),
+                                       CGImageGetRenderingIntent(image));
+}
+
+
+// Creates a bitmap context with the pixel format of the image, which draws into
+// cleared pixels from the default buffer pool
+static CGContextRef BMImageCreateBitmapContext(CGImageRef image, size_t width, size_t height)
+{
+    CGContextRef context = NULL;
+    size_t bytesPerRow = ((width * CGImageGetBitsPerPixel(image) + 7) / 8 + 15) & ~(size_t)15;
+    void *data = BMBufferPoolAllocate(BMBufferPoolGetDefault(), bytesPerRow * height);
+    if (data) {
+        memset(data, 0, bytesPerRow * height);
+        context = CGBitmapContextCreate(data,
+                                        width,
+                                        height,
+                                        CGImageGetBitsPerComponent(image),
+                                        bytesPerRow,
+                                        CGImageGetColorSpace(image),
+                                        CGImageGetBitmapInfo(image));
+        if (!context) {
+            BMBufferPoolFree(BMBufferPoolGetDefault(), data, bytesPerRow * height);
+        }
+    }
+    return context;
+}
+
+
+// Releases a bitmap context created with BMImageCreateBitmapContext, and creates
+// an image that takes over its pixels, instead of copying them
+static CGImageRef BMImageCreateWithBitmapContext(CGContextRef context)
+{
+    void *data = CGBitmapContextGetData(context);
+    size_t width = CGBitmapContextGetWidth(context);
+    size_t height = CGBitmapContextGetHeight(context);
+    size_t bitsPerComponent = CGBitmapContextGetBitsPerComponent(context);
+    size_t bitsPerPixel = CGBitmapContextGetBitsPerPixel(context);
+    size_t bytesPerRow = CGBitmapContextGetBytesPerRow(context);
+    CGColorSpaceRef colorSpace = CGColorSpaceRetain(CGBitmapContextGetColorSpace(context));
+    CGBitmapInfo bitmapInfo = CGBitmapContextGetBitmapInfo(context);
+    CFRelease(context);
+    CGImageRef contextImage = BMImageCreateWithPooledData(data,
+                                                          width,
+                                                          height,
+                                                          bitsPerComponent,
+                                                          bitsPerPixel,
+                                                          bytesPerRow,
+                                                          colorSpace,
+                                                          bitmapInfo,
+                                                          NULL,
+                                                          true,
+                                                          kCGRenderingIntentDefault);
+    CGColorSpaceRelease(colorSpace);
+    return contextImage;
+}
+
+
+// Rotates the image by permuting its pixels, which is exact and much cheaper
+// than redrawing, but only works for pixel sizes supported by BMBitmapOrient
+static CGImageRef BMImageCreateWithImageInOrientationUsingBitmap(CGImageRef         image,
+                                                                 BMImageOrientation imageOrientation)
+{
+    CGImageRef transformedImage = NULL;
+    BMBitmap source;
+    CFDataRef sourceData = BMImageCopyBitmap(image, &source);
+    if (sourceData) {
+        BMBitmap destination = source;
+        BMBitmapGetOrientedSize(source.width, source.height, imageOrientation, &destination.width, &destination.height);
+        if (BMImageAllocateBitmap(&destination)) {
+            if (BMBitmapOrient(&source, &destination, imageOrientation)) {
+                transformedImage = BMImageCreateWithBitmap(image, &destination);
+            }
+            else {
+                BMImageFreeBitmap(&destination);
+            }
+        }
+        CFRelease(sourceData);
+    }
+    return transformedImage;
+}
+
+
+// BMBitmapScale filters every byte on its own, so only 8 bit integer components
+// with premultiplied or no alpha will do; interpolating palette indices or mask
+// samples would produce garbage
+static bool BMImageCanScaleBitmap(CGImageRef image)
+{
+    CGImageAlphaInfo alphaInfo = CGImageGetAlphaInfo(image);
+    return (CGImageGetBitsPerComponent(image) == 8
+            && !(CGImageGetBitmapInfo(image) & kCGBitmapFloatComponents)
+            && alphaInfo != kCGImageAlphaFirst
+            && alphaInfo != kCGImageAlphaLast
+            && !CGImageIsMask(image)
+            && CGColorSpaceGetModel(CGImageGetColorSpace(image)) != kCGColorSpaceModelIndexed);
+}
+
+
+// Scales the pixel aligned source rect of the image with BMBitmapScale, the rect
+// is cut out of the copied bitmap without copying again
+static CGImageRef BMImageCreateWithImageRectScaledUsingBitmap(CGImageRef             image,
+                                                              CGRect                 sourceRect,
+                                                              size_t                 width,
+                                                              size_t                 height,
+                                                              CGInterpolationQuality interpolationQuality)
+{
+    CGImageRef scaledImage = NULL;
+    if (BMImageCanScaleBitmap(image)) {
+        BMBitmap source;
+        CFDataRef sourceData = BMImageCopyBitmap(image, &source);
+        if (sourceData) {
+            source.data = (uint8_t *)source.data + (size_t)CGRectGetMinY(sourceRect) * source.bytesPerRow + (size_t)CGRectGetMinX(sourceRect) * source.bytesPerPixel;
+            source.width = (size_t)CGRectGetWidth(sourceRect);
+            source.height = (size_t)CGRectGetHeight(sourceRect);
+            BMBitmap destination = source;
+            destination.width = width;
+            destination.height = height;
+            if (BMImageAllocateBitmap(&destination)) {
+                if (BMBitmapScale(&source, &destination, BMImageGetBitmapScaleQuality(interpolationQuality))) {
+                    scaledImage = BMImageCreateWithBitmap(image, &destination);
+                }
+                else {
+                    BMImageFreeBitmap(&destination);
+                }
+            }
+            CFRelease(sourceData);
+        }
+    }
+    return scaledImage;
+}
+
+
+// Scales the pixel aligned source rect of the image to the given size, only the
+// pixels within the source rect are resampled
+static CGImageRef BMImageCreateWithImageRectScaled(CGImageRef             image,
+                                                   CGRect                 sourceRect,
+                                                   size_t                 width,
+                                                   size_t                 height,
+                                                   CGInterpolationQuality interpolationQuality)
+{
+    // Resample the pixels directly if the pixel format allows
+    CGImageRef scaledImage = BMImageCreateWithImageRectScaledUsingBitmap(image, sourceRect, width, height, interpolationQuality);
+    if (!scaledImage) {
+        CGContextRef context = BMImageCreateBitmapContext(image, width, height);
+        if (context) {
+            // Draw the image so that the source rect (with the origin at the top left)
+            // covers the context (with the origin at the bottom left), the context
+            // clips away the rest
+            CGFloat scaleWidth = (CGFloat)width / CGRectGetWidth(sourceRect);
+            CGFloat scaleHeight = (CGFloat)height / CGRectGetHeight(sourceRect);
+            CGRect imageRect = CGRectMake(-CGRectGetMinX(sourceRect) * scaleWidth,
+                                          (CGRectGetMaxY(sourceRect) - CGImageGetHeight(image)) * scaleHeight,
+                                          CGImageGetWidth(image) * scaleWidth,
+                                          CGImageGetHeight(image) * scaleHeight);
+            CGContextSetInterpolationQuality(context, interpolationQuality);
+            CGContextDrawImage(context, imageRect, image);
+            scaledImage = BMImageCreateWithBitmapContext(context);
+        }
+    }
+    return scaledImage;
 }
 
 
@@ -91,12 +458,12 @@ CGImageRef BMImageCreateWithImageInOrientation(CGImageRef         image,
                 transform = CGAffineTransformMake(-1.0f, 0.0f, 0.0f, -1.0f, imageRect.size.width, imageRect.size.height);
                 break;
                 
-            case BMImageOrientationLeft: // 0th row is on the left, and 0th column is the bottom - Rotate -90 degrees
-                transform = CGAffineTransformMake(0.0f, 1.0f, -1.0f, 0.0f, imageRect.size.height, 0.0f);
+            case BMImageOrientationLeft: // 0th row is on the right, and 0th column is the top - Rotate 90 degrees
+                transform = CGAffineTransformMake(0.0f, -1.0f, 1.0f, 0.0f, 0.0f, imageRect.size.width);
                 break;
                 
-            case BMImageOrientationRight: // 0th row is on the right, and 0th column is the top - Rotate 90 degrees
-                transform = CGAffineTransformMake(0.0f, -1.0f, 1.0f, 0.0f, 0.0f, imageRect.size.width);
+            case BMImageOrientationRight: // 0th row is on the left, and 0th column is the bottom - Rotate -90 degrees
+                transform = CGAffineTransformMake(0.0f, 1.0f, -1.0f, 0.0f, imageRect.size.height, 0.0f);
                 break;
                 
             case BMImageOrientationUpMirrored: // 0th row is at the top, and 0th column is on the right - Flip Horizontal
@@ -120,35 +487,34 @@ CGImageRef BMImageCreateWithImageInOrientation(CGImageRef         image,
         }
         
         if (!CGAffineTransformIsIdentity(transform)) {
-            // Figure out the transformed image size
-            CGSize transformedSize = imageRect.size;
-            switch (imageOrientation) {
-                case BMImageOrientationLeft:
-                case BMImageOrientationLeftMirrored:
-                case BMImageOrientationRight:
-                case BMImageOrientationRightMirrored:
-                    // Image will be transposed, swap width and height
-                    transformedSize = CGSizeMake(transformedSize.height,
-                                                 transformedSize.width);
-                    break;
-                    
-                default:
-                    break;
-            }
-            
-            // Render the transformed image
-            CGContextRef context = CGBitmapContextCreate(NULL,
-                                                         transformedSize.width,
-                                                         transformedSize.height,
-                                                         CGImageGetBitsPerComponent(image),
-                                                         0,
-                                                         CGImageGetColorSpace(image),
-                                                         CGImageGetBitmapInfo(image));
-            if (context) {
-                CGContextConcatCTM(context, transform);
-                CGContextDrawImage(context, imageRect, image);
-                transformedImage = CGBitmapContextCreateImage(context);
-                CFRelease(context);
+            // Permute the pixels directly if the pixel format allows
+            transformedImage = BMImageCreateWithImageInOrientationUsingBitmap(image, imageOrientation);
+            if (!transformedImage) {
+                // Figure out the transformed image size
+                CGSize transformedSize = imageRect.size;
+                switch (imageOrientation) {
+                    case BMImageOrientationLeft:
+                    case BMImageOrientationLeftMirrored:
+                    case BMImageOrientationRight:
+                    case BMImageOrientationRightMirrored:
+                        // Image will be transposed, swap width and height
+                        transformedSize = CGSizeMake(transformedSize.height,
+                                                     transformedSize.width);
+                        break;
+                        
+                    default:
+                        break;
+                }
+                
+                // Render the transformed image
+                CGContextRef context = BMImageCreateBitmapContext(image,
+                                                                  transformedSize.width,
+                                                                  transformedSize.height);
+                if (context) {
+                    CGContextConcatCTM(context, transform);
+                    CGContextDrawImage(context, imageRect, image);
+                    transformedImage = BMImageCreateWithBitmapContext(context);
+                }
             }
         }
         else {
@@ -167,85 +533,554 @@ CGImageRef BMImageCreateWithImageScaled(CGImageRef             image,
 {
     CGImageRef scaledImage = NULL;
     if (image) {
-        CGSize imageSize = CGSizeMake(CGImageGetWidth(image),
+        CGRect imageRect = CGRectMake((CGFloat)0.0f,
+                                      (CGFloat)0.0f,
+                                      CGImageGetWidth(image),
                                       CGImageGetHeight(image));
         CGRect scaledRect = CGRectIntegral(CGRectMake((CGFloat)0.0f,
                                                       (CGFloat)0.0f,
-                                                      imageSize.width * scaleWidth,
-                                                      imageSize.height * scaleHeight));
-        if (CGSizeEqualToSize(scaledRect.size, imageSize)) {
+                                                      imageRect.size.width * scaleWidth,
+                                                      imageRect.size.height * scaleHeight));
+        if (CGSizeEqualToSize(scaledRect.size, imageRect.size)) {
             // No need to actually scale the image
             scaledImage = CGImageRetain(image);
         }
         else if (!CGRectIsEmpty(scaledRect) && !CGRectIsInfinite(scaledRect)) {
-            CGContextRef context = CGBitmapContextCreate(NULL,
-                                                         scaledRect.size.width,
-                                                         scaledRect.size.height,
-                                                         CGImageGetBitsPerComponent(image),
-                                                         0,
-                                                         CGImageGetColorSpace(image),
-                                                         CGImageGetBitmapInfo(image));
-            if (context) {
-                CGContextSetInterpolationQuality(context, interpolationQuality);
-                CGContextDrawImage(context, scaledRect, image);
-                scaledImage = CGBitmapContextCreateImage(context);
-                CFRelease(context);
-            }
+            scaledImage = BMImageCreateWithImageRectScaled(image,
+                                                           imageRect,
+                                                           scaledRect.size.width,
+                                                           scaledRect.size.height,
+                                                           interpolationQuality);
         }
     }
     return scaledImage;
 }
 
 
+// Figures out the pixel aligned part of an image of the given size that ends up in
+// the result, and the size of the result, for the scale mode; returns false if the
+// result is empty
+static bool BMImageGetScaledRect(CGSize           imageSize,
+                                 BMImageScaleMode scaleMode,
+                                 CGSize           size,
+                                 CGPoint          focalPoint,
+                                 CGRect          *sourceRect,
+                                 CGSize          *scaledSize)
+{
+    CGRect imageRect = CGRectMake((CGFloat)0.0f, (CGFloat)0.0f, imageSize.width, imageSize.height);
+    CGRect scaledRect = imageRect;
+    *sourceRect = imageRect;
+    switch (scaleMode) {
+        case BMImageScaleModeFill:
+            scaledRect = CGRectIntegral(CGRectMake((CGFloat)0.0f, (CGFloat)0.0f, size.width, size.height));
+            break;
+            
+        case BMImageScaleModeAspectFit:
+        case BMImageScaleModeAspectFill:
+            if (size.width > (CGFloat)0.0f && size.height > (CGFloat)0.0f && !CGRectIsEmpty(imageRect)) {
+                // Scale down the image to "aspect fit" or "aspect fill" the requested size
+                CGFloat scaleWidth = size.width / imageRect.size.width;
+                CGFloat scaleHeight = size.height / imageRect.size.height;
+                CGFloat scale = ((scaleWidth > scaleHeight) == (scaleMode == BMImageScaleModeAspectFill)) ? scaleWidth : scaleHeight;
+                if (scale > (CGFloat)1.0f) {
+                    scale = (CGFloat)1.0f;
+                }
+                scaledRect = CGRectIntegral(CGRectMake((CGFloat)0.0f,
+                                                       (CGFloat)0.0f,
+                                                       imageRect.size.width * scale,
+                                                       imageRect.size.height * scale));
+                if (scaleMode == BMImageScaleModeAspectFill) {
+                    // The size of the result is the requested size, unless the
+                    // scaled image is smaller in one dimension
+                    CGRect croppedRect = CGRectIntegral(CGRectMake((CGFloat)0.0f,
+                                                                   (CGFloat)0.0f,
+                                                                   size.width,
+                                                                   size.height));
+                    scaledRect = CGRectIntersection(croppedRect, scaledRect);
+                    
+                    // Figure out the part of the image that ends up in the result, and
+                    // center it on the focal point as far as the image edges allow,
+                    // so that no pixel is resampled only to be cropped afterwards
+                    *sourceRect = CGRectIntegral(CGRectMake((CGFloat)0.0f,
+                                                            (CGFloat)0.0f,
+                                                            scaledRect.size.width / scale,
+                                                            scaledRect.size.height / scale));
+                    *sourceRect = CGRectIntersection(*sourceRect, imageRect);
+                    CGFloat originX = focalPoint.x * imageRect.size.width - sourceRect->size.width / (CGFloat)2.0f;
+                    CGFloat originY = focalPoint.y * imageRect.size.height - sourceRect->size.height / (CGFloat)2.0f;
+                    originX = (originX < (CGFloat)0.0f) ? (CGFloat)0.0f : (originX > imageRect.size.width - sourceRect->size.width) ? imageRect.size.width - sourceRect->size.width : originX;
+                    originY = (originY < (CGFloat)0.0f) ? (CGFloat)0.0f : (originY > imageRect.size.height - sourceRect->size.height) ? imageRect.size.height - sourceRect->size.height : originY;
+                    sourceRect->origin = CGPointMake((CGFloat)(size_t)(originX + (CGFloat)0.5f),
+                                                     (CGFloat)(size_t)(originY + (CGFloat)0.5f));
+                }
+            }
+            else {
+                scaledRect = CGRectZero;
+            }
+            break;
+            
+        default:
+            break;
+    }
+    *scaledSize = scaledRect.size;
+    return !CGRectIsEmpty(scaledRect) && !CGRectIsInfinite(scaledRect) && !CGRectIsEmpty(*sourceRect);
+}
+
+
 CGImageRef BMImageCreateWithImageScaledDownToAspectFill(CGImageRef             image,
                                                         CGSize                 size,
                                                         CGInterpolationQuality interpolationQuality)
+{
+    return BMImageCreateWithImageScaledDownToAspectFillAroundPoint(image,
+                                                                   size,
+                                                                   CGPointMake((CGFloat)0.5f, (CGFloat)0.5f),
+                                                                   interpolationQuality);
+}
+
+
+CGImageRef BMImageCreateWithImageScaledDownToAspectFillAroundPoint(CGImageRef             image,
+                                                                   CGSize                 size,
+                                                                   CGPoint                focalPoint,
+                                                                   CGInterpolationQuality interpolationQuality)
 {
     CGImageRef scaledImage = NULL;
-    if (image && size.width > (CGFloat)0.0f && size.height > (CGFloat)0.0f) {
-        CGRect imageRect = CGRectMake((CGFloat)0.0f,
-                                      (CGFloat)0.0f,
-                                      CGImageGetWidth(image),
+    if (image) {
+        CGSize imageSize = CGSizeMake(CGImageGetWidth(image),
                                       CGImageGetHeight(image));
-        if (!CGRectIsEmpty(imageRect)) {
-            // Scale down the image to "aspect fill" the requested size
-            CGFloat scaleWidth = size.width / imageRect.size.width;
-            CGFloat scaleHeight = size.height / imageRect.size.height;
+        CGRect sourceRect;
+        CGSize scaledSize;
+        if (BMImageGetScaledRect(imageSize, BMImageScaleModeAspectFill, size, focalPoint, &sourceRect, &scaledSize)) {
+            if (CGSizeEqualToSize(sourceRect.size, imageSize) && CGSizeEqualToSize(scaledSize, imageSize)) {
+                // No need to actually scale or crop the image
+                scaledImage = CGImageRetain(image);
+            }
+            else {
+                scaledImage = BMImageCreateWithImageRectScaled(image,
+                                                               sourceRect,
+                                                               scaledSize.width,
+                                                               scaledSize.height,
+                                                               interpolationQuality);
+            }
+        }
+    }
+    return scaledImage;
+}
+
+
+// Returns the integer value of a numeric image property, or 0 if it is missing
+static int BMImageGetIntegerProperty(CFDictionaryRef properties, CFStringRef key)
+{
+    int value = 0;
+    CFNumberRef number = (CFNumberRef)CFDictionaryGetValue(properties, key);
+    if (number && CFGetTypeID(number) == CFNumberGetTypeID()) {
+        CFNumberGetValue(number, kCFNumberIntType, &value);
+    }
+    return value;
+}
+
+
+bool BMImageSourceGetSize(CGImageSourceRef    imageSource,
+                          size_t              index,
+                          size_t             *width,
+                          size_t             *height,
+                          BMImageOrientation *imageOrientation)
+{
+    int pixelWidth = 0, pixelHeight = 0, orientation = 0;
+    if (imageSource) {
+        CFDictionaryRef properties = CGImageSourceCopyPropertiesAtIndex(imageSource, index, NULL);
+        if (properties) {
+            pixelWidth = BMImageGetIntegerProperty(properties, kCGImagePropertyPixelWidth);
+            pixelHeight = BMImageGetIntegerProperty(properties, kCGImagePropertyPixelHeight);
+            orientation = BMImageGetIntegerProperty(properties, kCGImagePropertyOrientation);
+            CFRelease(properties);
+        }
+    }
+    *width = (pixelWidth > 0) ? (size_t)pixelWidth : 0;
+    *height = (pixelHeight > 0) ? (size_t)pixelHeight : 0;
+    *imageOrientation = (orientation >= BMImageOrientationUp && orientation <= BMImageOrientationRight) ? (BMImageOrientation)orientation : BMImageOrientationUp;
+    return (*width && *height);
+}
+
+
+CGImageRef BMImageCreateThumbnailWithImageSource(CGImageSourceRef       imageSource,
+                                                 size_t                 index,
+                                                 CGSize                 size,
+                                                 CGPoint                focalPoint,
+                                                 CGInterpolationQuality interpolationQuality)
+{
+    CGImageRef thumbnailImage = NULL;
+    if (imageSource && size.width > (CGFloat)0.0f && size.height > (CGFloat)0.0f) {
+        // Read the image size and orientation from the header, without decoding the image
+        size_t width, height;
+        BMImageOrientation imageOrientation;
+        if (BMImageSourceGetSize(imageSource, index, &width, &height, &imageOrientation)) {
+            // Figure out the "aspect fill" scale in "Up" orientation, and let ImageIO
+            // decode the image with its longer side just large enough for that scale
+            size_t orientedWidth, orientedHeight;
+            BMBitmapGetOrientedSize(width, height, imageOrientation, &orientedWidth, &orientedHeight);
+            CGFloat scaleWidth = size.width / orientedWidth;
+            CGFloat scaleHeight = size.height / orientedHeight;
             CGFloat scale = (scaleWidth > scaleHeight) ? scaleWidth : scaleHeight;
             if (scale > (CGFloat)1.0f) {
                 scale = (CGFloat)1.0f;
             }
-            scaledImage = BMImageCreateWithImageScaled(image, scale, scale, interpolationQuality);
-            if (scaledImage) {
-                CGSize scaledSize = CGSizeMake(CGImageGetWidth(scaledImage),
-                                               CGImageGetHeight(scaledImage));
-                if (scaledSize.width > size.width || scaledSize.height > size.height) {
-                    // Crop the requested part of the scaled image
-                    CGRect croppedRect = CGRectIntegral(CGRectMake((CGFloat)0.0f,
-                                                                   (CGFloat)0.0f,
-                                                                   size.width,
-                                                                   size.height));
-                    if (croppedRect.size.width < scaledSize.width) {
-                        croppedRect.origin.x += (scaledSize.width - croppedRect.size.width) / (CGFloat)2.0f;
-                    }
-                    else {
-                        croppedRect.size.width = scaledSize.width;
-                    }
-                    if (croppedRect.size.height < scaledSize.height) {
-                        croppedRect.origin.y += (scaledSize.height - croppedRect.size.height) / (CGFloat)2.0f;
+            CGFloat longerSide = ((orientedWidth > orientedHeight) ? orientedWidth : orientedHeight) * scale;
+            int maxPixelSize = (int)longerSide;
+            if ((CGFloat)maxPixelSize < longerSide) {
+                maxPixelSize++;
+            }
+            
+            CFAllocatorRef allocator = CFGetAllocator(imageSource);
+            CFStringRef keys[4];
+            CFTypeRef values[4];
+            keys[0] = kCGImageSourceCreateThumbnailFromImageAlways;
+            values[0] = kCFBooleanTrue;
+            keys[1] = kCGImageSourceCreateThumbnailWithTransform;
+            values[1] = kCFBooleanTrue;
+            keys[2] = kCGImageSourceShouldCache;
+            values[2] = kCFBooleanFalse;
+            keys[3] = kCGImageSourceThumbnailMaxPixelSize;
+            values[3] = CFNumberCreate(allocator, kCFNumberIntType, &maxPixelSize);
+            if (values[3]) {
+                CFDictionaryRef options = CFDictionaryCreate(allocator,
+                                                             (const void **)keys,
+                                                             (const void **)values,
+                                                             4,
+                                                             &kCFTypeDictionaryKeyCallBacks,
+                                                             &kCFTypeDictionaryValueCallBacks);
+                if (options) {
+                    CGImageRef decodedImage = CGImageSourceCreateThumbnailAtIndex(imageSource, index, options);
+                    if (decodedImage) {
+                        // Crop and scale the reduced image to the exact size
+                        thumbnailImage = BMImageCreateWithImageScaledDownToAspectFillAroundPoint(decodedImage,
+                                                                                                 size,
+                                                                                                 focalPoint,
+                                                                                                 interpolationQuality);
+                        CGImageRelease(decodedImage);
                     }
-                    else {
-                        croppedRect.size.height = scaledSize.height;
+                    CFRelease(options);
+                }
+                CFRelease(values[3]);
+            }
+        }
+    }
+    return thumbnailImage;
+}
+
+
+CGImageRef BMImageCreateThumbnailWithData(CFDataRef              data,
+                                          CGSize                 size,
+                                          CGPoint                focalPoint,
+                                          CGInterpolationQuality interpolationQuality)
+{
+    CGImageRef thumbnailImage = NULL;
+    if (data) {
+        CGImageSourceRef imageSource = CGImageSourceCreateWithData(data, NULL);
+        if (imageSource) {
+            thumbnailImage = BMImageCreateThumbnailWithImageSource(imageSource, 0, size, focalPoint, interpolationQuality);
+            CFRelease(imageSource);
+        }
+    }
+    return thumbnailImage;
+}
+
+
+#pragma mark -
+#pragma mark Image Pipeline
+
+
+void BMImagePipelineOptionsInit(BMImagePipelineOptions *options)
+{
+    memset(options, 0, sizeof(*options));
+    options->orientation = BMImageOrientationUp;
+    options->scaleMode = BMImageScaleModeNone;
+    options->focalPoint = CGPointMake((CGFloat)0.5f, (CGFloat)0.5f);
+    options->interpolationQuality = kCGInterpolationDefault;
+    BMImageEncoderOptionsInit(&options->encoderOptions);
+}
+
+
+// Returns the time elapsed since the last lap, and starts a new lap
+static double BMImagePipelineLap(CFAbsoluteTime *lapTime)
+{
+    CFAbsoluteTime time = CFAbsoluteTimeGetCurrent();
+    double elapsedTime = time - *lapTime;
+    *lapTime = time;
+    return elapsedTime;
+}
+
+
+// Maps a rect in "Up" orientation back to the image in the given orientation,
+// which is width x height pixels in its own orientation
+static CGRect BMImageRectInOrientation(CGRect rect, size_t width, size_t height, BMImageOrientation imageOrientation)
+{
+    CGFloat w = width, h = height;
+    switch (imageOrientation) {
+        case BMImageOrientationUpMirrored:
+            return CGRectMake(w - CGRectGetMaxX(rect), CGRectGetMinY(rect), rect.size.width, rect.size.height);
+        case BMImageOrientationDown:
+            return CGRectMake(w - CGRectGetMaxX(rect), h - CGRectGetMaxY(rect), rect.size.width, rect.size.height);
+        case BMImageOrientationDownMirrored:
+            return CGRectMake(CGRectGetMinX(rect), h - CGRectGetMaxY(rect), rect.size.width, rect.size.height);
+        case BMImageOrientationLeftMirrored:
+            return CGRectMake(CGRectGetMinY(rect), CGRectGetMinX(rect), rect.size.height, rect.size.width);
+        case BMImageOrientationLeft:
+            return CGRectMake(CGRectGetMinY(rect), h - CGRectGetMaxX(rect), rect.size.height, rect.size.width);
+        case BMImageOrientationRightMirrored:
+            return CGRectMake(w - CGRectGetMaxY(rect), h - CGRectGetMaxX(rect), rect.size.height, rect.size.width);
+        case BMImageOrientationRight:
+            return CGRectMake(w - CGRectGetMaxY(rect), CGRectGetMinX(rect), rect.size.height, rect.size.width);
+        default:
+            return rect;
+    }
+}
+
+
+// A bitmap in "Up" orientation, written through a tiled bitmap of the size
+// before the rotation, see BMImageInitTiledBitmapInOrientation
+typedef struct _BMImageOrientedBitmap {
+    BMBitmap           bitmap;
+    size_t             width;
+    size_t             height;
+    BMImageOrientation orientation;
+} BMImageOrientedBitmap;
+
+
+static bool BMImageWriteOrientedBitmap(void *context, size_t x, size_t y, const BMBitmap *tile)
+{
+    const BMImageOrientedBitmap *oriented = (const BMImageOrientedBitmap *)context;
+    
+    // Each orientation is its own inverse, except for the quarter turns, so mapping
+    // the tile back "from Up" with the inverse orientation yields its rect in the result
+    BMImageOrientation inverseOrientation = oriented->orientation;
+    if (inverseOrientation == BMImageOrientationLeft) {
+        inverseOrientation = BMImageOrientationRight;
+    }
+    else if (inverseOrientation == BMImageOrientationRight) {
+        inverseOrientation = BMImageOrientationLeft;
+    }
+    CGRect rect = BMImageRectInOrientation(CGRectMake(x, y, tile->width, tile->height), oriented->bitmap.width, oriented->bitmap.height, inverseOrientation);
+    BMBitmap destination = oriented->bitmap;
+    destination.data = (uint8_t *)destination.data + (size_t)CGRectGetMinY(rect) * destination.bytesPerRow + (size_t)CGRectGetMinX(rect) * destination.bytesPerPixel;
+    destination.width = (size_t)CGRectGetWidth(rect);
+    destination.height = (size_t)CGRectGetHeight(rect);
+    return BMBitmapOrient(tile, &destination, oriented->orientation);
+}
+
+
+// Initializes tiledBitmap to write into the bitmap of oriented, as if it was still
+// in the given orientation: every tile is rotated straight into place, so scaling
+// into tiledBitmap needs no intermediate bitmap in the original orientation
+static void BMImageInitTiledBitmapInOrientation(BMTiledBitmap *tiledBitmap, BMImageOrientedBitmap *oriented, const BMBitmap *bitmap, BMImageOrientation orientation)
+{
+    oriented->bitmap = *bitmap;
+    oriented->orientation = orientation;
+    BMBitmapGetOrientedSize(bitmap->width, bitmap->height, orientation, &oriented->width, &oriented->height);
+    memset(tiledBitmap, 0, sizeof(*tiledBitmap));
+    tiledBitmap->width = oriented->width;
+    tiledBitmap->height = oriented->height;
+    tiledBitmap->bytesPerPixel = bitmap->bytesPerPixel;
+    tiledBitmap->tileWidth = BMImageTileLength;
+    tiledBitmap->tileHeight = BMImageTileLength;
+    tiledBitmap->write = BMImageWriteOrientedBitmap;
+    tiledBitmap->context = oriented;
+}
+
+
+// Runs the pipeline on the pixels of the image: the source rect is cut out of a
+// copy of the pixels and scaled, rotated, or scaled tile by tile with each tile
+// rotated straight into the result
+static CGImageRef BMImageCreateWithImageAndOptionsUsingBitmap(CGImageRef                    image,
+                                                              CGRect                        sourceRect,
+                                                              CGSize                        scaledSize,
+                                                              const BMImagePipelineOptions *options,
+                                                              BMImagePipelineStats         *stats,
+                                                              CFAbsoluteTime               *lapTime)
+{
+    CGImageRef processedImage = NULL;
+    BMImageOrientation imageOrientation = options->orientation;
+    bool rotates = (imageOrientation >= BMImageOrientationUpMirrored && imageOrientation <= BMImageOrientationRight);
+    bool scales = !CGSizeEqualToSize(sourceRect.size, scaledSize);
+    if (!scales || BMImageCanScaleBitmap(image)) {
+        BMBitmap source;
+        CFDataRef sourceData = BMImageCopyBitmap(image, &source);
+        stats->decodeTime += BMImagePipelineLap(lapTime);
+        if (sourceData) {
+            // Cut the source rect, given in "Up" orientation, out of the bitmap
+            CGRect rect = BMImageRectInOrientation(sourceRect, source.width, source.height, imageOrientation);
+            source.data = (uint8_t *)source.data + (size_t)CGRectGetMinY(rect) * source.bytesPerRow + (size_t)CGRectGetMinX(rect) * source.bytesPerPixel;
+            source.width = (size_t)CGRectGetWidth(rect);
+            source.height = (size_t)CGRectGetHeight(rect);
+            
+            BMBitmap destination = source;
+            destination.width = (size_t)scaledSize.width;
+            destination.height = (size_t)scaledSize.height;
+            if (BMImageAllocateBitmap(&destination)) {
+                bool succeeded = true;
+                if (!rotates) {
+                    succeeded = BMBitmapScale(&source, &destination, BMImageGetBitmapScaleQuality(options->interpolationQuality));
+                    stats->scaleTime += BMImagePipelineLap(lapTime);
+                }
+                else if (scales) {
+                    // Scale in the original orientation, so that only the scaled
+                    // pixels are rotated, tile by tile, straight into the result
+                    BMTiledBitmap tiledSource, tiledDestination;
+                    BMImageOrientedBitmap oriented;
+                    BMTiledBitmapInitWithBitmap(&tiledSource, &source, BMImageTileLength, BMImageTileLength);
+                    BMImageInitTiledBitmapInOrientation(&tiledDestination, &oriented, &destination, imageOrientation);
+                    succeeded = BMTiledBitmapScale(&tiledSource, &tiledDestination, BMImageGetBitmapScaleQuality(options->interpolationQuality));
+                    stats->scaleTime += BMImagePipelineLap(lapTime);
+                }
+                else {
+                    succeeded = BMBitmapOrient(&source, &destination, imageOrientation);
+                    stats->orientTime += BMImagePipelineLap(lapTime);
+                }
+                if (succeeded) {
+                    processedImage = BMImageCreateWithBitmap(image, &destination);
+                }
+                else {
+                    BMImageFreeBitmap(&destination);
+                }
+            }
+            CFRelease(sourceData);
+        }
+    }
+    return processedImage;
+}
+
+
+CGImageRef BMImageCreateWithImageAndOptions(CGImageRef                    image,
+                                            const BMImagePipelineOptions *options,
+                                            BMImagePipelineStats         *stats)
+{
+    CGImageRef processedImage = NULL;
+    BMImagePipelineStats ignoredStats;
+    if (!stats) {
+        stats = &ignoredStats;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (image && options) {
+        // Figure out the geometry in "Up" orientation
+        size_t orientedWidth, orientedHeight;
+        BMBitmapGetOrientedSize(CGImageGetWidth(image), CGImageGetHeight(image), options->orientation, &orientedWidth, &orientedHeight);
+        CGSize orientedSize = CGSizeMake(orientedWidth, orientedHeight);
+        CGRect sourceRect;
+        CGSize scaledSize;
+        if (BMImageGetScaledRect(orientedSize, options->scaleMode, options->size, options->focalPoint, &sourceRect, &scaledSize)) {
+            bool rotates = (options->orientation >= BMImageOrientationUpMirrored && options->orientation <= BMImageOrientationRight);
+            if (!rotates && CGSizeEqualToSize(sourceRect.size, orientedSize) && CGSizeEqualToSize(scaledSize, orientedSize)) {
+                // Nothing to do, already in "Up" orientation and the requested size
+                processedImage = CGImageRetain(image);
+            }
+            else {
+                CFAbsoluteTime lapTime = CFAbsoluteTimeGetCurrent();
+                processedImage = BMImageCreateWithImageAndOptionsUsingBitmap(image, sourceRect, scaledSize, options, stats, &lapTime);
+                if (!processedImage) {
+                    // Fall back to rotating the whole image and scaling it afterwards;
+                    // the rotated image is in "Up" orientation like the result of the
+                    // bitmap path, so the source rect applies to it unchanged
+                    CGImageRef orientedImage = BMImageCreateWithImageInOrientation(image, options->orientation);
+                    stats->orientTime += BMImagePipelineLap(&lapTime);
+                    if (orientedImage) {
+                        processedImage = BMImageCreateWithImageRectScaled(orientedImage,
+                                                                          sourceRect,
+                                                                          scaledSize.width,
+                                                                          scaledSize.height,
+                                                                          options->interpolationQuality);
+                        stats->scaleTime += BMImagePipelineLap(&lapTime);
+                        CGImageRelease(orientedImage);
                     }
-                    
-                    CGImageRef croppedImage = CGImageCreateWithImageInRect(scaledImage, croppedRect);
-                    CGImageRelease(scaledImage);
-                    scaledImage = croppedImage;
                 }
             }
         }
     }
-    return scaledImage;
+    return processedImage;
 }
 
 
+uint64_t BMImagePipelineGetMemoryLength(size_t                        width,
+                                        size_t                        height,
+                                        const BMImagePipelineOptions *options)
+{
+    uint64_t length = 0;
+    if (options) {
+        // The copy of the pixels of the input image, plus the result
+        size_t orientedWidth, orientedHeight;
+        BMBitmapGetOrientedSize(width, height, options->orientation, &orientedWidth, &orientedHeight);
+        CGRect sourceRect;
+        CGSize scaledSize;
+        length = 4ULL * width * height;
+        if (BMImageGetScaledRect(CGSizeMake(orientedWidth, orientedHeight), options->scaleMode, options->size, options->focalPoint, &sourceRect, &scaledSize)) {
+            length += 4ULL * (uint64_t)scaledSize.width * (uint64_t)scaledSize.height;
+        }
+    }
+    return length;
+}
+
+
+CFDataRef BMImageCopyDataWithOptions(CGImageRef                    image,
+                                     const BMImagePipelineOptions *options,
+                                     BMImagePipelineStats         *stats)
+{
+    CFDataRef data = NULL;
+    BMImagePipelineStats ignoredStats;
+    if (!stats) {
+        stats = &ignoredStats;
+    }
+    CGImageRef processedImage = BMImageCreateWithImageAndOptions(image, options, stats);
+    if (processedImage) {
+        // The pixels are in "Up" orientation now
+        CFAbsoluteTime lapTime = CFAbsoluteTimeGetCurrent();
+        data = BMImageCopyDataWithEncoderOptions(processedImage, BMImageOrientationUp, &options->encoderOptions);
+        stats->encodeTime += BMImagePipelineLap(&lapTime);
+        CGImageRelease(processedImage);
+    }
+    return data;
+}
+
+
+#pragma mark -
+#pragma mark Tiled Images
+
+
+CGImageRef BMImageCreateWithTiledBitmap(const BMTiledBitmap     *tiledBitmap,
+                                        BMImageOrientation       imageOrientation,
+                                        size_t                   width,
+                                        size_t                   height,
+                                        CGColorSpaceRef          colorSpace,
+                                        CGBitmapInfo             bitmapInfo,
+                                        CGInterpolationQuality   interpolationQuality)
+{
+    CGImageRef tiledImage = NULL;
+    if (tiledBitmap && width && height) {
+        // Scale in the orientation of the tiled bitmap, rotating each scaled
+        // tile straight into the result
+        BMBitmap result;
+        memset(&result, 0, sizeof(result));
+        result.width = width;
+        result.height = height;
+        result.bytesPerPixel = tiledBitmap->bytesPerPixel;
+        if (BMImageAllocateBitmap(&result)) {
+            BMTiledBitmap tiledResult;
+            BMImageOrientedBitmap oriented;
+            BMImageInitTiledBitmapInOrientation(&tiledResult, &oriented, &result, imageOrientation);
+            if (BMTiledBitmapScale(tiledBitmap, &tiledResult, BMImageGetBitmapScaleQuality(interpolationQuality))) {
+                tiledImage = BMImageCreateWithPooledData(result.data,
+                                                         result.width,
+                                                         result.height,
+                                                         8,
+                                                         8 * result.bytesPerPixel,
+                                                         result.bytesPerRow,
+                                                         colorSpace,
+                                                         bitmapInfo,
+                                                         NULL,
+                                                         true,
+                                                         kCGRenderingIntentDefault);
+            }
+            else {
+                BMImageFreeBitmap(&result);
+            }
+        }
+    }
+    return tiledImage;
+}
@@ -29,41 +29,135 @@
 #define __BMIMAGEUTILITIES__
 
 #include <CoreGraphics/CoreGraphics.h>
+#include <ImageIO/ImageIO.h>
+
+#include "BMBitmapUtilities.h"
 
 __BEGIN_DECLS
-    
-/** EXIF image orientations. */
-typedef enum _BMImageOrientation {
-    BMImageOrientationUp            = 1,
-    BMImageOrientationUpMirrored    = 2,
-    BMImageOrientationDown          = 3,
-    BMImageOrientationDownMirrored  = 4,
-    BMImageOrientationLeftMirrored  = 5,
-    BMImageOrientationLeft          = 6,
-    BMImageOrientationRightMirrored = 7,
-    BMImageOrientationRight         = 8
-} BMImageOrientation;
-    
-/** Returns the JPEG data of the specified image with the given compression quality and EXIF orientation. */
+
+/** The UTI of WebP images, which ImageIO has no constant for. Use `BMImageCanEncodeType` to check whether WebP can be encoded on the running system. */
+#define BMImageTypeWebP CFSTR("org.webmproject.webp")
+
+/** Options of the image encoder, which must be initialized with `BMImageEncoderOptionsInit`. */
+typedef struct _BMImageEncoderOptions {
+    CFStringRef type;        /**< The UTI of the encoded output, e.g. `kUTTypeJPEG`, `kUTTypePNG` or `BMImageTypeWebP`. Defaults to `kUTTypeJPEG`. */
+    float       quality;     /**< The lossy compression quality, from 0.0 to 1.0. Ignored for lossless formats. Defaults to 0.8. */
+    bool        progressive; /**< Whether to write a progressive JPEG or an interlaced PNG. Defaults to `false`. */
+} BMImageEncoderOptions;
+
+/** Scale modes of the image pipeline, see `BMImagePipelineOptions`. */
+typedef enum _BMImageScaleMode {
+    BMImageScaleModeNone       = 0, /**< Keep the size of the image. */
+    BMImageScaleModeFill       = 1, /**< Scale the image to the target size, ignoring its aspect ratio. */
+    BMImageScaleModeAspectFit  = 2, /**< Scale down the image to fit into the target size. */
+    BMImageScaleModeAspectFill = 3  /**< Scale down the image to fill the target size, cropping around the focal point, see `BMImageCreateWithImageScaledDownToAspectFillAroundPoint`. */
+} BMImageScaleMode;
+
+/** Options of the image pipeline, which must be initialized with `BMImagePipelineOptionsInit`. */
+typedef struct _BMImagePipelineOptions {
+    BMImageOrientation     orientation;          /**< The EXIF orientation of the input image, which is rotated to "Up" orientation. Defaults to `BMImageOrientationUp`. */
+    BMImageScaleMode       scaleMode;            /**< How to scale the image to _size_. Defaults to `BMImageScaleModeNone`. */
+    CGSize                 size;                 /**< The target size in "Up" orientation. */
+    CGPoint                focalPoint;           /**< The focal point for `BMImageScaleModeAspectFill` in unit coordinates in "Up" orientation. Defaults to the center. */
+    CGInterpolationQuality interpolationQuality; /**< The interpolation quality for scaling. Defaults to `kCGInterpolationDefault`. */
+    BMImageEncoderOptions  encoderOptions;       /**< How to encode the output, see `BMImageCopyDataWithOptions`. Defaults to the defaults of `BMImageEncoderOptionsInit`. */
+} BMImagePipelineOptions;
+
+/** Time spent in the stages of the image pipeline, in seconds. */
+typedef struct _BMImagePipelineStats {
+    double decodeTime;  /**< Copying the pixels out of the input image, which decodes lazily decoded images. */
+    double scaleTime;   /**< Scaling and cropping the image, including rotating the scaled pixels if the image is rotated as well. */
+    double orientTime;  /**< Rotating the image to "Up" orientation when it is not scaled. */
+    double encodeTime;  /**< Encoding the result, only set by `BMImageCopyDataWithOptions`. */
+} BMImagePipelineStats;
+
+/** Initializes _options_ with the default values. */
+extern void BMImageEncoderOptionsInit(BMImageEncoderOptions *options);
+
+/** Returns whether ImageIO can encode images of the UTI _type_ on the running system. */
+extern bool BMImageCanEncodeType(CFStringRef type);
+
+/** Returns the image encoded as _options_ describe, with the given EXIF orientation, or `NULL` if the image cannot be encoded, e.g. because ImageIO has no encoder for `options->type`. The encoder writes directly into the returned data, which is not copied afterwards. */
+extern CFDataRef BMImageCopyDataWithEncoderOptions(CGImageRef                   image,
+                                                   BMImageOrientation           imageOrientation,
+                                                   const BMImageEncoderOptions *options);
+
+/** Returns the JPEG data of the specified image with the given compression quality and EXIF orientation, see `BMImageCopyDataWithEncoderOptions`. */
 extern CFDataRef BMImageCopyJPEGData(CGImageRef         image,
                                      BMImageOrientation imageOrientation,
                                      float              imageQuality);
     
-/** Creates an image by rotating another image to "Up" orientation. */
+/** Creates an image by rotating another image to "Up" orientation. Images with 8, 16 or 32 bits per pixel are rotated by permuting the pixels of a copy with `BMBitmapOrient`, so the copy and the result are held in memory at the same time, other images are redrawn into the result. The pixels of the result are allocated from `BMBufferPoolGetDefault` and returned to the pool when the image is released. */
 extern CGImageRef BMImageCreateWithImageInOrientation(CGImageRef         image,
                                                       BMImageOrientation imageOrientation);
 
-/** Creates an image by scaling another image. */
+/** Returns the `BMBitmapScale` filter used for _interpolationQuality_: the box filter for `kCGInterpolationNone`, the bilinear filter for `kCGInterpolationLow` and `kCGInterpolationDefault`, and the Lanczos filter for higher qualities. */
+extern BMBitmapScaleQuality BMImageGetBitmapScaleQuality(CGInterpolationQuality interpolationQuality);
+
+/** Creates an image by scaling another image. Images with 8 bit components and premultiplied or no alpha are resampled with `BMBitmapScale` using the filter returned by `BMImageGetBitmapScaleQuality`, other images are redrawn with _interpolationQuality_. The pixels of the result are allocated from `BMBufferPoolGetDefault` and returned to the pool when the image is released. */
 extern CGImageRef BMImageCreateWithImageScaled(CGImageRef             image,
                                                CGFloat                scaleWidth,
                                                CGFloat                scaleHeight,
                                                CGInterpolationQuality interpolationQuality);
 
-/** Creates an image by scaling down another image using "aspect fill" strategy. */
+/** Creates an image by scaling down another image using "aspect fill" strategy, keeping the center of the image. Only the part of the image that ends up in the result is resampled. */
 extern CGImageRef BMImageCreateWithImageScaledDownToAspectFill(CGImageRef             image,
                                                                CGSize                 size,
                                                                CGInterpolationQuality interpolationQuality);
 
+/** Creates an image by scaling down another image using "aspect fill" strategy, keeping the part of the image around _focalPoint_, which is given in unit coordinates with the origin at the top left, i.e. `{0.5, 0.5}` is the center of the image. The cropped part is centered on the focal point as far as the image edges allow, so `{0, 0}` keeps the top left corner and `{0.5, 0}` keeps the top edge. Only the part of the image that ends up in the result is resampled. */
+extern CGImageRef BMImageCreateWithImageScaledDownToAspectFillAroundPoint(CGImageRef             image,
+                                                                          CGSize                 size,
+                                                                          CGPoint                focalPoint,
+                                                                          CGInterpolationQuality interpolationQuality);
+
+/** Reads the pixel size and the EXIF orientation of the image at _index_ in an image source from its properties, without decoding the image. The orientation is `BMImageOrientationUp` if the image has none. Returns `false` if the image has no valid size. */
+extern bool BMImageSourceGetSize(CGImageSourceRef    imageSource,
+                                 size_t              index,
+                                 size_t             *width,
+                                 size_t             *height,
+                                 BMImageOrientation *imageOrientation);
+
+/** Creates a thumbnail of the image at _index_ in an image source, which "aspect fills" _size_ around _focalPoint_ in "Up" orientation, see `BMImageCreateWithImageScaledDownToAspectFillAroundPoint`. The full image is never decoded: the image size and EXIF orientation are read from the image properties, and ImageIO decodes the image at a reduced resolution that is just large enough, which uses DCT domain scaling for JPEG images, and applies the orientation in the same pass. */
+extern CGImageRef BMImageCreateThumbnailWithImageSource(CGImageSourceRef       imageSource,
+                                                        size_t                 index,
+                                                        CGSize                 size,
+                                                        CGPoint                focalPoint,
+                                                        CGInterpolationQuality interpolationQuality);
+
+/** Creates a thumbnail of the first image in the encoded image _data_, see `BMImageCreateThumbnailWithImageSource`. */
+extern CGImageRef BMImageCreateThumbnailWithData(CFDataRef              data,
+                                                 CGSize                 size,
+                                                 CGPoint                focalPoint,
+                                                 CGInterpolationQuality interpolationQuality);
+
+/** Initializes _options_ with the default values. */
+extern void BMImagePipelineOptionsInit(BMImagePipelineOptions *options);
+
+/** Creates an image by rotating another image to "Up" orientation and scaling it, as described by _options_, and stores the time spent in each stage in _stats_, which may be `NULL`. The pixels of the image are copied once with `CGDataProviderCopyData`, which decodes lazily decoded images. Only the part of the copy that ends up in the result is scaled, and it is scaled before it is rotated: the scaled pixels are rotated tile by tile straight into the result, so the copy and the result are the only bitmaps, and the time spent rotating is part of `scaleTime`. Images that cannot be processed with `BMBitmapScale` and `BMBitmapOrient` are rotated and scaled with `BMImageCreateWithImageInOrientation` and the scale functions instead. */
+extern CGImageRef BMImageCreateWithImageAndOptions(CGImageRef                    image,
+                                                   const BMImagePipelineOptions *options,
+                                                   BMImagePipelineStats         *stats);
+
+/** Returns an estimate of the memory in bytes that `BMImageCreateWithImageAndOptions` needs to process a _width_ x _height_ image with _options_, i.e. the copy of the pixels plus the result at 4 bytes per pixel each. Images that have to be redrawn instead may need up to another full size bitmap. */
+extern uint64_t BMImagePipelineGetMemoryLength(size_t                        width,
+                                               size_t                        height,
+                                               const BMImagePipelineOptions *options);
+
+/** Rotates and scales an image like `BMImageCreateWithImageAndOptions`, and returns the result encoded as `options->encoderOptions` describe, see `BMImageCopyDataWithEncoderOptions`. */
+extern CFDataRef BMImageCopyDataWithOptions(CGImageRef                    image,
+                                            const BMImagePipelineOptions *options,
+                                            BMImagePipelineStats         *stats);
+
+/** Creates an image from a tiled bitmap, which may be far too large to be decoded at once, by scaling it with `BMTiledBitmapScale` and rotating it from _imageOrientation_ to "Up" orientation, so that the result is _width_ x _height_ pixels in "Up" orientation. Only the result is held in memory, the tiled bitmap is read tile by tile in parallel. The pixels of the tiled bitmap must have 8 bit components in _colorSpace_ as described by _bitmapInfo_, with premultiplied or no alpha. */
+extern CGImageRef BMImageCreateWithTiledBitmap(const BMTiledBitmap     *tiledBitmap,
+                                               BMImageOrientation       imageOrientation,
+                                               size_t                   width,
+                                               size_t                   height,
+                                               CGColorSpaceRef          colorSpace,
+                                               CGBitmapInfo             bitmapInfo,
+                                               CGInterpolationQuality   interpolationQuality);
+
 __END_DECLS
 
 #endif /* __BMIMAGEUTILITIES__ */
@@ -30,12 +30,28 @@
 
 #include "BMKitTypes.h"
 
+#include "BMBase64.h"
+#include "BMBitmapUtilities.h"
+#include "BMBufferPool.h"
+#include "BMChecksumUtilities.h"
+#include "BMDigestUtilities.h"
+#include "BMFileUtilities.h"
+#include "BMHex.h"
+#include "BMImageProbe.h"
 #include "BMImageUtilities.h"
 #include "BMObjectUtilities.h"
 
 #ifdef __OBJC__
 
+# import "BMBase64Decoder.h"
+# import "BMBase64Encoder.h"
+# import "BMChecksum.h"
+# import "BMDigest.h"
+# import "BMHMAC.h"
+# import "BMImageBatchProcessor.h"
+# import "BMLazyEnumerator.h"
 # import "BMNetworkReachabilityController.h"
+# import "BMThumbnailCache.h"
 
 # import "NSArray+BMKitAdditions.h"
 # import "NSData+BMKitAdditions.h"
@@ -0,0 +1,148 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "BMKitTypes.h"
+
+
+/** A lazy enumerator enumerates the objects of a collection through a pipeline of stages, which filter, transform, flatten and limit the objects.
+ 
+ Unlike chaining `filteredArrayUsingPredicateBlock:` and `transformedArrayUsingTransformator:`, no intermediate collections are created: the stages are fused, and each object of the collection passes through all stages before the next one is looked at. The objects of the collection are pulled in batches through `countByEnumeratingWithState:objects:count:`, and the results are handed out in batches through fast enumeration, so a `for ... in` loop over a lazy enumerator allocates nothing per object. Stages that limit the number of objects end the enumeration early, without looking at the remaining objects of the collection.
+ 
+ The stages are added to the receiver itself, which is returned, so they can be chained like this:
+ 
+     NSArray *names = [[[[BMLazyEnumerator enumeratorWithCollection:people]
+                         filteredEnumeratorUsingPredicateBlock:^BOOL(id person) { return [person isAdult]; }]
+                        transformedEnumeratorUsingTransformator:^id(id person) { return [person name]; }]
+                       enumeratorLimitedToCount:10] allObjects];
+ 
+ Stages must be added before the enumeration starts. The collection must not be modified while it is enumerated.
+ */
+@interface BMLazyEnumerator : NSEnumerator {
+@private
+    id<NSFastEnumeration>          _collection;
+    struct BMLazyEnumeratorStage  *_stages;
+    NSUInteger                     _numberOfStages;
+    NSFastEnumerationState         _collectionState;
+    id                             _collectionBuffer[16];
+    NSUInteger                     _collectionCount;
+    NSUInteger                     _collectionIndex;
+    unsigned long                  _collectionMutations;
+    NSUInteger                     _exhaustedStages;
+    id                            *_objects;
+    NSUInteger                     _objectsCapacity;
+    NSUInteger                     _numberOfObjects;
+    NSUInteger                     _objectIndex;
+    unsigned long                  _mutations;
+    BOOL                           _started;
+    BOOL                           _finished;
+}
+
+///-------------------------------------------
+/// @name Creating and Initializing Enumerators
+///-------------------------------------------
+
+/** Returns an autoreleased lazy enumerator over the objects of a collection, without any stages.
+ 
+ @param collection The collection to enumerate, which may be any object that supports fast enumeration, including other enumerators.
+ @return A lazy enumerator over the objects of *collection*.
+ */
++ (BMLazyEnumerator *)enumeratorWithCollection:(id<NSFastEnumeration>)collection;
+
+/** Initializes the receiver to enumerate the objects of a collection, without any stages.
+ 
+ This method raises `NSInvalidArgumentException` if *collection* is `nil`.
+ 
+ @param collection The collection to enumerate, which may be any object that supports fast enumeration, including other enumerators.
+ @return The initialized receiver.
+ */
+- (id)initWithCollection:(id<NSFastEnumeration>)collection;
+
+///----------------------
+/// @name Adding Stages
+///----------------------
+
+/** Adds a stage that only passes the objects for which the predicate block returns true.
+ 
+ This method raises `NSInvalidArgumentException` if *predicateBlock* is `nil`, and `NSInternalInconsistencyException` if the enumeration has already started.
+ 
+ @param predicateBlock The predicate block against which to evaluate the objects.
+ @return The receiver.
+ */
+- (BMLazyEnumerator *)filteredEnumeratorUsingPredicateBlock:(BMPredicateBlock)predicateBlock;
+
+/** Adds a stage that passes the results of the transformator instead of the objects. As with `transformedArrayUsingTransformator:`, `nil` results are replaced by `NSNull`.
+ 
+ This method raises `NSInvalidArgumentException` if *aTransformator* is `nil`, and `NSInternalInconsistencyException` if the enumeration has already started.
+ 
+ @param aTransformator The transformator to invoke on the objects.
+ @return The receiver.
+ */
+- (BMLazyEnumerator *)transformedEnumeratorUsingTransformator:(BMTransformator)aTransformator;
+
+/** Adds a stage that passes the objects of the collections returned by the transformator instead of the objects. The transformator may return `nil` to pass no objects.
+ 
+ This method raises `NSInvalidArgumentException` if *aTransformator* is `nil`, and `NSInternalInconsistencyException` if the enumeration has already started.
+ 
+ @param aTransformator The transformator to invoke on the objects, which returns an object that supports fast enumeration.
+ @return The receiver.
+ */
+- (BMLazyEnumerator *)flattenedEnumeratorUsingTransformator:(BMTransformator)aTransformator;
+
+/** Adds a stage that passes at most *count* objects, and ends the enumeration afterwards.
+ 
+ This method raises `NSInternalInconsistencyException` if the enumeration has already started.
+ 
+ @param count The maximum number of objects to pass.
+ @return The receiver.
+ */
+- (BMLazyEnumerator *)enumeratorLimitedToCount:(NSUInteger)count;
+
+///------------------------------
+/// @name Enumerating Objects
+///------------------------------
+
+/** Returns the next object from the pipeline, or `nil` if the enumeration has ended.
+ 
+ @return The next object from the pipeline.
+ */
+- (id)nextObject;
+
+/** Returns the next object from the pipeline, and ends the enumeration.
+ 
+ @return The next object from the pipeline, or `nil` if there is none.
+ */
+- (id)firstObject;
+
+/** Returns an array of the objects the receiver has yet to enumerate, which is the only collection created by the pipeline.
+ 
+ @return An array of the objects the receiver has yet to enumerate.
+ */
+- (NSArray *)allObjects;
+
+@end
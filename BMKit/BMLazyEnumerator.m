@@ -0,0 +1,304 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#import "BMLazyEnumerator.h"
+
+
+typedef enum _BMLazyEnumeratorStageType {
+    BMLazyEnumeratorStageTypeFilter,
+    BMLazyEnumeratorStageTypeTransform,
+    BMLazyEnumeratorStageTypeFlatten,
+    BMLazyEnumeratorStageTypeLimit
+} BMLazyEnumeratorStageType;
+
+
+struct BMLazyEnumeratorStage
+{
+    BMLazyEnumeratorStageType type;
+    id                        block;
+    NSUInteger                count;
+};
+
+
+@interface BMLazyEnumerator (BMKitInternals)
+
+- (BMLazyEnumerator *)BM_addStageWithType:(BMLazyEnumeratorStageType)type block:(id)block count:(NSUInteger)count selector:(SEL)aSelector;
+- (void)BM_passObject:(id)object throughStagesFromIndex:(NSUInteger)index;
+- (BOOL)BM_fillObjects;
+
+@end
+
+
+@implementation BMLazyEnumerator
+
+
++ (BMLazyEnumerator *)enumeratorWithCollection:(id<NSFastEnumeration>)collection
+{
+    return [[[self alloc] initWithCollection:collection] autorelease];
+}
+
+
+- (id)init
+{
+    return [self initWithCollection:nil];
+}
+
+
+- (id)initWithCollection:(id<NSFastEnumeration>)collection
+{
+    if (!collection) {
+        [self release];
+        [NSException raise:NSInvalidArgumentException
+                    format:@"collection is nil (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    self = [super init];
+    if (self) {
+        _collection = [(id)collection retain];
+    }
+    return self;
+}
+
+
+- (void)dealloc
+{
+    for (NSUInteger i = 0; i < _numberOfObjects; ++i) {
+        [_objects[i] release];
+    }
+    free(_objects), _objects = NULL;
+    for (NSUInteger i = 0; i < _numberOfStages; ++i) {
+        [_stages[i].block release];
+    }
+    free(_stages), _stages = NULL;
+    [(id)_collection release], _collection = nil;
+    [super dealloc];
+}
+
+
+#pragma mark -
+#pragma mark Adding Stages
+
+
+- (BMLazyEnumerator *)BM_addStageWithType:(BMLazyEnumeratorStageType)type block:(id)block count:(NSUInteger)count selector:(SEL)aSelector
+{
+    if (_started) {
+        [NSException raise:NSInternalInconsistencyException
+                    format:@"Stages cannot be added after the enumeration started (in '%@')", NSStringFromSelector(aSelector)];
+    }
+    struct BMLazyEnumeratorStage *stages = (struct BMLazyEnumeratorStage *)realloc(_stages, (_numberOfStages + 1) * sizeof(struct BMLazyEnumeratorStage));
+    if (!stages) {
+        [NSException raise:NSMallocException
+                    format:@"Out of memory (in '%@')", NSStringFromSelector(aSelector)];
+    }
+    _stages = stages;
+    _stages[_numberOfStages].type = type;
+    _stages[_numberOfStages].block = [block copy];
+    _stages[_numberOfStages].count = count;
+    _numberOfStages++;
+    return self;
+}
+
+
+- (BMLazyEnumerator *)filteredEnumeratorUsingPredicateBlock:(BMPredicateBlock)predicateBlock
+{
+    if (!predicateBlock) {
+        [NSException raise:NSInvalidArgumentException
+                    format:@"predicateBlock is nil (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    return [self BM_addStageWithType:BMLazyEnumeratorStageTypeFilter block:predicateBlock count:0 selector:_cmd];
+}
+
+
+- (BMLazyEnumerator *)transformedEnumeratorUsingTransformator:(BMTransformator)aTransformator
+{
+    if (!aTransformator) {
+        [NSException raise:NSInvalidArgumentException
+                    format:@"aTransformator is nil (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    return [self BM_addStageWithType:BMLazyEnumeratorStageTypeTransform block:aTransformator count:0 selector:_cmd];
+}
+
+
+- (BMLazyEnumerator *)flattenedEnumeratorUsingTransformator:(BMTransformator)aTransformator
+{
+    if (!aTransformator) {
+        [NSException raise:NSInvalidArgumentException
+                    format:@"aTransformator is nil (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    return [self BM_addStageWithType:BMLazyEnumeratorStageTypeFlatten block:aTransformator count:0 selector:_cmd];
+}
+
+
+- (BMLazyEnumerator *)enumeratorLimitedToCount:(NSUInteger)count
+{
+    return [self BM_addStageWithType:BMLazyEnumeratorStageTypeLimit block:nil count:count selector:_cmd];
+}
+
+
+#pragma mark -
+#pragma mark Pipeline
+
+
+// Passes an object through the stages from index on, and appends the result to
+// the objects to hand out. A limit stage that has passed its last object marks
+// itself as exhausted, which ends the enumeration of the collection and of the
+// collections of the flatten stages in front of it
+- (void)BM_passObject:(id)object throughStagesFromIndex:(NSUInteger)index
+{
+    for (; index < _numberOfStages; ++index) {
+        struct BMLazyEnumeratorStage *stage = &_stages[index];
+        switch (stage->type) {
+            case BMLazyEnumeratorStageTypeFilter:
+                if (!((BMPredicateBlock)stage->block)(object)) {
+                    return;
+                }
+                break;
+                
+            case BMLazyEnumeratorStageTypeTransform:
+                object = ((BMTransformator)stage->block)(object) ?: [NSNull null];
+                break;
+                
+            case BMLazyEnumeratorStageTypeFlatten:
+                for (id element in (id<NSFastEnumeration>)((BMTransformator)stage->block)(object)) {
+                    [self BM_passObject:element throughStagesFromIndex:index + 1];
+                    if (_exhaustedStages > index + 1) {
+                        break;
+                    }
+                }
+                return;
+                
+            case BMLazyEnumeratorStageTypeLimit:
+                if (!stage->count) {
+                    _exhaustedStages = MAX(_exhaustedStages, index + 1);
+                    return;
+                }
+                if (!--stage->count) {
+                    _exhaustedStages = MAX(_exhaustedStages, index + 1);
+                }
+                break;
+        }
+    }
+    if (_numberOfObjects == _objectsCapacity) {
+        NSUInteger capacity = _objectsCapacity ? 2 * _objectsCapacity : 16;
+        id *objects = (id *)realloc(_objects, capacity * sizeof(id));
+        if (!objects) {
+            [NSException raise:NSMallocException
+                        format:@"Out of memory (in '%@')", NSStringFromSelector(_cmd)];
+        }
+        _objects = objects;
+        _objectsCapacity = capacity;
+    }
+    _objects[_numberOfObjects++] = [object retain];
+}
+
+
+// Releases the objects handed out before, and pulls batches of objects from the
+// collection through the stages, until there are objects to hand out or the
+// enumeration ended
+- (BOOL)BM_fillObjects
+{
+    for (NSUInteger i = 0; i < _numberOfObjects; ++i) {
+        [_objects[i] release];
+    }
+    _numberOfObjects = _objectIndex = 0;
+    _started = YES;
+    while (!_numberOfObjects && !_finished) {
+        if (_collectionIndex == _collectionCount) {
+            BOOL initial = (_collectionState.state == 0);
+            _collectionCount = [_collection countByEnumeratingWithState:&_collectionState objects:_collectionBuffer count:16];
+            _collectionIndex = 0;
+            if (!_collectionCount) {
+                _finished = YES;
+                break;
+            }
+            if (initial) {
+                _collectionMutations = *_collectionState.mutationsPtr;
+            }
+            else if (*_collectionState.mutationsPtr != _collectionMutations) {
+                [NSException raise:NSGenericException
+                            format:@"Collection %@ was mutated while being enumerated (in '%@')", _collection, NSStringFromSelector(_cmd)];
+            }
+        }
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        while (_collectionIndex < _collectionCount && !_exhaustedStages) {
+            [self BM_passObject:_collectionState.itemsPtr[_collectionIndex++] throughStagesFromIndex:0];
+        }
+        _finished = (_exhaustedStages != 0);
+        [pool drain];
+    }
+    return (_numberOfObjects != 0);
+}
+
+
+#pragma mark -
+#pragma mark Enumerating Objects
+
+
+- (id)nextObject
+{
+    if (_objectIndex == _numberOfObjects && ![self BM_fillObjects]) {
+        return nil;
+    }
+    return [[_objects[_objectIndex++] retain] autorelease];
+}
+
+
+- (id)firstObject
+{
+    id object = [self nextObject];
+    _objectIndex = _numberOfObjects;
+    _finished = YES;
+    return object;
+}
+
+
+- (NSArray *)allObjects
+{
+    NSMutableArray *allObjects = [NSMutableArray array];
+    for (id object in self) {
+        [allObjects addObject:object];
+    }
+    return allObjects;
+}
+
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state objects:(id *)buffer count:(NSUInteger)length
+{
+    // Hand out the buffered objects directly, they stay
+    // retained until the next batch is requested
+    if (_objectIndex == _numberOfObjects && ![self BM_fillObjects]) {
+        return 0;
+    }
+    NSUInteger count = _numberOfObjects - _objectIndex;
+    state->state = 1;
+    state->itemsPtr = _objects + _objectIndex;
+    state->mutationsPtr = &_mutations;
+    _objectIndex = _numberOfObjects;
+    return count;
+}
+
+
+@end
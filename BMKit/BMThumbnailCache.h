@@ -0,0 +1,124 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <dispatch/dispatch.h>
+
+#import <Foundation/Foundation.h>
+
+#include "BMImageUtilities.h"
+
+@class BMThumbnailCacheEntry;
+@class BMThumbnailCacheRequest;
+
+
+/** Counters of a thumbnail cache. */
+typedef struct _BMThumbnailCacheStats {
+    NSUInteger         memoryHits;        /**< Requests served from the memory cache. */
+    NSUInteger         diskHits;          /**< Requests served from the disk cache. */
+    NSUInteger         misses;            /**< Requests that computed the thumbnail. */
+    NSUInteger         coalescedRequests; /**< Requests that waited for the same thumbnail being produced by another request, and got its result; they are neither hits nor misses. */
+    NSUInteger         evictions;         /**< Thumbnails evicted from the memory cache. */
+    unsigned long long memoryLength;      /**< Bytes of decoded pixels in the memory cache. */
+} BMThumbnailCacheStats;
+
+
+/** You use a thumbnail cache to avoid computing the same thumbnail again and again.
+ 
+ Thumbnails are produced from encoded images with the image pipeline of `BMImageCreateWithImageAndOptions`. They are identified by the SHA-256 digest of the encoded image and the pipeline options, i.e. the orientation, scale mode, size, focal point, interpolation quality and encoder options, so the same image yields the same thumbnail no matter where it came from.
+ 
+ The cache has two tiers: the decoded thumbnails are kept in memory, bounded by the bytes of their pixels and evicting the least recently used thumbnails first, and the encoded thumbnails are written to a directory on disk, bounded by the bytes of the files and evicting the oldest files first. When several threads ask for the same thumbnail at the same time, only the first one computes it, and the others wait for its result.
+ 
+ The memory cache returns the exact pixels computed by the pipeline, whereas the disk cache returns the thumbnail decoded from its encoded file. So with a lossy encoder, e.g. JPEG, a thumbnail served from the disk cache differs slightly from the same thumbnail served from memory, and its alpha channel may be lost. Use a lossless encoder, e.g. `kUTTypePNG`, if the tiers must return identical pixels.
+ 
+ The memory cache is emptied when the application receives a memory warning.
+ */
+@interface BMThumbnailCache : NSObject {
+@private
+    NSString               *_path;
+    NSCondition            *_condition;
+    NSMutableDictionary    *_entries;
+    NSMutableDictionary    *_pendingRequests;
+    BMThumbnailCacheEntry  *_newestEntry;
+    BMThumbnailCacheEntry  *_oldestEntry;
+    unsigned long long      _memoryCapacity;
+    BMThumbnailCacheStats   _stats;
+    dispatch_queue_t        _diskQueue;
+    unsigned long long      _diskCapacity;
+    unsigned long long      _diskLength;
+    BOOL                    _diskLengthKnown;
+}
+
+/** The directory of the disk cache, or `nil` if the receiver has no disk cache. */
+@property (nonatomic, copy, readonly) NSString *path;
+
+/** The maximum number of bytes of decoded pixels in the memory cache. Defaults to 32 MiB. */
+@property (assign) unsigned long long memoryCapacity;
+
+/** The maximum number of bytes of files in the disk cache. Defaults to 128 MiB. */
+@property (assign) unsigned long long diskCapacity;
+
+/** The counters of the receiver. */
+@property (readonly) BMThumbnailCacheStats stats;
+
+///---------------------------------------------
+/// @name Initializing a Thumbnail Cache
+///---------------------------------------------
+
+/** Initializes the receiver with a disk cache in the directory at *path*, which is created if necessary.
+ 
+ @param path The directory of the disk cache, or `nil` to only cache thumbnails in memory.
+ @return The initialized receiver.
+ */
+- (id)initWithPath:(NSString *)path;
+
+///-----------------------------
+/// @name Getting Thumbnails
+///-----------------------------
+
+/** Returns the thumbnail of an encoded image, from the cache or computed with `BMImageCreateWithImageAndOptions`.
+ 
+ This method may block while the thumbnail is computed by this or another thread, and can be called from any thread. The caller owns the returned image and must release it with `CGImageRelease`.
+ 
+ This method raises `NSInvalidArgumentException` if *data* is `nil` or *options* is `NULL`.
+ 
+ @param data The encoded image.
+ @param options The pipeline options for the thumbnail. The encoder options are used for the disk cache.
+ @return The thumbnail, or `NULL` if *data* could not be decoded.
+ */
+- (CGImageRef)copyThumbnailWithData:(NSData *)data options:(const BMImagePipelineOptions *)options;
+
+///---------------------------------
+/// @name Removing Thumbnails
+///---------------------------------
+
+/** Removes all thumbnails from the memory cache. */
+- (void)removeAllThumbnailsFromMemory;
+
+/** Removes all thumbnails from the memory cache and the disk cache. */
+- (void)removeAllThumbnails;
+
+@end
@@ -0,0 +1,499 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <sys/time.h>
+
+#include <ImageIO/ImageIO.h>
+
+#import "BMThumbnailCache.h"
+#import "NSData+BMKitAdditions.h"
+
+
+// A thumbnail in the memory cache, which is linked into the list
+// of entries from the most to the least recently used
+@interface BMThumbnailCacheEntry : NSObject {
+@public
+    NSString              *_key;
+    CGImageRef             _image;
+    unsigned long long     _length;
+    BMThumbnailCacheEntry *_newer;
+    BMThumbnailCacheEntry *_older;
+}
+
+@end
+
+
+@implementation BMThumbnailCacheEntry
+
+
+- (void)dealloc
+{
+    [_key release], _key = nil;
+    CGImageRelease(_image), _image = NULL;
+    [super dealloc];
+}
+
+
+@end
+
+
+// A thumbnail being produced, which the requests that wait for the same
+// thumbnail take the result from once it is finished
+@interface BMThumbnailCacheRequest : NSObject {
+@public
+    CGImageRef _thumbnail;
+    BOOL       _finished;
+}
+
+@end
+
+
+@implementation BMThumbnailCacheRequest
+
+
+- (void)dealloc
+{
+    CGImageRelease(_thumbnail), _thumbnail = NULL;
+    [super dealloc];
+}
+
+
+@end
+
+
+@interface BMThumbnailCache (BMKitInternals)
+
+- (void)BM_unlinkEntry:(BMThumbnailCacheEntry *)entry;
+- (void)BM_linkEntry:(BMThumbnailCacheEntry *)entry;
+- (void)BM_evictEntriesToCapacity:(unsigned long long)capacity;
+- (CGImageRef)BM_copyThumbnailFromDiskWithKey:(NSString *)key;
+- (void)BM_writeThumbnail:(CGImageRef)thumbnail withKey:(NSString *)key encoderOptions:(const BMImageEncoderOptions *)encoderOptions;
+- (void)BM_trimDisk;
+
+@end
+
+
+// Returns the cache key for the thumbnail of the encoded image with the pipeline
+// options, which only consists of characters that are safe in file names, and
+// formats the floating point options with enough digits to tell any two apart
+static NSString *BMThumbnailCacheCreateKey(NSData *data, const BMImagePipelineOptions *options)
+{
+    const BMImageEncoderOptions *encoderOptions = &options->encoderOptions;
+    return [[NSString alloc] initWithFormat:@"%@-%d-%d-%.17gx%.17g-%.17g,%.17g-%d-%@-%.17g-%d",
+            [data SHA256String],
+            (int)options->orientation,
+            (int)options->scaleMode,
+            (double)options->size.width,
+            (double)options->size.height,
+            (double)options->focalPoint.x,
+            (double)options->focalPoint.y,
+            (int)options->interpolationQuality,
+            (NSString *)encoderOptions->type,
+            (double)encoderOptions->quality,
+            (int)encoderOptions->progressive];
+}
+
+
+@implementation BMThumbnailCache
+
+
+@synthesize path = _path;
+
+
+- (id)init
+{
+    return [self initWithPath:nil];
+}
+
+
+- (id)initWithPath:(NSString *)path
+{
+    self = [super init];
+    if (self) {
+        _path = [path copy];
+        _condition = [[NSCondition alloc] init];
+        _entries = [[NSMutableDictionary alloc] init];
+        _pendingRequests = [[NSMutableDictionary alloc] init];
+        _memoryCapacity = 32ULL << 20;
+        _diskCapacity = 128ULL << 20;
+        if (_path) {
+            [[NSFileManager defaultManager] createDirectoryAtPath:_path withIntermediateDirectories:YES attributes:nil error:NULL];
+            _diskQueue = dispatch_queue_create("BMThumbnailCache", NULL);
+        }
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(removeAllThumbnailsFromMemory)
+                                                     name:@"UIApplicationDidReceiveMemoryWarningNotification"
+                                                   object:nil];
+    }
+    return self;
+}
+
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    if (_diskQueue) dispatch_release(_diskQueue), _diskQueue = NULL;
+    [_pendingRequests release], _pendingRequests = nil;
+    [_entries release], _entries = nil;
+    [_condition release], _condition = nil;
+    [_path release], _path = nil;
+    [super dealloc];
+}
+
+
+#pragma mark -
+#pragma mark Properties
+
+
+- (unsigned long long)memoryCapacity
+{
+    [_condition lock];
+    unsigned long long memoryCapacity = _memoryCapacity;
+    [_condition unlock];
+    return memoryCapacity;
+}
+
+
+- (void)setMemoryCapacity:(unsigned long long)memoryCapacity
+{
+    [_condition lock];
+    _memoryCapacity = memoryCapacity;
+    [self BM_evictEntriesToCapacity:memoryCapacity];
+    [_condition unlock];
+}
+
+
+- (unsigned long long)diskCapacity
+{
+    [_condition lock];
+    unsigned long long diskCapacity = _diskCapacity;
+    [_condition unlock];
+    return diskCapacity;
+}
+
+
+- (void)setDiskCapacity:(unsigned long long)diskCapacity
+{
+    [_condition lock];
+    _diskCapacity = diskCapacity;
+    [_condition unlock];
+    if (_diskQueue) {
+        dispatch_async(_diskQueue, ^{
+            [self BM_trimDisk];
+        });
+    }
+}
+
+
+- (BMThumbnailCacheStats)stats
+{
+    [_condition lock];
+    BMThumbnailCacheStats stats = _stats;
+    [_condition unlock];
+    return stats;
+}
+
+
+#pragma mark -
+#pragma mark Memory Cache
+
+
+// The methods of the memory cache must be called with the condition locked
+
+
+- (void)BM_unlinkEntry:(BMThumbnailCacheEntry *)entry
+{
+    if (entry->_newer) {
+        entry->_newer->_older = entry->_older;
+    }
+    else {
+        _newestEntry = entry->_older;
+    }
+    if (entry->_older) {
+        entry->_older->_newer = entry->_newer;
+    }
+    else {
+        _oldestEntry = entry->_newer;
+    }
+    entry->_newer = entry->_older = nil;
+}
+
+
+- (void)BM_linkEntry:(BMThumbnailCacheEntry *)entry
+{
+    entry->_older = _newestEntry;
+    if (_newestEntry) {
+        _newestEntry->_newer = entry;
+    }
+    else {
+        _oldestEntry = entry;
+    }
+    _newestEntry = entry;
+}
+
+
+- (void)BM_evictEntriesToCapacity:(unsigned long long)capacity
+{
+    while (_oldestEntry && _stats.memoryLength > capacity) {
+        BMThumbnailCacheEntry *entry = _oldestEntry;
+        [self BM_unlinkEntry:entry];
+        _stats.memoryLength -= entry->_length;
+        _stats.evictions++;
+        [_entries removeObjectForKey:entry->_key];
+    }
+}
+
+
+#pragma mark -
+#pragma mark Disk Cache
+
+
+- (CGImageRef)BM_copyThumbnailFromDiskWithKey:(NSString *)key
+{
+    CGImageRef thumbnail = NULL;
+    NSString *path = [_path stringByAppendingPathComponent:key];
+    NSData *data = [[NSData alloc] initWithContentsOfFile:path];
+    if (data) {
+        CGImageSourceRef imageSource = CGImageSourceCreateWithData((CFDataRef)data, NULL);
+        if (imageSource) {
+            thumbnail = CGImageSourceCreateImageAtIndex(imageSource, 0, NULL);
+            CFRelease(imageSource);
+        }
+        [data release];
+        
+        // Touch the file, so the disk cache evicts the least recently used files
+        if (thumbnail) {
+            dispatch_async(_diskQueue, ^{
+                (void)utimes([path fileSystemRepresentation], NULL);
+            });
+        }
+    }
+    return thumbnail;
+}
+
+
+- (void)BM_writeThumbnail:(CGImageRef)thumbnail withKey:(NSString *)key encoderOptions:(const BMImageEncoderOptions *)encoderOptions
+{
+    BMImageEncoderOptions options = *encoderOptions;
+    CGImageRetain(thumbnail);
+    if (options.type) CFRetain(options.type);
+    dispatch_async(_diskQueue, ^{
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        NSData *data = (NSData *)BMImageCopyDataWithEncoderOptions(thumbnail, BMImageOrientationUp, &options);
+        if (data) {
+            // A file written for the same key before is replaced
+            NSString *path = [_path stringByAppendingPathComponent:key];
+            unsigned long long previousLength = [[[NSFileManager defaultManager] attributesOfItemAtPath:path error:NULL] fileSize];
+            if ([data writeToFile:path atomically:YES]) {
+                _diskLength -= MIN(previousLength, _diskLength);
+                _diskLength += [data length];
+                [self BM_trimDisk];
+            }
+            [data release];
+        }
+        if (options.type) CFRelease(options.type);
+        CGImageRelease(thumbnail);
+        [pool drain];
+    });
+}
+
+
+// Removes the least recently used files until the disk cache fits into its
+// capacity, must be called on the disk queue
+- (void)BM_trimDisk
+{
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    unsigned long long diskCapacity = [self diskCapacity];
+    if (_diskLengthKnown && _diskLength <= diskCapacity) {
+        return;
+    }
+    
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSMutableArray *files = [NSMutableArray array];
+    _diskLength = 0;
+    for (NSString *name in [fileManager contentsOfDirectoryAtPath:_path error:NULL]) {
+        NSString *path = [_path stringByAppendingPathComponent:name];
+        NSDictionary *attributes = [fileManager attributesOfItemAtPath:path error:NULL];
+        if (attributes) {
+            [files addObject:[NSDictionary dictionaryWithObjectsAndKeys:
+                              path, @"path",
+                              [attributes fileModificationDate], NSFileModificationDate,
+                              [NSNumber numberWithUnsignedLongLong:[attributes fileSize]], NSFileSize,
+                              nil]];
+            _diskLength += [attributes fileSize];
+        }
+    }
+    _diskLengthKnown = YES;
+    if (_diskLength > diskCapacity) {
+        [files sortUsingDescriptors:[NSArray arrayWithObject:[NSSortDescriptor sortDescriptorWithKey:NSFileModificationDate ascending:YES]]];
+        for (NSDictionary *file in files) {
+            if (_diskLength <= diskCapacity) {
+                break;
+            }
+            if ([fileManager removeItemAtPath:[file objectForKey:@"path"] error:NULL]) {
+                _diskLength -= [[file objectForKey:NSFileSize] unsignedLongLongValue];
+            }
+        }
+    }
+    [pool drain];
+}
+
+
+#pragma mark -
+#pragma mark Getting Thumbnails
+
+
+- (CGImageRef)copyThumbnailWithData:(NSData *)data options:(const BMImagePipelineOptions *)options
+{
+    if (!data) {
+        [NSException raise:NSInvalidArgumentException
+                    format:@"data is nil (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    if (!options) {
+        [NSException raise:NSInvalidArgumentException
+                    format:@"options is NULL (in '%@')", NSStringFromSelector(_cmd)];
+    }
+    NSString *key = BMThumbnailCacheCreateKey(data, options);
+    CGImageRef thumbnail = NULL;
+    
+    // Take the thumbnail from the memory cache, or wait until another
+    // thread that is producing the same thumbnail hands over its result
+    BMThumbnailCacheRequest *request = nil;
+    [_condition lock];
+    BMThumbnailCacheEntry *entry = [_entries objectForKey:key];
+    if (entry) {
+        [self BM_unlinkEntry:entry];
+        [self BM_linkEntry:entry];
+        thumbnail = CGImageRetain(entry->_image);
+        _stats.memoryHits++;
+    }
+    else if ((request = [[_pendingRequests objectForKey:key] retain])) {
+        // The result is taken from the request, even if the memory cache has
+        // evicted it already, so it is neither computed twice nor a miss
+        _stats.coalescedRequests++;
+        while (!request->_finished) {
+            [_condition wait];
+        }
+        thumbnail = CGImageRetain(request->_thumbnail);
+        [request release];
+        [_condition unlock];
+        [key release];
+        return thumbnail;
+    }
+    else {
+        request = [[BMThumbnailCacheRequest alloc] init];
+        [_pendingRequests setObject:request forKey:key];
+    }
+    [_condition unlock];
+    if (thumbnail) {
+        [key release];
+        return thumbnail;
+    }
+    
+    // Produce the thumbnail from the disk cache or from the encoded image
+    BOOL diskHit = NO;
+    if (_path) {
+        thumbnail = [self BM_copyThumbnailFromDiskWithKey:key];
+        diskHit = (thumbnail != NULL);
+    }
+    if (!thumbnail) {
+        CGImageSourceRef imageSource = CGImageSourceCreateWithData((CFDataRef)data, NULL);
+        if (imageSource) {
+            CGImageRef image = CGImageSourceCreateImageAtIndex(imageSource, 0, NULL);
+            if (image) {
+                thumbnail = BMImageCreateWithImageAndOptions(image, options, NULL);
+                CGImageRelease(image);
+            }
+            CFRelease(imageSource);
+        }
+        if (thumbnail && _path) {
+            [self BM_writeThumbnail:thumbnail withKey:key encoderOptions:&options->encoderOptions];
+        }
+    }
+    
+    [_condition lock];
+    if (diskHit) {
+        _stats.diskHits++;
+    }
+    else {
+        _stats.misses++;
+    }
+    if (thumbnail) {
+        entry = [[BMThumbnailCacheEntry alloc] init];
+        entry->_key = [key retain];
+        entry->_image = CGImageRetain(thumbnail);
+        entry->_length = (unsigned long long)CGImageGetBytesPerRow(thumbnail) * CGImageGetHeight(thumbnail);
+        [_entries setObject:entry forKey:key];
+        [self BM_linkEntry:entry];
+        _stats.memoryLength += entry->_length;
+        [self BM_evictEntriesToCapacity:_memoryCapacity];
+        [entry release];
+    }
+    request->_thumbnail = CGImageRetain(thumbnail);
+    request->_finished = YES;
+    [_pendingRequests removeObjectForKey:key];
+    [request release];
+    [_condition broadcast];
+    [_condition unlock];
+    [key release];
+    return thumbnail;
+}
+
+
+#pragma mark -
+#pragma mark Removing Thumbnails
+
+
+- (void)removeAllThumbnailsFromMemory
+{
+    [_condition lock];
+    [_entries removeAllObjects];
+    _newestEntry = _oldestEntry = nil;
+    _stats.memoryLength = 0;
+    [_condition unlock];
+}
+
+
+- (void)removeAllThumbnails
+{
+    [self removeAllThumbnailsFromMemory];
+    if (_diskQueue) {
+        dispatch_async(_diskQueue, ^{
+            NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+            NSFileManager *fileManager = [NSFileManager defaultManager];
+            for (NSString *name in [fileManager contentsOfDirectoryAtPath:_path error:NULL]) {
+                [fileManager removeItemAtPath:[_path stringByAppendingPathComponent:name] error:NULL];
+            }
+            _diskLength = 0;
+            _diskLengthKnown = YES;
+            [pool drain];
+        });
+    }
+}
+
+
+@end
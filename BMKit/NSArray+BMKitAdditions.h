@@ -71,4 +71,42 @@
  */
 - (NSArray *)transformedArrayUsingTransformator:(BMTransformator)aTransformator;
 
+/** Evaluates a given predicate block against each object in the receiving array concurrently and returns a new array containing the objects for which the predicate block returns true, in the order of the receiving array.
+ 
+ The objects are split into chunks of about the same size, a few per processor core. See `concurrentlyFilteredArrayUsingPredicateBlock:grainSize:` for details.
+ 
+ @param predicateBlock The predicate block against which to evaluate the receiving array’s elements. The block is invoked concurrently from several threads, in no particular order.
+ @return A new array containing the objects in the receiving array for which *predicateBlock* returns true.
+ */
+- (NSArray *)concurrentlyFilteredArrayUsingPredicateBlock:(BMPredicateBlock)predicateBlock;
+
+/** Evaluates a given predicate block against each object in the receiving array concurrently and returns a new array containing the objects for which the predicate block returns true, in the order of the receiving array.
+ 
+ The objects are split into chunks of *grainSize* objects, which are filtered in parallel; each chunk moves its surviving objects to its front and counts them, and the survivors of all chunks are then moved together in chunk order. This only pays off if the predicate block is expensive compared to the overhead of scheduling a chunk, so chunks should be large enough for cheap predicate blocks.
+ 
+ @param predicateBlock The predicate block against which to evaluate the receiving array’s elements. The block is invoked concurrently from several threads, in no particular order.
+ @param grainSize The number of objects per chunk, or 0 to split the objects into a few chunks per processor core.
+ @return A new array containing the objects in the receiving array for which *predicateBlock* returns true.
+ */
+- (NSArray *)concurrentlyFilteredArrayUsingPredicateBlock:(BMPredicateBlock)predicateBlock grainSize:(NSUInteger)grainSize;
+
+/** Invokes the transformator on each object in the receiving array concurrently and returns a new array containing the transformed objects, in the order of the receiving array.
+ 
+ The objects are split into chunks of about the same size, a few per processor core. See `concurrentlyTransformedArrayUsingTransformator:grainSize:` for details.
+ 
+ @param aTransformator The transformator to invoke on the receiving array's elements. The transformator is invoked concurrently from several threads, in no particular order.
+ @return A new array containing the transformed objects in the receiving array.
+ */
+- (NSArray *)concurrentlyTransformedArrayUsingTransformator:(BMTransformator)aTransformator;
+
+/** Invokes the transformator on each object in the receiving array concurrently and returns a new array containing the transformed objects, in the order of the receiving array.
+ 
+ The objects are split into chunks of *grainSize* objects, which are transformed in parallel, each storing its results at the indices of its objects. As with `transformedArrayUsingTransformator:`, `nil` results are replaced by `NSNull`.
+ 
+ @param aTransformator The transformator to invoke on the receiving array's elements. The transformator is invoked concurrently from several threads, in no particular order.
+ @param grainSize The number of objects per chunk, or 0 to split the objects into a few chunks per processor core.
+ @return A new array containing the transformed objects in the receiving array.
+ */
+- (NSArray *)concurrentlyTransformedArrayUsingTransformator:(BMTransformator)aTransformator grainSize:(NSUInteger)grainSize;
+
 @end
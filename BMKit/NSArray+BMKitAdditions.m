@@ -26,6 +26,7 @@
  */
 
 #import "NSArray+BMKitAdditions.h"
+#import "BMCollectionUtilities.h"
 
 
 @implementation NSArray (BMKitAdditions)
@@ -100,4 +101,55 @@
 }
 
 
+- (NSArray *)concurrentlyFilteredArrayUsingPredicateBlock:(BMPredicateBlock)predicateBlock
+{
+    return [self concurrentlyFilteredArrayUsingPredicateBlock:predicateBlock grainSize:0];
+}
+
+
+- (NSArray *)concurrentlyFilteredArrayUsingPredicateBlock:(BMPredicateBlock)predicateBlock grainSize:(NSUInteger)grainSize
+{
+    NSArray *filteredArray = nil;
+    if (predicateBlock) {
+        NSUInteger numberOfObjects = [self count];
+        id *objects = (id *)malloc((numberOfObjects + 1) * sizeof(id));
+        if (objects) {
+            [self getObjects:objects range:NSMakeRange(0, numberOfObjects)];
+            NSUInteger numberOfSurvivors = BMCollectionFilterObjects(objects, numberOfObjects, grainSize, predicateBlock);
+            if (numberOfSurvivors != NSNotFound) {
+                filteredArray = [NSArray arrayWithObjects:objects count:numberOfSurvivors];
+            }
+            free(objects);
+        }
+    }
+    return filteredArray;
+}
+
+
+- (NSArray *)concurrentlyTransformedArrayUsingTransformator:(BMTransformator)aTransformator
+{
+    return [self concurrentlyTransformedArrayUsingTransformator:aTransformator grainSize:0];
+}
+
+
+- (NSArray *)concurrentlyTransformedArrayUsingTransformator:(BMTransformator)aTransformator grainSize:(NSUInteger)grainSize
+{
+    NSArray *transformedArray = nil;
+    if (aTransformator) {
+        NSUInteger numberOfObjects = [self count];
+        id *objects = (id *)malloc((numberOfObjects + 1) * sizeof(id));
+        if (objects) {
+            [self getObjects:objects range:NSMakeRange(0, numberOfObjects)];
+            BMCollectionTransformObjects(objects, numberOfObjects, grainSize, aTransformator);
+            transformedArray = [NSArray arrayWithObjects:objects count:numberOfObjects];
+            for (NSUInteger i = 0; i < numberOfObjects; ++i) {
+                [objects[i] release];
+            }
+            free(objects);
+        }
+    }
+    return transformedArray;
+}
+
+
 @end
@@ -27,6 +27,10 @@
 
 #import <Foundation/Foundation.h>
 
+#include "BMChecksumUtilities.h"
+#include "BMDigestUtilities.h"
+#include "BMHex.h"
+
 
 /** BMKit related additions to the `NSData` class. */
 @interface NSData (BMKitAdditions)
@@ -61,10 +65,174 @@
  */
 - (NSString *)base64EncodedString;
 
+///--------------------
+/// @name Hex Encoding
+///--------------------
+
+/** Returns the decoded data of a hex-encoded string.
+ 
+ @param aString A hex-encoded string.
+ @return The decoded data of the hex-encoded string _aString_, or `nil` in case of an error.
+ @see initWithHexEncodedString:
+ @see hexEncodedString
+ */
++ (NSData *)dataWithHexEncodedString:(NSString *)aString;
+
+/** Initializes the receiver by decoding the data from a hex-encoded string.
+ 
+ Both lowercase and uppercase digits are accepted, and whitespace, colons and dashes between bytes are ignored, so the output of `hexEncodedStringWithOptions:separator:groupLength:` can be decoded as well.
+ 
+ @param aString A hex-encoded string.
+ @return The receiver, or `nil` in case of an error.
+ @see dataWithHexEncodedString:
+ @see hexEncodedString
+ */
+- (id)initWithHexEncodedString:(NSString *)aString;
+
+/** Returns the lowercase hex-encoded content of the receiver.
+ 
+ @return An NSString with the hex encoding of the receivers bytes.
+ @see hexEncodedStringWithOptions:separator:groupLength:
+ @see initWithHexEncodedString:
+ */
+- (NSString *)hexEncodedString;
+
+/** Returns the hex-encoded content of the receiver.
+ 
+ @param options The hex encoding options.
+ @param separator The ASCII character inserted between groups of bytes.
+ @param groupLength The number of bytes per group, or 0 to not insert any separators.
+ @return An NSString with the hex encoding of the receivers bytes.
+ @see hexEncodedString
+ @see initWithHexEncodedString:
+ */
+- (NSString *)hexEncodedStringWithOptions:(BMHexEncodeOptions)options separator:(char)separator groupLength:(NSUInteger)groupLength;
+
+///-----------------
+/// @name Checksums
+///-----------------
+
+/** Returns the checksum of the receivers bytes using the given algorithm.
+ 
+ Checksums are much faster than message digests, but are not suitable for cryptographic purposes.
+ 
+ @param algorithm The checksum algorithm.
+ @return The checksum of the receivers bytes, or 0 if *algorithm* is invalid. As 0 is also a valid checksum, use `BMChecksumCompute` to tell an invalid algorithm apart.
+ @see BMChecksum
+ */
+- (uint64_t)checksumUsingAlgorithm:(BMChecksumAlgorithm)algorithm;
+
+/** Computes the checksums of several ranges of the receivers bytes.
+ 
+ Raises an `NSRangeException` if any of the *ranges* exceeds the receivers length.
+ 
+ @param checksums The buffer that receives the checksums in the order of *ranges*. It must hold at least *count* elements.
+ @param ranges A C array of byte ranges within the receiver.
+ @param count The number of ranges in the *ranges* array.
+ @param algorithm The checksum algorithm.
+ @return `YES` if the checksums were stored in *checksums*, `NO` if *algorithm* is invalid.
+ @see checksumUsingAlgorithm:
+ */
+- (BOOL)getChecksums:(uint64_t *)checksums ofRanges:(const NSRange *)ranges count:(NSUInteger)count usingAlgorithm:(BMChecksumAlgorithm)algorithm;
+
+/** Returns the CRC-32C checksum of the receivers bytes.
+ 
+ @return The CRC-32C checksum of the receivers bytes.
+ @see checksumUsingAlgorithm:
+ */
+- (uint32_t)CRC32C;
+
+/** Returns the xxHash64 checksum of the receivers bytes.
+ 
+ @return The xxHash64 checksum of the receivers bytes.
+ @see checksumUsingAlgorithm:
+ */
+- (uint64_t)XXH64;
+
+/** Returns the XXH3 checksum of the receivers bytes.
+ 
+ @return The XXH3 checksum of the receivers bytes.
+ @see checksumUsingAlgorithm:
+ */
+- (uint64_t)XXH3;
+
 ///-----------------------
 /// @name Message Digests
 ///-----------------------
 
+/** Returns the message digest of the receivers bytes using the given algorithm.
+ 
+ @param algorithm The message digest algorithm.
+ @return The message digest of the receivers bytes, or `nil` if *algorithm* is invalid.
+ @see BMDigest
+ */
+- (NSData *)digestUsingAlgorithm:(BMDigestAlgorithm)algorithm;
+
+/** Returns the message digests of the receivers bytes for several algorithms, computed in a single pass over the receivers bytes.
+ 
+ For large receivers this is faster than computing the message digests one after another whenever the digests are computed faster than memory delivers the bytes, because every byte is loaded from memory only once.
+ 
+ @param algorithms A C array of message digest algorithms.
+ @param count The number of algorithms in the *algorithms* array.
+ @return An array with the message digests, in the order of *algorithms*, an empty array if *count* is 0, or `nil` if any of the *algorithms* is invalid.
+ @see digestUsingAlgorithm:
+ */
+- (NSArray *)digestsUsingAlgorithms:(const BMDigestAlgorithm *)algorithms count:(NSUInteger)count;
+
+/** Returns the root digest of the digest tree of the receivers bytes using the given algorithm.
+ 
+ The receivers bytes are split into chunks of `BMDigestTreeChunkLength` bytes, which are hashed in parallel, and the resulting leaf digests are combined into a Merkle tree. The root digest differs from the plain message digest returned by digestUsingAlgorithm:, see `BMDigestTreeChunkLength` for the exact construction. The leaf digests can be used to verify individual chunks of the receiver with `BMDigestComputeTreeLeaf`.
+ 
+ @param algorithm The message digest algorithm.
+ @param leafDigests Upon return, an array with the leaf digests in chunk order. Pass `NULL` if you do not need the leaf digests.
+ @return The root digest of the digest tree, or `nil` if *algorithm* is invalid.
+ @see digestUsingAlgorithm:
+ */
+- (NSData *)treeDigestUsingAlgorithm:(BMDigestAlgorithm)algorithm leafDigests:(NSArray **)leafDigests;
+
+/** Computes the message digest of the receivers bytes into a buffer, without allocating any objects.
+ 
+ @param buffer The buffer that receives the message digest. It must hold at least `BMDigestGetLength(algorithm)` bytes.
+ @param algorithm The message digest algorithm.
+ @return `YES` if the message digest was stored in *buffer*, `NO` if *algorithm* is invalid.
+ @see getDigestHexString:usingAlgorithm:
+ @see digestUsingAlgorithm:
+ */
+- (BOOL)getDigest:(void *)buffer usingAlgorithm:(BMDigestAlgorithm)algorithm;
+
+/** Computes the lowercase hex string of the message digest of the receivers bytes into a buffer, without allocating any objects.
+ 
+ @param buffer The buffer that receives the NUL-terminated hex string. It must hold at least `BMDigestMaxHexLength` characters.
+ @param algorithm The message digest algorithm.
+ @return `YES` if the hex string was stored in *buffer*, `NO` if *algorithm* is invalid.
+ @see getDigest:usingAlgorithm:
+ */
+- (BOOL)getDigestHexString:(char *)buffer usingAlgorithm:(BMDigestAlgorithm)algorithm;
+
+/** Computes the message digests of several ranges of the receivers bytes into a buffer.
+ 
+ The message digests are packed contiguously in the order of *ranges*, so the message digest of `ranges[i]` starts at byte `i * BMDigestGetLength(algorithm)` of *buffer*. Raises an `NSRangeException` if any of the *ranges* exceeds the receivers length.
+ 
+ @param buffer The buffer that receives the message digests. It must hold at least `count * BMDigestGetLength(algorithm)` bytes.
+ @param ranges A C array of byte ranges within the receiver.
+ @param count The number of ranges in the *ranges* array.
+ @param algorithm The message digest algorithm.
+ @return `YES` if the message digests were stored in *buffer*, `NO` if *algorithm* is invalid.
+ @see getDigest:usingAlgorithm:
+ */
+- (BOOL)getDigests:(void *)buffer ofRanges:(const NSRange *)ranges count:(NSUInteger)count usingAlgorithm:(BMDigestAlgorithm)algorithm;
+
+/** Returns the HMAC (RFC 2104) of the receivers bytes using the given algorithm and key.
+ 
+ Use a `BMHMAC` object instead to authenticate many messages under the same key, which computes the key schedule only once.
+ 
+ @param algorithm The message digest algorithm.
+ @param key The secret key.
+ @return The HMAC of the receivers bytes, or `nil` if *algorithm* is invalid.
+ @see BMHMAC
+ */
+- (NSData *)HMACUsingAlgorithm:(BMDigestAlgorithm)algorithm key:(NSData *)key;
+
 /** Returns the MD2 message digest of the receivers bytes.
  
  @return The MD2 message digest of the receivers bytes.
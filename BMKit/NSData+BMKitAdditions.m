@@ -25,7 +25,10 @@
  * SUCH DAMAGE.
  */
 
-#include <CommonCrypto/CommonDigest.h>
+#include "BMBase64.h"
+#include "BMChecksumUtilities.h"
+#include "BMDigestUtilities.h"
+#include "BMHex.h"
 
 #import "NSData+BMKitAdditions.h"
 
@@ -37,29 +40,6 @@
 #pragma mark Base64 Encoding
 
 
-static const uint8_t NSDataBase64DecodingTable[256] =
-{
-	65, 65, 65, 65, 65, 65, 65, 65, 65, 64, 64, 65, 64, 64, 65, 65,
-	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
-	64, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 62, 65, 65, 65, 63,
-	52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 65, 65, 65, 65, 65, 65,
-	65,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
-	15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 65, 65, 65, 65, 65,
-	65, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
-	41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 65, 65, 65, 65, 65,
-	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
-	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
-	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
-	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
-	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
-	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
-	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
-	65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65
-};
-
-static const char NSDataBase64EncodingTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-
-
 + (NSData *)dataWithBase64EncodedString:(NSString *)aString
 {
     return [[[self alloc] initWithBase64EncodedString:aString] autorelease];
@@ -68,71 +48,46 @@ static const char NSDataBase64EncodingTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcde
 
 - (id)initWithBase64EncodedString:(NSString *)aString
 {
-    const char *str = [aString cStringUsingEncoding:NSASCIIStringEncoding];
-	NSUInteger strLength = strlen(str);
-	unsigned c, i = 0, j = 0, k;
-	uint8_t *data = (uint8_t *)malloc(strLength);
+    NSUInteger strLength = [aString length];
+    size_t dataLength = 0;
+    uint8_t *data = (uint8_t *)malloc(BMBase64DecodeUpdateMaxLength(strLength) + 1);
     if (data) {
-        while (((c = *str++) != '\0') && strLength-- != 0) {
-            if (c == '=') {
-                if (*str != '=' && ((i % 4) == 1)) {
-                invalid:
-                    free(data), data = NULL;
-                    break;
-                }
+        // Convert and decode the string in small windows, so we
+        // never need an ASCII copy of the complete string
+        BMBase64DecodeState state;
+        BMBase64DecodeInit(&state);
+        char str[4096];
+        NSRange range = NSMakeRange(0, strLength);
+        while (range.length) {
+            NSUInteger usedLength = 0;
+            size_t decodedLength = 0;
+            [aString getBytes:str
+                    maxLength:sizeof(str)
+                   usedLength:&usedLength
+                     encoding:NSASCIIStringEncoding
+                      options:0
+                        range:range
+               remainingRange:&range];
+            
+            // Decoding stops at the first NUL character, like it does for C strings
+            const char *nul = (const char *)memchr(str, '\0', usedLength);
+            if (!usedLength || !BMBase64DecodeUpdate(&state, str, nul ? (NSUInteger)(nul - str) : usedLength, data + dataLength, &decodedLength)) {
+                free(data), data = NULL;
+                break;
             }
-            else {
-                c = NSDataBase64DecodingTable[c];
-                if (c != 64) { // 64 identifies whitespace, just skip
-                    if (c == 65) { // 65 identifies an invalid character
-                        goto invalid;
-                    }
-                    switch (i % 4) {
-                        case 0:
-                            data[j] = c << 2;
-                            break;
-                            
-                        case 1:
-                            data[j++] |= c >> 4;
-                            data[j] = (c & 0x0f) << 4;
-                            break;
-                            
-                        case 2:
-                            data[j++] |= c >>2;
-                            data[j] = (c & 0x03) << 6;
-                            break;
-                            
-                        case 3:
-                            data[j++] |= c;
-                            break;
-                    }
-                    i++;
-                }
-            }
-        }
-        k = j;
-        if (c == '=') {
-            switch (i % 4) {
-                case 1:
-                    goto invalid;
-                    
-                case 2:
-                    k++;
-                    // FALL-THROUGH
-                case 3:
-                    data[k] = 0;
-                    break;
+            dataLength += decodedLength;
+            if (nul) {
+                break;
             }
         }
     }
     if (data) {
-        self = [self initWithBytes:data length:j];
+        self = [self initWithBytesNoCopy:data length:dataLength freeWhenDone:YES];
     }
     else {
         [self release];
         self = nil;
     }
-    free(data);
     return self;
 }
 
@@ -140,32 +95,13 @@ static const char NSDataBase64EncodingTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcde
 - (NSString *)base64EncodedString
 {
     NSString *base64EncodedString = nil;
-	NSUInteger dataLength = [self length];
-    const uint8_t *data = [self bytes];
+    NSUInteger dataLength = [self length];
     if (dataLength) {
-        char *buffer = (char *)malloc(((dataLength + 2) / 3) * 4);
-        char *bufptr = buffer;
+        char *buffer = (char *)malloc(BMBase64EncodedLength(dataLength));
         if (buffer) {
-            for (; dataLength > 2; data += 3, dataLength -= 3) {
-                *bufptr++ = NSDataBase64EncodingTable[data[0] >> 2];
-                *bufptr++ = NSDataBase64EncodingTable[((data[0] & 0x03) << 4) | (data[1] >> 4)];
-                *bufptr++ = NSDataBase64EncodingTable[((data[1] & 0x0f) << 2) | (data[2] >> 6)];
-                *bufptr++ = NSDataBase64EncodingTable[data[2] & 0x3f];
-            }
-            if (dataLength) {
-                *bufptr++ = NSDataBase64EncodingTable[data[0] >> 2];
-                if (dataLength > 1) {
-                    *bufptr++ = NSDataBase64EncodingTable[((data[0] & 0x03) << 4) | (data[1] >> 4)];
-                    *bufptr++ = NSDataBase64EncodingTable[(data[1] & 0x0f) << 2];
-                }
-                else {
-                    *bufptr++ = NSDataBase64EncodingTable[(data[0] & 0x03) << 4];
-                    *bufptr++ = '=';
-                }
-                *bufptr++ = '=';
-            }
+            size_t bufferLength = BMBase64Encode([self bytes], dataLength, buffer);
             base64EncodedString = [[NSString alloc] initWithBytesNoCopy:buffer
-                                                                 length:(bufptr - buffer)
+                                                                 length:bufferLength
                                                                encoding:NSASCIIStringEncoding
                                                            freeWhenDone:YES];
             if (!base64EncodedString) {
@@ -180,141 +116,344 @@ static const char NSDataBase64EncodingTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcde
 }
 
 
+#pragma mark -
+#pragma mark Hex Encoding
+
+
++ (NSData *)dataWithHexEncodedString:(NSString *)aString
+{
+    return [[[self alloc] initWithHexEncodedString:aString] autorelease];
+}
+
+
+- (id)initWithHexEncodedString:(NSString *)aString
+{
+    NSUInteger strLength = [aString length];
+    size_t dataLength = 0;
+    uint8_t *data = (uint8_t *)malloc(BMHexDecodeUpdateMaxLength(strLength) + 1);
+    if (data) {
+        // Convert and decode the string in small windows, so we
+        // never need an ASCII copy of the complete string
+        BMHexDecodeState state;
+        BMHexDecodeInit(&state);
+        char str[4096];
+        NSRange range = NSMakeRange(0, strLength);
+        while (range.length) {
+            NSUInteger usedLength = 0;
+            size_t decodedLength = 0;
+            [aString getBytes:str
+                    maxLength:sizeof(str)
+                   usedLength:&usedLength
+                     encoding:NSASCIIStringEncoding
+                      options:0
+                        range:range
+               remainingRange:&range];
+            if (!usedLength || !BMHexDecodeUpdate(&state, str, usedLength, data + dataLength, &decodedLength)) {
+                free(data), data = NULL;
+                break;
+            }
+            dataLength += decodedLength;
+        }
+        if (data && !BMHexDecodeFinal(&state)) {
+            free(data), data = NULL;
+        }
+    }
+    if (data) {
+        self = [self initWithBytesNoCopy:data length:dataLength freeWhenDone:YES];
+    }
+    else {
+        [self release];
+        self = nil;
+    }
+    return self;
+}
+
+
+- (NSString *)hexEncodedString
+{
+    return [self hexEncodedStringWithOptions:BMHexEncodeLowercase separator:'\0' groupLength:0];
+}
+
+
+- (NSString *)hexEncodedStringWithOptions:(BMHexEncodeOptions)options separator:(char)separator groupLength:(NSUInteger)groupLength
+{
+    NSString *hexEncodedString = nil;
+    NSUInteger dataLength = [self length];
+    if (dataLength) {
+        char *buffer = (char *)malloc(BMHexEncodedLength(dataLength, groupLength));
+        if (buffer) {
+            size_t bufferLength = BMHexEncode([self bytes], dataLength, buffer, options, separator, groupLength);
+            hexEncodedString = [[NSString alloc] initWithBytesNoCopy:buffer
+                                                              length:bufferLength
+                                                            encoding:NSASCIIStringEncoding
+                                                        freeWhenDone:YES];
+            if (!hexEncodedString) {
+                free(buffer);
+            }
+        }
+    }
+    else {
+        hexEncodedString = [[NSString alloc] init];
+    }
+    return [hexEncodedString autorelease];
+}
+
+
+#pragma mark -
+#pragma mark Checksums
+
+
+- (uint64_t)checksumUsingAlgorithm:(BMChecksumAlgorithm)algorithm
+{
+    // The checksum stays 0 if the algorithm is invalid
+    uint64_t checksum = 0;
+    BMChecksumCompute(algorithm, 0, [self bytes], [self length], &checksum);
+    return checksum;
+}
+
+
+- (BOOL)getChecksums:(uint64_t *)checksums ofRanges:(const NSRange *)ranges count:(NSUInteger)count usingAlgorithm:(BMChecksumAlgorithm)algorithm
+{
+    if ((unsigned)algorithm >= BMChecksumAlgorithmCount) {
+        return NO;
+    }
+    const UInt8 *bytes = [self bytes];
+    NSUInteger length = [self length];
+    for (NSUInteger i = 0; i < count; ++i) {
+        if (ranges[i].location > length || ranges[i].length > length - ranges[i].location) {
+            [NSException raise:NSRangeException
+                        format:@"range %@ exceeds data length %lu (in '%@')", NSStringFromRange(ranges[i]), (unsigned long)length, NSStringFromSelector(_cmd)];
+        }
+        BMChecksumCompute(algorithm, 0, bytes + ranges[i].location, ranges[i].length, checksums + i);
+    }
+    return YES;
+}
+
+
+- (uint32_t)CRC32C
+{
+    return (uint32_t)[self checksumUsingAlgorithm:BMChecksumAlgorithmCRC32C];
+}
+
+
+- (uint64_t)XXH64
+{
+    return [self checksumUsingAlgorithm:BMChecksumAlgorithmXXH64];
+}
+
+
+- (uint64_t)XXH3
+{
+    return [self checksumUsingAlgorithm:BMChecksumAlgorithmXXH3];
+}
+
+
 #pragma mark -
 #pragma mark Message Digests
 
 
-static const char NSDataDigestStringHexDigits[] = "0123456789abcdef";
+- (NSData *)digestUsingAlgorithm:(BMDigestAlgorithm)algorithm
+{
+    NSData *digestData = nil;
+    UInt8 digest[BMDigestMaxLength];
+    if (BMDigestCompute(algorithm, [self bytes], [self length], digest)) {
+        digestData = [NSData dataWithBytes:digest length:BMDigestGetLength(algorithm)];
+    }
+    return digestData;
+}
 
 
-static NSString *NSDataDigestString(NSData *digestData)
+- (NSArray *)digestsUsingAlgorithms:(const BMDigestAlgorithm *)algorithms count:(NSUInteger)count
 {
-    NSString *digestString = nil;
-    if (digestData) {
-        unsigned digestLength = [digestData length];
-        const UInt8 *digest = [digestData bytes];
-        char str[digestLength * 2];
-        for (unsigned n = 0; n < digestLength; ++n) {
-            str[2 * n]     = NSDataDigestStringHexDigits[digest[n] >> 4];
-            str[2 * n + 1] = NSDataDigestStringHexDigits[digest[n] & 0xf];
+    if (!count) {
+        // malloc(0) may return NULL, which is not out of memory
+        return [NSArray array];
+    }
+    NSArray *digestsArray = nil;
+    UInt8 *digests = (UInt8 *)malloc(count * BMDigestMaxLength);
+    void **pointers = (void **)malloc(count * sizeof(void *));
+    id *objects = (id *)malloc(count * sizeof(id));
+    if (digests && pointers && objects) {
+        for (NSUInteger i = 0; i < count; ++i) {
+            pointers[i] = digests + i * BMDigestMaxLength;
         }
-        digestString = [[NSString alloc] initWithBytes:str
-                                                length:(digestLength * 2)
-                                              encoding:NSASCIIStringEncoding];
+        if (BMDigestComputeMultiple(algorithms, count, [self bytes], [self length], pointers)) {
+            for (NSUInteger i = 0; i < count; ++i) {
+                objects[i] = [NSData dataWithBytes:pointers[i] length:BMDigestGetLength(algorithms[i])];
+            }
+            digestsArray = [NSArray arrayWithObjects:objects count:count];
+        }
+    }
+    free(objects);
+    free(pointers);
+    free(digests);
+    return digestsArray;
+}
+
+
+- (NSData *)treeDigestUsingAlgorithm:(BMDigestAlgorithm)algorithm leafDigests:(NSArray **)leafDigests
+{
+    NSData *rootDigest = nil;
+    size_t digestLength = BMDigestGetLength(algorithm);
+    if (digestLength) {
+        size_t leafCount = BMDigestTreeGetLeafCount([self length]);
+        UInt8 *leaves = leafDigests ? (UInt8 *)malloc(leafCount * digestLength) : NULL;
+        id *objects = leafDigests ? (id *)malloc(leafCount * sizeof(id)) : NULL;
+        if (!leafDigests || (leaves && objects)) {
+            UInt8 root[BMDigestMaxLength];
+            if (BMDigestComputeTree(algorithm, [self bytes], [self length], root, leaves)) {
+                rootDigest = [NSData dataWithBytes:root length:digestLength];
+                if (leafDigests) {
+                    for (size_t i = 0; i < leafCount; ++i) {
+                        objects[i] = [NSData dataWithBytes:leaves + i * digestLength length:digestLength];
+                    }
+                    *leafDigests = [NSArray arrayWithObjects:objects count:leafCount];
+                }
+            }
+        }
+        free(objects);
+        free(leaves);
+    }
+    return rootDigest;
+}
+
+
+- (BOOL)getDigest:(void *)buffer usingAlgorithm:(BMDigestAlgorithm)algorithm
+{
+    return BMDigestCompute(algorithm, [self bytes], [self length], buffer);
+}
+
+
+- (BOOL)getDigestHexString:(char *)buffer usingAlgorithm:(BMDigestAlgorithm)algorithm
+{
+    return BMDigestComputeHex(algorithm, [self bytes], [self length], buffer, BMHexEncodeLowercase);
+}
+
+
+- (BOOL)getDigests:(void *)buffer ofRanges:(const NSRange *)ranges count:(NSUInteger)count usingAlgorithm:(BMDigestAlgorithm)algorithm
+{
+    size_t digestLength = BMDigestGetLength(algorithm);
+    if (!digestLength) {
+        return NO;
+    }
+    const UInt8 *bytes = [self bytes];
+    NSUInteger length = [self length];
+    UInt8 *digest = (UInt8 *)buffer;
+    for (NSUInteger i = 0; i < count; ++i, digest += digestLength) {
+        if (ranges[i].location > length || ranges[i].length > length - ranges[i].location) {
+            [NSException raise:NSRangeException
+                        format:@"range %@ exceeds data length %lu (in '%@')", NSStringFromRange(ranges[i]), (unsigned long)length, NSStringFromSelector(_cmd)];
+        }
+        BMDigestCompute(algorithm, bytes + ranges[i].location, ranges[i].length, digest);
+    }
+    return YES;
+}
+
+
+- (NSData *)HMACUsingAlgorithm:(BMDigestAlgorithm)algorithm key:(NSData *)key
+{
+    NSData *HMACData = nil;
+    UInt8 mac[BMDigestMaxLength];
+    if (BMHMACCompute(algorithm, [key bytes], [key length], [self bytes], [self length], mac)) {
+        HMACData = [NSData dataWithBytes:mac length:BMDigestGetLength(algorithm)];
     }
-    return [digestString autorelease];
+    return HMACData;
 }
 
 
 - (NSData *)MD2
 {
-    UInt8 digest[CC_MD2_DIGEST_LENGTH];
-    CC_MD2([self bytes], [self length], digest);
-    return [NSData dataWithBytes:digest length:sizeof(digest)];
+    return [self digestUsingAlgorithm:BMDigestAlgorithmMD2];
 }
 
 
 - (NSString *)MD2String
 {
-    return NSDataDigestString([self MD2]);
+    return [[self MD2] hexEncodedString];
 }
 
 
 - (NSData *)MD4
 {
-    UInt8 digest[CC_MD4_DIGEST_LENGTH];
-    CC_MD4([self bytes], [self length], digest);
-    return [NSData dataWithBytes:digest length:sizeof(digest)];
+    return [self digestUsingAlgorithm:BMDigestAlgorithmMD4];
 }
 
 
 - (NSString *)MD4String
 {
-    return NSDataDigestString([self MD4]);
+    return [[self MD4] hexEncodedString];
 }
 
 
 - (NSData *)MD5
 {
-    UInt8 digest[CC_MD5_DIGEST_LENGTH];
-    CC_MD5([self bytes], [self length], digest);
-    return [NSData dataWithBytes:digest length:sizeof(digest)];
+    return [self digestUsingAlgorithm:BMDigestAlgorithmMD5];
 }
 
 
 - (NSString *)MD5String
 {
-    return NSDataDigestString([self MD5]);
+    return [[self MD5] hexEncodedString];
 }
 
 
 - (NSData *)SHA1
 {
-    UInt8 digest[CC_SHA1_DIGEST_LENGTH];
-    CC_SHA1([self bytes], [self length], digest);
-    return [NSData dataWithBytes:digest length:sizeof(digest)];
+    return [self digestUsingAlgorithm:BMDigestAlgorithmSHA1];
 }
 
 
 - (NSString *)SHA1String
 {
-    return NSDataDigestString([self SHA1]);
+    return [[self SHA1] hexEncodedString];
 }
 
 
 - (NSData *)SHA224
 {
-    UInt8 digest[CC_SHA224_DIGEST_LENGTH];
-    CC_SHA224([self bytes], [self length], digest);
-    return [NSData dataWithBytes:digest length:sizeof(digest)];
+    return [self digestUsingAlgorithm:BMDigestAlgorithmSHA224];
 }
 
 
 - (NSString *)SHA224String
 {
-    return NSDataDigestString([self SHA224]);
+    return [[self SHA224] hexEncodedString];
 }
 
 
 - (NSData *)SHA256
 {
-    UInt8 digest[CC_SHA256_DIGEST_LENGTH];
-    CC_SHA256([self bytes], [self length], digest);
-    return [NSData dataWithBytes:digest length:sizeof(digest)];
+    return [self digestUsingAlgorithm:BMDigestAlgorithmSHA256];
 }
 
 
 - (NSString *)SHA256String
 {
-    return NSDataDigestString([self SHA256]);
+    return [[self SHA256] hexEncodedString];
 }
 
 
 - (NSData *)SHA384
 {
-    UInt8 digest[CC_SHA384_DIGEST_LENGTH];
-    CC_SHA384([self bytes], [self length], digest);
-    return [NSData dataWithBytes:digest length:sizeof(digest)];
+    return [self digestUsingAlgorithm:BMDigestAlgorithmSHA384];
 }
 
 
 - (NSString *)SHA384String
 {
-    return NSDataDigestString([self SHA384]);
+    return [[self SHA384] hexEncodedString];
 }
 
 
 - (NSData *)SHA512
 {
-    UInt8 digest[CC_SHA512_DIGEST_LENGTH];
-    CC_SHA512([self bytes], [self length], digest);
-    return [NSData dataWithBytes:digest length:sizeof(digest)];
+    return [self digestUsingAlgorithm:BMDigestAlgorithmSHA512];
 }
 
 
 - (NSString *)SHA512String
 {
-    return NSDataDigestString([self SHA512]);
+    return [[self SHA512] hexEncodedString];
 }
 
 
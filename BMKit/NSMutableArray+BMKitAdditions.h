@@ -47,6 +47,8 @@
 
 /** Evaluates a given predicate block against the array’s content and leaves only objects for which the predicate block returns true.
  
+ The predicate block is invoked directly, not through an `NSPredicate`. The objects are fetched into a buffer, the remaining objects are compacted in place, and everything from the first removed object on is replaced at once.
+ 
  @param predicateBlock The predicate block to evaluate against the array's elements.
  */
 - (void)filterUsingPredicateBlock:(BMPredicateBlock)predicateBlock;
@@ -57,8 +59,27 @@
 
 /** Invokes the transformator on each object in the receiving array and replaces the elements with the objects returned from the transformator.
  
+ The objects are fetched with a single `getObjects:range:`, transformed in a buffer, and put back with a single `replaceObjectsInRange:withObjects:count:`, so the array storage is only touched twice. As with `transformedArrayUsingTransformator:`, `nil` results are replaced by `NSNull`.
+ 
  @param aTransformator The transformator to invoke on the receiving array's elements.
  */
 - (void)transformUsingTransformator:(BMTransformator)aTransformator;
 
+/** Invokes the transformator on each object in the receiving array concurrently and replaces the elements with the objects returned from the transformator.
+ 
+ The objects are split into chunks of about the same size, a few per processor core. See `concurrentlyTransformUsingTransformator:grainSize:` for details.
+ 
+ @param aTransformator The transformator to invoke on the receiving array's elements. The transformator is invoked concurrently from several threads, in no particular order.
+ */
+- (void)concurrentlyTransformUsingTransformator:(BMTransformator)aTransformator;
+
+/** Invokes the transformator on each object in the receiving array concurrently and replaces the elements with the objects returned from the transformator.
+ 
+ Like `transformUsingTransformator:`, but the buffer is split into chunks of *grainSize* objects, which are transformed in parallel before the elements are replaced at once. The receiving array must not be accessed from other threads meanwhile.
+ 
+ @param aTransformator The transformator to invoke on the receiving array's elements. The transformator is invoked concurrently from several threads, in no particular order.
+ @param grainSize The number of objects per chunk, or 0 to split the objects into a few chunks per processor core.
+ */
+- (void)concurrentlyTransformUsingTransformator:(BMTransformator)aTransformator grainSize:(NSUInteger)grainSize;
+
 @end
@@ -26,6 +26,7 @@
  */
 
 #import "NSMutableArray+BMKitAdditions.h"
+#import "BMCollectionUtilities.h"
 
 
 @implementation NSMutableArray (BMKitAdditions)
@@ -47,7 +48,39 @@
 
 - (void)filterUsingPredicateBlock:(BMPredicateBlock)predicateBlock
 {
-    [self filterUsingPredicate:[NSPredicate predicateWithBlock:(BOOL(^)(id, NSDictionary *))predicateBlock]];
+    if (predicateBlock) {
+        id stackObjects[64];
+        NSUInteger i, j, numberOfObjects = [self count];
+        id *objects = (numberOfObjects <= sizeof(stackObjects) / sizeof(stackObjects[0])) ? stackObjects : (id *)malloc(numberOfObjects * sizeof(id));
+        if (objects) {
+            [self getObjects:objects range:NSMakeRange(0, numberOfObjects)];
+            
+            // The objects in front of the first removed object stay where they are
+            for (i = 0; i < numberOfObjects && predicateBlock(objects[i]); ++i)
+                ;
+            if (i < numberOfObjects) {
+                // The remaining objects behind it are moved up, and retained
+                // since the range they are in is replaced
+                NSUInteger first = i;
+                for (j = first, ++i; i < numberOfObjects; ++i) {
+                    id object = objects[i];
+                    if (predicateBlock(object)) {
+                        objects[j++] = [object retain];
+                    }
+                }
+                [self replaceObjectsInRange:NSMakeRange(first, numberOfObjects - first) withObjects:objects + first count:j - first];
+                for (i = first; i < j; ++i) {
+                    [objects[i] release];
+                }
+            }
+            if (objects != stackObjects) {
+                free(objects);
+            }
+        }
+        else {
+            [self filterUsingPredicate:[NSPredicate predicateWithBlock:(BOOL(^)(id, NSDictionary *))predicateBlock]];
+        }
+    }
 }
 
 
@@ -59,9 +92,53 @@
 {
     if (aTransformator) {
         NSUInteger i, numberOfObjects = [self count];
-        for (i = 0; i < numberOfObjects; ++i) {
-            id object = aTransformator([self objectAtIndex:i]) ?: [NSNull null];
-            [self replaceObjectAtIndex:i withObject:object];
+        id *objects = (id *)malloc((numberOfObjects + 1) * sizeof(id));
+        if (objects) {
+            [self getObjects:objects range:NSMakeRange(0, numberOfObjects)];
+            
+            // The transformed objects may only be owned by the objects they replace,
+            // so they are retained until the replacement is done
+            for (i = 0; i < numberOfObjects; ++i) {
+                objects[i] = [(aTransformator(objects[i]) ?: [NSNull null]) retain];
+            }
+            [self replaceObjectsInRange:NSMakeRange(0, numberOfObjects) withObjects:objects count:numberOfObjects];
+            for (i = 0; i < numberOfObjects; ++i) {
+                [objects[i] release];
+            }
+            free(objects);
+        }
+        else {
+            for (i = 0; i < numberOfObjects; ++i) {
+                id object = aTransformator([self objectAtIndex:i]) ?: [NSNull null];
+                [self replaceObjectAtIndex:i withObject:object];
+            }
+        }
+    }
+}
+
+
+- (void)concurrentlyTransformUsingTransformator:(BMTransformator)aTransformator
+{
+    [self concurrentlyTransformUsingTransformator:aTransformator grainSize:0];
+}
+
+
+- (void)concurrentlyTransformUsingTransformator:(BMTransformator)aTransformator grainSize:(NSUInteger)grainSize
+{
+    if (aTransformator) {
+        NSUInteger numberOfObjects = [self count];
+        id *objects = (id *)malloc((numberOfObjects + 1) * sizeof(id));
+        if (objects) {
+            [self getObjects:objects range:NSMakeRange(0, numberOfObjects)];
+            BMCollectionTransformObjects(objects, numberOfObjects, grainSize, aTransformator);
+            [self replaceObjectsInRange:NSMakeRange(0, numberOfObjects) withObjects:objects count:numberOfObjects];
+            for (NSUInteger i = 0; i < numberOfObjects; ++i) {
+                [objects[i] release];
+            }
+            free(objects);
+        }
+        else {
+            [self transformUsingTransformator:aTransformator];
         }
     }
 }
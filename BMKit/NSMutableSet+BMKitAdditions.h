@@ -37,8 +37,27 @@
 
 /** Evaluates a given predicate block against the set’s content and removes from the set those objects for which the predicate block returns false.
  
+ The predicate block is invoked directly, not through an `NSPredicate`. The objects to remove are gathered in a buffer while the set is enumerated, and removed afterwards.
+ 
  @param predicateBlock A predicate block.
  */
 - (void)filterUsingPredicateBlock:(BMPredicateBlock)predicateBlock;
 
+/** Evaluates a given predicate block against the set’s content concurrently and removes from the set those objects for which the predicate block returns false.
+ 
+ The objects are split into chunks of about the same size, a few per processor core. See `concurrentlyFilterUsingPredicateBlock:grainSize:` for details.
+ 
+ @param predicateBlock A predicate block. The block is invoked concurrently from several threads, in no particular order.
+ */
+- (void)concurrentlyFilterUsingPredicateBlock:(BMPredicateBlock)predicateBlock;
+
+/** Evaluates a given predicate block against the set’s content concurrently and removes from the set those objects for which the predicate block returns false.
+ 
+ The objects are evaluated in chunks in parallel like in `concurrentlyFilteredSetUsingPredicateBlock:grainSize:`, and the objects to remove are then removed at once. The receiving set must not be accessed from other threads meanwhile.
+ 
+ @param predicateBlock A predicate block. The block is invoked concurrently from several threads, in no particular order.
+ @param grainSize The number of objects per chunk, or 0 to split the objects into a few chunks per processor core.
+ */
+- (void)concurrentlyFilterUsingPredicateBlock:(BMPredicateBlock)predicateBlock grainSize:(NSUInteger)grainSize;
+
 @end
@@ -26,6 +26,7 @@
  */
 
 #import "NSMutableSet+BMKitAdditions.h"
+#import "NSSet+BMKitAdditions.h"
 
 
 @implementation NSMutableSet (BMKitAdditions)
@@ -37,7 +38,50 @@
 
 - (void)filterUsingPredicateBlock:(BMPredicateBlock)predicateBlock
 {
-    [self filterUsingPredicate:[NSPredicate predicateWithBlock:(BOOL(^)(id, NSDictionary *))predicateBlock]];
+    if (predicateBlock) {
+        id stackObjects[64];
+        NSUInteger numberOfObjects = [self count];
+        id *objects = (numberOfObjects <= sizeof(stackObjects) / sizeof(stackObjects[0])) ? stackObjects : (id *)malloc(numberOfObjects * sizeof(id));
+        if (objects) {
+            NSUInteger i, j = 0;
+            for (id object in self) {
+                if (!predicateBlock(object)) {
+                    objects[j++] = object;
+                }
+            }
+            for (i = 0; i < j; ++i) {
+                [self removeObject:objects[i]];
+            }
+            if (objects != stackObjects) {
+                free(objects);
+            }
+        }
+        else {
+            [self filterUsingPredicate:[NSPredicate predicateWithBlock:(BOOL(^)(id, NSDictionary *))predicateBlock]];
+        }
+    }
+}
+
+
+- (void)concurrentlyFilterUsingPredicateBlock:(BMPredicateBlock)predicateBlock
+{
+    [self concurrentlyFilterUsingPredicateBlock:predicateBlock grainSize:0];
+}
+
+
+- (void)concurrentlyFilterUsingPredicateBlock:(BMPredicateBlock)predicateBlock grainSize:(NSUInteger)grainSize
+{
+    if (predicateBlock) {
+        NSSet *rejectedSet = [self concurrentlyFilteredSetUsingPredicateBlock:^BOOL(id object) {
+            return !predicateBlock(object);
+        } grainSize:grainSize];
+        if (rejectedSet) {
+            [self minusSet:rejectedSet];
+        }
+        else {
+            [self filterUsingPredicateBlock:predicateBlock];
+        }
+    }
 }
 
 
@@ -37,11 +37,32 @@
 
 /** Evaluates a given predicate block against each object in the receiving set and returns a new set containing the objects for which the predicate block returns true.
  
+ The predicate block is invoked directly, not through an `NSPredicate`, and the matching objects are gathered in a buffer, from which the new set is created at once.
+ 
  @param predicateBlock A predicate block.
  @return A new set containing the objects in the receiving set for which *predicateBlock* returns true.
  */
 - (NSSet *)filteredSetUsingPredicateBlock:(BMPredicateBlock)predicateBlock;
 
+/** Evaluates a given predicate block against each object in the receiving set concurrently and returns a new set containing the objects for which the predicate block returns true.
+ 
+ The objects are split into chunks of about the same size, a few per processor core. See `concurrentlyFilteredSetUsingPredicateBlock:grainSize:` for details.
+ 
+ @param predicateBlock A predicate block. The block is invoked concurrently from several threads, in no particular order.
+ @return A new set containing the objects in the receiving set for which *predicateBlock* returns true.
+ */
+- (NSSet *)concurrentlyFilteredSetUsingPredicateBlock:(BMPredicateBlock)predicateBlock;
+
+/** Evaluates a given predicate block against each object in the receiving set concurrently and returns a new set containing the objects for which the predicate block returns true.
+ 
+ The objects are copied into a buffer and split into chunks of *grainSize* objects, which are filtered in parallel like in `concurrentlyFilteredArrayUsingPredicateBlock:grainSize:`. This only pays off for large sets or expensive predicate blocks.
+ 
+ @param predicateBlock A predicate block. The block is invoked concurrently from several threads, in no particular order.
+ @param grainSize The number of objects per chunk, or 0 to split the objects into a few chunks per processor core.
+ @return A new set containing the objects in the receiving set for which *predicateBlock* returns true.
+ */
+- (NSSet *)concurrentlyFilteredSetUsingPredicateBlock:(BMPredicateBlock)predicateBlock grainSize:(NSUInteger)grainSize;
+
 /** Performs a block on each object in the set.
  
  This method raises `NSInvalidArgumentException` if *aBlock* is `nil`.
@@ -26,6 +26,7 @@
  */
 
 #import "NSSet+BMKitAdditions.h"
+#import "BMCollectionUtilities.h"
 
 
 @implementation NSSet (BMKitAdditions)
@@ -37,7 +38,53 @@
 
 - (NSSet *)filteredSetUsingPredicateBlock:(BMPredicateBlock)predicateBlock
 {
-    return [self filteredSetUsingPredicate:[NSPredicate predicateWithBlock:(BOOL(^)(id, NSDictionary *))predicateBlock]];
+    NSSet *filteredSet = nil;
+    if (predicateBlock) {
+        id stackObjects[64];
+        NSUInteger numberOfObjects = [self count];
+        id *objects = (numberOfObjects <= sizeof(stackObjects) / sizeof(stackObjects[0])) ? stackObjects : (id *)malloc(numberOfObjects * sizeof(id));
+        if (objects) {
+            NSUInteger j = 0;
+            for (id object in self) {
+                if (predicateBlock(object)) {
+                    objects[j++] = object;
+                }
+            }
+            filteredSet = [NSSet setWithObjects:objects count:j];
+            if (objects != stackObjects) {
+                free(objects);
+            }
+        }
+    }
+    return filteredSet;
+}
+
+
+- (NSSet *)concurrentlyFilteredSetUsingPredicateBlock:(BMPredicateBlock)predicateBlock
+{
+    return [self concurrentlyFilteredSetUsingPredicateBlock:predicateBlock grainSize:0];
+}
+
+
+- (NSSet *)concurrentlyFilteredSetUsingPredicateBlock:(BMPredicateBlock)predicateBlock grainSize:(NSUInteger)grainSize
+{
+    NSSet *filteredSet = nil;
+    if (predicateBlock) {
+        NSUInteger numberOfObjects = [self count];
+        id *objects = (id *)malloc((numberOfObjects + 1) * sizeof(id));
+        if (objects) {
+            NSUInteger i = 0;
+            for (id object in self) {
+                objects[i++] = object;
+            }
+            NSUInteger numberOfMatches = BMCollectionFilterObjects(objects, i, grainSize, predicateBlock);
+            if (numberOfMatches != NSNotFound) {
+                filteredSet = [NSSet setWithObjects:objects count:numberOfMatches];
+            }
+            free(objects);
+        }
+    }
+    return filteredSet;
 }
 
 
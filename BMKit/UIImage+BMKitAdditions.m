@@ -35,9 +35,9 @@ BMImageOrientation BMImageOrientationFromUIImageOrientation(UIImageOrientation i
         case UIImageOrientationUpMirrored:      return BMImageOrientationUpMirrored;
         case UIImageOrientationDown:            return BMImageOrientationDown;
         case UIImageOrientationDownMirrored:    return BMImageOrientationDownMirrored;
-        case UIImageOrientationLeft:            return BMImageOrientationLeft;
+        case UIImageOrientationLeft:            return BMImageOrientationRight;
         case UIImageOrientationLeftMirrored:    return BMImageOrientationLeftMirrored;
-        case UIImageOrientationRight:           return BMImageOrientationRight;
+        case UIImageOrientationRight:           return BMImageOrientationLeft;
         case UIImageOrientationRightMirrored:   return BMImageOrientationRightMirrored;
     }
 }
@@ -50,9 +50,9 @@ UIImageOrientation UIImageOrientationFromBMImageOrientation(BMImageOrientation i
         case BMImageOrientationUpMirrored:      return UIImageOrientationUpMirrored;
         case BMImageOrientationDown:            return UIImageOrientationDown;
         case BMImageOrientationDownMirrored:    return UIImageOrientationDownMirrored;
-        case BMImageOrientationLeft:            return UIImageOrientationLeft;
+        case BMImageOrientationLeft:            return UIImageOrientationRight;
         case BMImageOrientationLeftMirrored:    return UIImageOrientationLeftMirrored;
-        case BMImageOrientationRight:           return UIImageOrientationRight;
+        case BMImageOrientationRight:           return UIImageOrientationLeft;
         case BMImageOrientationRightMirrored:   return UIImageOrientationRightMirrored;
     }
 }
@@ -0,0 +1,156 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Measures the concurrent filter and transform variants of NSArray
+ * (BMKitAdditions) against the serial ones, with a cheap and an expensive
+ * block, and checks that both produce the same arrays. Build and run it
+ * from the top level directory on Mac OS X with
+ *
+ *   cc -O2 -IBMKit -framework Foundation -o array-benchmark Benchmarks/BMArrayBenchmark.m BMKit/NSArray+BMKitAdditions.m BMKit/BMCollectionUtilities.m
+ *   ./array-benchmark
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "NSArray+BMKitAdditions.h"
+#import "BMBenchmark.h"
+
+
+// Stands in for parsing or hashing, which costs about a microsecond per object
+static NSUInteger BMArrayBenchmarkHash(NSUInteger value, NSUInteger rounds)
+{
+    uint64_t x = value + 1;
+    for (NSUInteger i = 0; i < rounds; ++i) {
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+    }
+    return (NSUInteger)x;
+}
+
+
+typedef struct _BMArrayBenchmark {
+    NSArray          *array;
+    NSUInteger        grainSize;
+    BMPredicateBlock  predicateBlock;
+    BMTransformator   transformator;
+    NSArray          *result;
+} BMArrayBenchmark;
+
+
+static void BMArrayBenchmarkFilter(void *context)
+{
+    BMArrayBenchmark *benchmark = (BMArrayBenchmark *)context;
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    [benchmark->result release];
+    benchmark->result = [[benchmark->array filteredArrayUsingPredicateBlock:benchmark->predicateBlock] retain];
+    [pool drain];
+}
+
+
+static void BMArrayBenchmarkConcurrentFilter(void *context)
+{
+    BMArrayBenchmark *benchmark = (BMArrayBenchmark *)context;
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    [benchmark->result release];
+    benchmark->result = [[benchmark->array concurrentlyFilteredArrayUsingPredicateBlock:benchmark->predicateBlock grainSize:benchmark->grainSize] retain];
+    [pool drain];
+}
+
+
+static void BMArrayBenchmarkTransform(void *context)
+{
+    BMArrayBenchmark *benchmark = (BMArrayBenchmark *)context;
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    [benchmark->result release];
+    benchmark->result = [[benchmark->array transformedArrayUsingTransformator:benchmark->transformator] retain];
+    [pool drain];
+}
+
+
+static void BMArrayBenchmarkConcurrentTransform(void *context)
+{
+    BMArrayBenchmark *benchmark = (BMArrayBenchmark *)context;
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    [benchmark->result release];
+    benchmark->result = [[benchmark->array concurrentlyTransformedArrayUsingTransformator:benchmark->transformator grainSize:benchmark->grainSize] retain];
+    [pool drain];
+}
+
+
+// Measures the serial and the concurrent function, checks that they produce
+// the same array, and prints their throughput in millions of objects per second
+static void BMArrayBenchmarkCompare(const char *name, BMArrayBenchmark *benchmark, BMBenchmarkFunction serialFunction, BMBenchmarkFunction concurrentFunction)
+{
+    NSUInteger count = [benchmark->array count];
+    double serialThroughput = BMBenchmarkMeasure(serialFunction, benchmark, count) * 1e3;
+    NSArray *serialResult = [benchmark->result retain];
+    double concurrentThroughput = BMBenchmarkMeasure(concurrentFunction, benchmark, count) * 1e3;
+    BMBenchmarkCheck([serialResult isEqualToArray:benchmark->result], "serial and concurrent results differ");
+    [serialResult release];
+    [benchmark->result release], benchmark->result = nil;
+    printf("%-22s %10lu %14.2f %14.2f %8.2fx\n", name, (unsigned long)count, serialThroughput, concurrentThroughput, concurrentThroughput / serialThroughput);
+}
+
+
+int main(void)
+{
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    static const NSUInteger counts[] = { 10000, 100000, 1000000 };
+    
+    printf("%-22s %10s %14s %14s %9s\n", "Mobj/s", "Objects", "Serial", "Concurrent", "Speedup");
+    for (size_t n = 0; n < sizeof(counts) / sizeof(counts[0]); ++n) {
+        NSMutableArray *array = [[NSMutableArray alloc] initWithCapacity:counts[n]];
+        for (NSUInteger i = 0; i < counts[n]; ++i) {
+            [array addObject:[NSNumber numberWithUnsignedInteger:i]];
+        }
+        
+        BMArrayBenchmark benchmark;
+        memset(&benchmark, 0, sizeof(benchmark));
+        benchmark.array = array;
+        benchmark.predicateBlock = ^BOOL(id anObject) {
+            return ([anObject unsignedIntegerValue] % 3) == 0;
+        };
+        benchmark.transformator = ^id(id anObject) {
+            return [NSNumber numberWithUnsignedInteger:[anObject unsignedIntegerValue] * 3];
+        };
+        BMArrayBenchmarkCompare("filter (cheap)", &benchmark, BMArrayBenchmarkFilter, BMArrayBenchmarkConcurrentFilter);
+        BMArrayBenchmarkCompare("transform (cheap)", &benchmark, BMArrayBenchmarkTransform, BMArrayBenchmarkConcurrentTransform);
+        
+        benchmark.predicateBlock = ^BOOL(id anObject) {
+            return (BMArrayBenchmarkHash([anObject unsignedIntegerValue], 1000) % 3) == 0;
+        };
+        benchmark.transformator = ^id(id anObject) {
+            return [NSNumber numberWithUnsignedInteger:BMArrayBenchmarkHash([anObject unsignedIntegerValue], 1000)];
+        };
+        BMArrayBenchmarkCompare("filter (expensive)", &benchmark, BMArrayBenchmarkFilter, BMArrayBenchmarkConcurrentFilter);
+        BMArrayBenchmarkCompare("transform (expensive)", &benchmark, BMArrayBenchmarkTransform, BMArrayBenchmarkConcurrentTransform);
+        
+        [array release];
+    }
+    [pool drain];
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,204 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Measures the throughput of BMBase64Encode and BMBase64Decode against the
+ * per character table codec that NSData (BMKitAdditions) used before, and
+ * checks that both produce the same output. Build and run it from the
+ * top level directory with
+ *
+ *   cc -O2 -std=gnu99 -IBMKit -o base64-benchmark Benchmarks/BMBase64Benchmark.c BMKit/BMBase64.c -lpthread
+ *   ./base64-benchmark
+ */
+
+#include "BMBase64.h"
+#include "BMBenchmark.h"
+
+
+static const uint8_t BMTableDecodingTable[256] =
+{
+    65, 65, 65, 65, 65, 65, 65, 65, 65, 64, 64, 65, 64, 64, 65, 65,
+    65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+    64, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 62, 65, 65, 65, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 65, 65, 65, 65, 65, 65,
+    65,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 65, 65, 65, 65, 65,
+    65, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 65, 65, 65, 65, 65,
+    65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+    65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+    65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+    65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+    65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+    65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+    65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65,
+    65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65, 65
+};
+
+static const char BMTableEncodingTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+
+// The encoder of -[NSData base64EncodedString] before BMBase64
+static size_t BMTableEncode(const uint8_t *data, size_t length, char *buffer)
+{
+    char *bufptr = buffer;
+    for (; length > 2; data += 3, length -= 3) {
+        *bufptr++ = BMTableEncodingTable[data[0] >> 2];
+        *bufptr++ = BMTableEncodingTable[((data[0] & 0x03) << 4) | (data[1] >> 4)];
+        *bufptr++ = BMTableEncodingTable[((data[1] & 0x0f) << 2) | (data[2] >> 6)];
+        *bufptr++ = BMTableEncodingTable[data[2] & 0x3f];
+    }
+    if (length) {
+        *bufptr++ = BMTableEncodingTable[data[0] >> 2];
+        if (length > 1) {
+            *bufptr++ = BMTableEncodingTable[((data[0] & 0x03) << 4) | (data[1] >> 4)];
+            *bufptr++ = BMTableEncodingTable[(data[1] & 0x0f) << 2];
+        }
+        else {
+            *bufptr++ = BMTableEncodingTable[(data[0] & 0x03) << 4];
+            *bufptr++ = '=';
+        }
+        *bufptr++ = '=';
+    }
+    return bufptr - buffer;
+}
+
+
+// The decoder of -[NSData initWithBase64EncodedString:] before BMBase64,
+// for strings without padding
+static size_t BMTableDecode(const char *str, size_t length, uint8_t *data)
+{
+    size_t i = 0, j = 0;
+    for (; length; --length) {
+        unsigned c = BMTableDecodingTable[(uint8_t)*str++];
+        if (c != 64) {
+            if (c == 65) {
+                return 0;
+            }
+            switch (i % 4) {
+                case 0:
+                    data[j] = c << 2;
+                    break;
+                    
+                case 1:
+                    data[j++] |= c >> 4;
+                    data[j] = (c & 0x0f) << 4;
+                    break;
+                    
+                case 2:
+                    data[j++] |= c >> 2;
+                    data[j] = (c & 0x03) << 6;
+                    break;
+                    
+                case 3:
+                    data[j++] |= c;
+                    break;
+            }
+            i++;
+        }
+    }
+    return j;
+}
+
+
+typedef struct _BMBase64Benchmark {
+    uint8_t *bytes;
+    size_t   length;
+    char    *string;
+    size_t   stringLength;
+    uint8_t *decoded;
+} BMBase64Benchmark;
+
+
+static void BMBase64BenchmarkEncode(void *context)
+{
+    BMBase64Benchmark *benchmark = (BMBase64Benchmark *)context;
+    BMBase64Encode(benchmark->bytes, benchmark->length, benchmark->string);
+}
+
+
+static void BMBase64BenchmarkEncodeTable(void *context)
+{
+    BMBase64Benchmark *benchmark = (BMBase64Benchmark *)context;
+    BMTableEncode(benchmark->bytes, benchmark->length, benchmark->string);
+}
+
+
+static void BMBase64BenchmarkDecode(void *context)
+{
+    BMBase64Benchmark *benchmark = (BMBase64Benchmark *)context;
+    size_t decodedLength;
+    BMBase64Decode(benchmark->string, benchmark->stringLength, benchmark->decoded, &decodedLength);
+}
+
+
+static void BMBase64BenchmarkDecodeTable(void *context)
+{
+    BMBase64Benchmark *benchmark = (BMBase64Benchmark *)context;
+    BMTableDecode(benchmark->string, benchmark->stringLength, benchmark->decoded);
+}
+
+
+int main(void)
+{
+    // Multiples of 3 bytes, so that the strings have no padding
+    static const size_t lengths[] = { 3 << 10, 3 << 14, 3 << 18, 3 << 24 };
+    
+    printf("%-12s %12s %12s %12s %12s\n", "Bytes", "Encode GB/s", "(table)", "Decode GB/s", "(table)");
+    for (size_t n = 0; n < sizeof(lengths) / sizeof(lengths[0]); ++n) {
+        BMBase64Benchmark benchmark;
+        benchmark.length = lengths[n];
+        benchmark.bytes = (uint8_t *)BMBenchmarkAllocate(benchmark.length);
+        benchmark.string = (char *)BMBenchmarkAllocate(BMBase64EncodedLength(benchmark.length));
+        benchmark.decoded = (uint8_t *)BMBenchmarkAllocate(BMBase64DecodedMaxLength(BMBase64EncodedLength(benchmark.length)));
+        BMBenchmarkFillRandom(benchmark.bytes, benchmark.length);
+        
+        // Both codecs must produce the same output
+        char *tableString = (char *)BMBenchmarkAllocate(BMBase64EncodedLength(benchmark.length));
+        size_t tableLength = BMTableEncode(benchmark.bytes, benchmark.length, tableString);
+        benchmark.stringLength = BMBase64Encode(benchmark.bytes, benchmark.length, benchmark.string);
+        BMBenchmarkCheck(benchmark.stringLength == tableLength && !memcmp(benchmark.string, tableString, tableLength), "encoded strings differ");
+        size_t decodedLength = 0;
+        BMBenchmarkCheck(BMBase64Decode(benchmark.string, benchmark.stringLength, benchmark.decoded, &decodedLength), "decoding failed");
+        BMBenchmarkCheck(decodedLength == benchmark.length && !memcmp(benchmark.decoded, benchmark.bytes, benchmark.length), "decoded bytes differ");
+        BMBenchmarkCheck(BMTableDecode(benchmark.string, benchmark.stringLength, benchmark.decoded) == benchmark.length && !memcmp(benchmark.decoded, benchmark.bytes, benchmark.length), "table decoded bytes differ");
+        free(tableString);
+        
+        // Throughput is given in bytes of binary data per second
+        printf("%-12zu %12.2f %12.2f %12.2f %12.2f\n",
+               benchmark.length,
+               BMBenchmarkMeasure(BMBase64BenchmarkEncode, &benchmark, benchmark.length),
+               BMBenchmarkMeasure(BMBase64BenchmarkEncodeTable, &benchmark, benchmark.length),
+               BMBenchmarkMeasure(BMBase64BenchmarkDecode, &benchmark, benchmark.length),
+               BMBenchmarkMeasure(BMBase64BenchmarkDecodeTable, &benchmark, benchmark.length));
+        
+        free(benchmark.decoded);
+        free(benchmark.string);
+        free(benchmark.bytes);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef __BMBENCHMARK__
+#define __BMBENCHMARK__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** The minimum time in seconds spent measuring a single function. */
+#define BMBenchmarkMinimumTime 0.5
+
+/** A function to measure, which processes the buffers described by _context_ once. */
+typedef void (*BMBenchmarkFunction)(void *context);
+
+/** Returns the current time of a monotonic clock in seconds. */
+static inline double BMBenchmarkGetTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/** Fills _length_ bytes at _bytes_ with reproducible pseudo random bytes. */
+static inline void BMBenchmarkFillRandom(void *bytes, size_t length)
+{
+    uint64_t x = UINT64_C(0x9e3779b97f4a7c15);
+    for (size_t i = 0; i < length; ++i) {
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+        ((uint8_t *)bytes)[i] = (uint8_t)(x >> 32);
+    }
+}
+
+/** Allocates _length_ bytes, and exits if memory cannot be allocated. */
+static inline void *BMBenchmarkAllocate(size_t length)
+{
+    void *bytes = malloc(length ? length : 1);
+    if (!bytes) {
+        fprintf(stderr, "Out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+    return bytes;
+}
+
+/** Runs _function_ repeatedly for at least `BMBenchmarkMinimumTime` seconds, and returns the best throughput in GB/s for processing _length_ bytes per run. */
+static inline double BMBenchmarkMeasure(BMBenchmarkFunction function, void *context, size_t length)
+{
+    double bestTime = 0.0, startTime = BMBenchmarkGetTime();
+    function(context); // Warm up the caches and fault in the pages
+    do {
+        double time = BMBenchmarkGetTime();
+        function(context);
+        time = BMBenchmarkGetTime() - time;
+        if (bestTime == 0.0 || time < bestTime) {
+            bestTime = time;
+        }
+    } while (BMBenchmarkGetTime() - startTime < BMBenchmarkMinimumTime);
+    return (bestTime > 0.0) ? length / bestTime * 1e-9 : 0.0;
+}
+
+/** Exits with an error message if _condition_ is false, which is used to check the results. */
+static inline void BMBenchmarkCheck(int condition, const char *message)
+{
+    if (!condition) {
+        fprintf(stderr, "Check failed: %s\n", message);
+        exit(EXIT_FAILURE);
+    }
+}
+
+#endif /* !__BMBENCHMARK__ */
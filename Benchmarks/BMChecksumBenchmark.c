@@ -0,0 +1,111 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Measures the throughput of the CRC-32C, xxHash64 and XXH3 checksums
+ * against the MD5 and SHA-1 message digests. Build and run it from the top
+ * level directory with
+ *
+ *   cc -O2 -std=gnu99 -IBMKit -o checksum-benchmark Benchmarks/BMChecksumBenchmark.c BMKit/BMChecksumUtilities.c BMKit/BMDigestUtilities.c BMKit/BMFileUtilities.c BMKit/BMHex.c -lpthread
+ *   ./checksum-benchmark
+ */
+
+#include "BMChecksumUtilities.h"
+#include "BMDigestUtilities.h"
+#include "BMBenchmark.h"
+
+
+typedef struct _BMChecksumBenchmark {
+    const uint8_t *bytes;
+    size_t         length;
+    int            algorithm;
+    uint64_t       checksum;
+    uint8_t        digest[BMDigestMaxLength];
+} BMChecksumBenchmark;
+
+
+static void BMChecksumBenchmarkChecksum(void *context)
+{
+    BMChecksumBenchmark *benchmark = (BMChecksumBenchmark *)context;
+    BMChecksumCompute((BMChecksumAlgorithm)benchmark->algorithm, 0, benchmark->bytes, benchmark->length, &benchmark->checksum);
+}
+
+
+static void BMChecksumBenchmarkDigest(void *context)
+{
+    BMChecksumBenchmark *benchmark = (BMChecksumBenchmark *)context;
+    BMDigestCompute((BMDigestAlgorithm)benchmark->algorithm, benchmark->bytes, benchmark->length, benchmark->digest);
+}
+
+
+int main(void)
+{
+    static const size_t lengths[] = { 64, 4 << 10, 1 << 20, 256 << 20 };
+    static const struct {
+        const char          *name;
+        BMBenchmarkFunction  function;
+        int                  algorithm;
+    } functions[] = {
+        { "CRC-32C", BMChecksumBenchmarkChecksum, BMChecksumAlgorithmCRC32C },
+        { "XXH64",   BMChecksumBenchmarkChecksum, BMChecksumAlgorithmXXH64  },
+        { "XXH3",    BMChecksumBenchmarkChecksum, BMChecksumAlgorithmXXH3   },
+        { "MD5",     BMChecksumBenchmarkDigest,   BMDigestAlgorithmMD5      },
+        { "SHA-1",   BMChecksumBenchmarkDigest,   BMDigestAlgorithmSHA1     }
+    };
+    
+    // Known answers, so that a fast but broken checksum does not go unnoticed
+    uint64_t checksum;
+    BMChecksumCompute(BMChecksumAlgorithmCRC32C, 0, "123456789", 9, &checksum);
+    BMBenchmarkCheck(checksum == UINT64_C(0xe3069283), "CRC-32C check value");
+    BMChecksumCompute(BMChecksumAlgorithmXXH64, 0, "", 0, &checksum);
+    BMBenchmarkCheck(checksum == UINT64_C(0xef46db3751d8e999), "XXH64 of the empty string");
+    BMChecksumCompute(BMChecksumAlgorithmXXH3, 0, "", 0, &checksum);
+    BMBenchmarkCheck(checksum == UINT64_C(0x2d06800538d394c2), "XXH3 of the empty string");
+    
+    printf("%-12s", "GB/s");
+    for (size_t f = 0; f < sizeof(functions) / sizeof(functions[0]); ++f) {
+        printf(" %10s", functions[f].name);
+    }
+    printf("\n");
+    for (size_t n = 0; n < sizeof(lengths) / sizeof(lengths[0]); ++n) {
+        uint8_t *bytes = (uint8_t *)BMBenchmarkAllocate(lengths[n]);
+        BMBenchmarkFillRandom(bytes, lengths[n]);
+        printf("%-12zu", lengths[n]);
+        for (size_t f = 0; f < sizeof(functions) / sizeof(functions[0]); ++f) {
+            BMChecksumBenchmark benchmark;
+            memset(&benchmark, 0, sizeof(benchmark));
+            benchmark.bytes = bytes;
+            benchmark.length = lengths[n];
+            benchmark.algorithm = functions[f].algorithm;
+            printf(" %10.3f", BMBenchmarkMeasure(functions[f].function, &benchmark, lengths[n]));
+            fflush(stdout);
+        }
+        printf("\n");
+        free(bytes);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Measures computing the MD5, SHA-1 and SHA-256 digests of the same bytes
+ * in a single pass with BMDigestComputeMultiple against three separate
+ * BMDigestCompute calls, and checks that both produce the same digests.
+ * Build and run it from the top level directory with
+ *
+ *   cc -O2 -std=gnu99 -IBMKit -o digest-benchmark Benchmarks/BMDigestBenchmark.c BMKit/BMDigestUtilities.c BMKit/BMFileUtilities.c BMKit/BMHex.c
+ *   ./digest-benchmark
+ *
+ * Add -DBMDIGEST_PORTABLE to measure the portable digests instead of
+ * CommonCrypto on Apple platforms.
+ */
+
+#include "BMDigestUtilities.h"
+#include "BMBenchmark.h"
+
+
+static const BMDigestAlgorithm BMDigestBenchmarkAlgorithms[] = {
+    BMDigestAlgorithmMD5,
+    BMDigestAlgorithmSHA1,
+    BMDigestAlgorithmSHA256
+};
+
+#define BMDigestBenchmarkAlgorithmCount (sizeof(BMDigestBenchmarkAlgorithms) / sizeof(BMDigestBenchmarkAlgorithms[0]))
+
+
+typedef struct _BMDigestBenchmark {
+    const uint8_t *bytes;
+    size_t         length;
+    uint8_t        digests[BMDigestBenchmarkAlgorithmCount][BMDigestMaxLength];
+} BMDigestBenchmark;
+
+
+static void BMDigestBenchmarkSeparate(void *context)
+{
+    BMDigestBenchmark *benchmark = (BMDigestBenchmark *)context;
+    for (size_t i = 0; i < BMDigestBenchmarkAlgorithmCount; ++i) {
+        BMDigestCompute(BMDigestBenchmarkAlgorithms[i], benchmark->bytes, benchmark->length, benchmark->digests[i]);
+    }
+}
+
+
+static void BMDigestBenchmarkMultiple(void *context)
+{
+    BMDigestBenchmark *benchmark = (BMDigestBenchmark *)context;
+    void *digests[BMDigestBenchmarkAlgorithmCount];
+    for (size_t i = 0; i < BMDigestBenchmarkAlgorithmCount; ++i) {
+        digests[i] = benchmark->digests[i];
+    }
+    BMDigestComputeMultiple(BMDigestBenchmarkAlgorithms, BMDigestBenchmarkAlgorithmCount, benchmark->bytes, benchmark->length, digests);
+}
+
+
+int main(void)
+{
+    // From cache resident to well beyond the last level cache
+    static const size_t lengths[] = { 64 << 10, 1 << 20, 256 << 20 };
+    
+    printf("%-12s %14s %14s %8s\n", "Bytes", "Separate GB/s", "Single GB/s", "Speedup");
+    for (size_t n = 0; n < sizeof(lengths) / sizeof(lengths[0]); ++n) {
+        uint8_t *bytes = (uint8_t *)BMBenchmarkAllocate(lengths[n]);
+        BMBenchmarkFillRandom(bytes, lengths[n]);
+        
+        // Both ways must produce the same digests
+        BMDigestBenchmark separate, multiple;
+        memset(&separate, 0, sizeof(separate));
+        memset(&multiple, 0xff, sizeof(multiple));
+        separate.bytes = multiple.bytes = bytes;
+        separate.length = multiple.length = lengths[n];
+        BMDigestBenchmarkSeparate(&separate);
+        BMDigestBenchmarkMultiple(&multiple);
+        for (size_t i = 0; i < BMDigestBenchmarkAlgorithmCount; ++i) {
+            BMBenchmarkCheck(!memcmp(separate.digests[i], multiple.digests[i], BMDigestGetLength(BMDigestBenchmarkAlgorithms[i])), "digests differ");
+        }
+        
+        // Throughput is given in bytes of input per second for all three digests
+        double separateThroughput = BMBenchmarkMeasure(BMDigestBenchmarkSeparate, &separate, lengths[n]);
+        double multipleThroughput = BMBenchmarkMeasure(BMDigestBenchmarkMultiple, &multiple, lengths[n]);
+        printf("%-12zu %14.3f %14.3f %7.2fx\n", lengths[n], separateThroughput, multipleThroughput, multipleThroughput / separateThroughput);
+        
+        free(bytes);
+    }
+    return EXIT_SUCCESS;
+}
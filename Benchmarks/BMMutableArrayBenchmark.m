@@ -0,0 +1,131 @@
+/*-
+ * Copyright (c) 2011, Benedikt Meurer <benedikt.meurer@googlemail.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Measures the in-place transforms of NSMutableArray (BMKitAdditions) on
+ * 1M objects: replacing one object at a time, as the transform did before,
+ * the bulk transform, and the concurrent transform. Checks that all three
+ * produce the same array. Build and run it from the top level directory on
+ * Mac OS X with
+ *
+ *   cc -O2 -IBMKit -framework Foundation -o mutable-array-benchmark Benchmarks/BMMutableArrayBenchmark.m BMKit/NSMutableArray+BMKitAdditions.m BMKit/BMCollectionUtilities.m
+ *   ./mutable-array-benchmark
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "NSMutableArray+BMKitAdditions.h"
+#import "BMBenchmark.h"
+
+
+typedef struct _BMMutableArrayBenchmark {
+    NSMutableArray  *array;
+    BMTransformator  transformator;
+} BMMutableArrayBenchmark;
+
+
+// The transform of -[NSMutableArray transformUsingTransformator:] before the bulk path
+static void BMMutableArrayBenchmarkTransformEach(void *context)
+{
+    BMMutableArrayBenchmark *benchmark = (BMMutableArrayBenchmark *)context;
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSUInteger numberOfObjects = [benchmark->array count];
+    for (NSUInteger i = 0; i < numberOfObjects; ++i) {
+        id object = benchmark->transformator([benchmark->array objectAtIndex:i]) ?: [NSNull null];
+        [benchmark->array replaceObjectAtIndex:i withObject:object];
+    }
+    [pool drain];
+}
+
+
+static void BMMutableArrayBenchmarkTransform(void *context)
+{
+    BMMutableArrayBenchmark *benchmark = (BMMutableArrayBenchmark *)context;
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    [benchmark->array transformUsingTransformator:benchmark->transformator];
+    [pool drain];
+}
+
+
+static void BMMutableArrayBenchmarkConcurrentTransform(void *context)
+{
+    BMMutableArrayBenchmark *benchmark = (BMMutableArrayBenchmark *)context;
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    [benchmark->array concurrentlyTransformUsingTransformator:benchmark->transformator];
+    [pool drain];
+}
+
+
+int main(void)
+{
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    static const NSUInteger count = 1000000;
+    static const struct {
+        const char          *name;
+        BMBenchmarkFunction  function;
+    } functions[] = {
+        { "replace each",      BMMutableArrayBenchmarkTransformEach       },
+        { "bulk",              BMMutableArrayBenchmarkTransform           },
+        { "bulk, concurrent",  BMMutableArrayBenchmarkConcurrentTransform }
+    };
+    static const size_t numberOfFunctions = sizeof(functions) / sizeof(functions[0]);
+    
+    NSMutableArray *objects = [[NSMutableArray alloc] initWithCapacity:count];
+    for (NSUInteger i = 0; i < count; ++i) {
+        [objects addObject:[NSNumber numberWithUnsignedInteger:i]];
+    }
+    BMMutableArrayBenchmark benchmark;
+    benchmark.transformator = ^id(id anObject) {
+        return [NSNumber numberWithUnsignedInteger:[anObject unsignedIntegerValue] + 1];
+    };
+    
+    // All transforms must produce the same array
+    NSMutableArray *expected = nil;
+    for (size_t f = 0; f < numberOfFunctions; ++f) {
+        benchmark.array = [objects mutableCopy];
+        functions[f].function(&benchmark);
+        if (expected) {
+            BMBenchmarkCheck([expected isEqualToArray:benchmark.array], "transformed arrays differ");
+            [benchmark.array release];
+        }
+        else {
+            expected = benchmark.array;
+        }
+    }
+    [expected release];
+    
+    // Throughput is given in millions of objects per second
+    printf("%-18s %10s\n", "Transform", "Mobj/s");
+    for (size_t f = 0; f < numberOfFunctions; ++f) {
+        benchmark.array = [objects mutableCopy];
+        printf("%-18s %10.2f\n", functions[f].name, BMBenchmarkMeasure(functions[f].function, &benchmark, count) * 1e3);
+        [benchmark.array release];
+    }
+    [objects release];
+    [pool drain];
+    return EXIT_SUCCESS;
+}